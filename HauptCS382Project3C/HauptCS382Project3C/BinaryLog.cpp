@@ -0,0 +1,440 @@
+/////////////////////////////////////////////////////////////////
+// Class implementation file: BinaryLog.cpp                    //
+//                                                             //
+// The log file is a sequence of tagged blocks after a magic   //
+// number: 'F' defines a format (number, line, file and format //
+// text, the lengths before the strings), 'C' pairs a raw      //
+// timestamp with the nanoseconds since the log started, and   //
+// 'R' holds one LogRecord.  A format's block always precedes  //
+// its first record, and a clock block is written with every   //
+// flush, so the decoder can turn timestamps into time.        //
+/////////////////////////////////////////////////////////////////
+
+#include "BinaryLog.h"
+#include <algorithm>
+#include <chrono>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+const unsigned int LOG_MAGIC = 0x474f4c46;	// "FLOG" //
+
+BinaryLog binaryLog;						// The program's one log. //
+thread_local LogRing *threadLogRing = NULL;
+
+std::chrono::steady_clock::time_point logEpoch = std::chrono::steady_clock::now();
+
+/////////////////////////////////////////////////////
+// Default constructor: Disabled, with no rings.   //
+/////////////////////////////////////////////////////
+BinaryLog::BinaryLog()
+{
+	enabled.store(false);
+	formatsWritten = 0;
+	nbrRings.store(0);
+	stopping = false;
+	file = NULL;
+}
+
+////////////////////////////////////////////////////////
+// Destructor: Flushes and closes the log, if open,   //
+// and frees the rings.                               //
+////////////////////////////////////////////////////////
+BinaryLog::~BinaryLog()
+{
+	stop();
+	for (int r = 0; r < nbrRings.load(); r++)
+		delete rings[r];
+}
+
+///////////////////////////////////////////////////////
+// Function to open "path" and start the flush       //
+// thread, returning false if the file cannot be     //
+// opened (or the log is already running).           //
+///////////////////////////////////////////////////////
+bool BinaryLog::start(const char *path)
+{
+	if (file != NULL)
+		return false;
+	file = fopen(path, "wb");
+	if (file == NULL)
+		return false;
+	fwrite(&LOG_MAGIC, sizeof(LOG_MAGIC), 1, file);
+	stopping = false;
+	flusher = std::thread([this]() { flushLoop(); });
+	enabled.store(true);
+	return true;
+}
+
+//////////////////////////////////////////////////////////
+// Function to stop logging: later calls are ignored,   //
+// and everything already logged is flushed and closed. //
+//////////////////////////////////////////////////////////
+void BinaryLog::stop()
+{
+	if (file == NULL)
+		return;
+	enabled.store(false);
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	wake.notify_one();
+	flusher.join();
+	fclose(file);
+	file = NULL;
+}
+
+////////////////////////////////////////////////////////////
+// Function to intern a call site's format, returning its //
+// number.  Each call site calls this only once.          //
+////////////////////////////////////////////////////////////
+int BinaryLog::registerFormat(const char *format, const char *file, int line)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	logFormat entry = { format, file, line };
+
+	formats.push_back(entry);
+	return int(formats.size()) - 1;
+}
+
+//////////////////////////////////////////////////////////
+// A thread's hold on its ring, which hands the ring    //
+// back to the log when the thread exits.               //
+//////////////////////////////////////////////////////////
+struct ringLease
+{
+	~ringLease()
+	{
+		if (threadLogRing != NULL)
+			binaryLog.releaseRing(threadLogRing);
+	}
+};
+
+//////////////////////////////////////////////////////////
+// Function to give the calling thread its ring on its  //
+// first log call: one an exited thread handed back, or //
+// else a new one.  NULL is returned, without locking   //
+// after the first time, to a thread that found every   //
+// ring in use.                                         //
+//////////////////////////////////////////////////////////
+LogRing *BinaryLog::threadRing()
+{
+	static thread_local bool refused = false;
+	static thread_local ringLease lease;
+	int count;
+
+	if (refused)
+		return NULL;
+	std::lock_guard<std::mutex> guard(lock);
+	count = nbrRings.load(std::memory_order_relaxed);
+	for (int r = 0; r < count; r++)
+		if (!rings[r]->owned.load(std::memory_order_relaxed))
+		{
+			threadLogRing = rings[r];
+			break;
+		}
+	if (threadLogRing == NULL)
+	{
+		if (count == MAX_LOG_THREADS)
+		{
+			refused = true;
+			return NULL;
+		}
+		threadLogRing = new LogRing;
+		threadLogRing->head.store(0);
+		threadLogRing->tail.store(0);
+		threadLogRing->dropped.store(0);
+		rings[count] = threadLogRing;
+		nbrRings.store(count + 1, std::memory_order_release);
+	}
+	threadLogRing->owned.store(true, std::memory_order_relaxed);
+	return threadLogRing;
+}
+
+//////////////////////////////////////////////////////////
+// Function to hand an exiting thread's ring back.  Its //
+// records stay for the flush thread to write; the next //
+// owner carries on after them.                         //
+//////////////////////////////////////////////////////////
+void BinaryLog::releaseRing(LogRing *ring)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	ring->owned.store(false, std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////
+// Function to count the records dropped so far    //
+// because a ring was full.                        //
+/////////////////////////////////////////////////////
+unsigned long BinaryLog::getDropped()
+{
+	unsigned long dropped = 0;
+
+	for (int r = 0; r < nbrRings.load(std::memory_order_acquire); r++)
+		dropped += rings[r]->dropped.load(std::memory_order_relaxed);
+	return dropped;
+}
+
+//////////////////////////////////////////////////////////
+// The flush thread: empties the rings every flush      //
+// period, and once more after being told to stop.      //
+//////////////////////////////////////////////////////////
+void BinaryLog::flushLoop()
+{
+	std::unique_lock<std::mutex> guard(lock);
+
+	for (;;)
+	{
+		bool last = wake.wait_for(guard, std::chrono::milliseconds(LOG_FLUSH_MS),
+								  [this]() { return stopping; });
+		guard.unlock();
+		flushOnce();
+		guard.lock();
+		if (last)
+			return;
+	}
+}
+
+////////////////////////////////////////////////////////////
+// Function to write the new formats, a clock pair, and   //
+// every record the rings hold to the file.  Records are  //
+// read up to the head seen on entry; later ones wait for //
+// the next flush.                                        //
+////////////////////////////////////////////////////////////
+void BinaryLog::flushOnce()
+{
+	std::vector<logFormat> newFormats;
+	unsigned long long clock[2];
+	char tag;
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		newFormats.assign(formats.begin() + formatsWritten, formats.end());
+		formatsWritten = int(formats.size());
+	}
+	for (int f = 0; f < int(newFormats.size()); f++)
+	{
+		int header[4] = { formatsWritten - int(newFormats.size()) + f, newFormats[f].line,
+						  int(strlen(newFormats[f].file)), int(strlen(newFormats[f].format)) };
+		tag = 'F';
+		fwrite(&tag, 1, 1, file);
+		fwrite(header, sizeof(header), 1, file);
+		fwrite(newFormats[f].file, 1, header[2], file);
+		fwrite(newFormats[f].format, 1, header[3], file);
+	}
+
+	tag = 'C';
+	clock[0] = LogTimestamp();
+	clock[1] = (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+								std::chrono::steady_clock::now() - logEpoch).count();
+	fwrite(&tag, 1, 1, file);
+	fwrite(clock, sizeof(clock), 1, file);
+
+	tag = 'R';
+	for (int r = 0; r < nbrRings.load(std::memory_order_acquire); r++)
+	{
+		LogRing *ring = rings[r];
+		unsigned int tail = ring->tail.load(std::memory_order_relaxed);
+		unsigned int head = ring->head.load(std::memory_order_acquire);
+		for ( ; tail != head; tail++)
+		{
+			LogRecord record = ring->records[tail % LOG_RING_RECORDS];
+			record.thread = r;
+			fwrite(&tag, 1, 1, file);
+			fwrite(&record, sizeof(record), 1, file);
+		}
+		ring->tail.store(tail, std::memory_order_release);
+	}
+	fflush(file);
+}
+
+
+/* Function to read the cheapest clock available: the time-stamp  */
+/* counter on x86, otherwise nanoseconds of the steady clock.     */
+unsigned long long LogTimestamp()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+								std::chrono::steady_clock::now() - logEpoch).count();
+#endif
+}
+
+
+/* Function to print one record's format with its arguments.  */
+/* Each conversion takes the next argument; its flags, width  */
+/* and precision are kept, and the length modifier that suits */
+/* the stored type is supplied.                               */
+static void PrintLogRecord(FILE *out, const std::string &format, const LogRecord &record)
+{
+	int arg = 0;
+
+	for (size_t i = 0; i < format.size(); i++)
+	{
+		if (format[i] != '%')
+		{
+			fputc(format[i], out);
+			continue;
+		}
+		size_t end = format.find_first_of("diouxXcfFeEgGaA%", i + 1);
+		if (end == std::string::npos)
+		{
+			fputs(format.c_str() + i, out);
+			return;
+		}
+		if (format[end] == '%')
+			fputc('%', out);
+		else if (arg >= record.nbrArgs)
+			fputs("<missing>", out);
+		else
+		{
+			std::string spec = format.substr(i, end - i);
+			if (record.doubles & (1 << arg))
+			{
+				double value;
+				memcpy(&value, &record.args[arg], sizeof(value));
+				spec += (strchr("fFeEgGaA", format[end]) != NULL) ? format[end] : 'g';
+				fprintf(out, spec.c_str(), value);
+			}
+			else
+			{
+				spec += "ll";
+				spec += (strchr("fFeEgGaA", format[end]) != NULL) ? 'd' : format[end];
+				fprintf(out, spec.c_str(), record.args[arg]);
+			}
+			arg++;
+		}
+		i = end;
+	}
+}
+
+
+/* Offline decoder: prints each record of a log file as      */
+/* "microseconds thread file:line text", in time order, and  */
+/* returns the number of records (or -1 if the file is not   */
+/* a readable log). Timestamps become time through the first */
+/* and last clock pairs in the file.                         */
+int DecodeBinaryLog(const char *path, FILE *out)
+{
+	FILE *in = fopen(path, "rb");
+	std::vector<std::string> formatText, formatSite;
+	std::vector<LogRecord> records;
+	unsigned long long firstClock[2] = { 0, 0 }, lastClock[2] = { 0, 0 };
+	bool sawClock = false;
+	unsigned int magic = 0;
+	char tag;
+
+	if (in == NULL)
+		return -1;
+	if ( (fread(&magic, sizeof(magic), 1, in) != 1) || (magic != LOG_MAGIC) )
+	{
+		fclose(in);
+		return -1;
+	}
+
+	while (fread(&tag, 1, 1, in) == 1)
+	{
+		if (tag == 'F')
+		{
+			int header[4];
+			char site[64];
+			if (fread(header, sizeof(header), 1, in) != 1)
+				break;
+			std::string fileName(header[2], ' '), text(header[3], ' ');
+			if ( (header[2] > 0) && (fread(&fileName[0], 1, header[2], in) != size_t(header[2])) )
+				break;
+			if ( (header[3] > 0) && (fread(&text[0], 1, header[3], in) != size_t(header[3])) )
+				break;
+			if (int(formatText.size()) <= header[0])
+			{
+				formatText.resize(header[0] + 1);
+				formatSite.resize(header[0] + 1);
+			}
+			snprintf(site, sizeof(site), ":%d", header[1]);
+			formatText[header[0]] = text;
+			formatSite[header[0]] = fileName.substr(fileName.find_last_of("/\\") + 1) + site;
+		}
+		else if (tag == 'C')
+		{
+			unsigned long long clock[2];
+			if (fread(clock, sizeof(clock), 1, in) != 1)
+				break;
+			if (!sawClock)
+				memcpy(firstClock, clock, sizeof(clock));
+			memcpy(lastClock, clock, sizeof(clock));
+			sawClock = true;
+		}
+		else if (tag == 'R')
+		{
+			LogRecord record;
+			if (fread(&record, sizeof(record), 1, in) != 1)
+				break;
+			records.push_back(record);
+		}
+		else
+			break;
+	}
+	fclose(in);
+
+	// Each flush writes the rings one after another; restore time order. //
+	std::stable_sort(records.begin(), records.end(), [](const LogRecord &a, const LogRecord &b)
+	{
+		return a.timestamp < b.timestamp;
+	});
+	double nsPerTick = (lastClock[0] > firstClock[0])
+						? double(lastClock[1] - firstClock[1]) / double(lastClock[0] - firstClock[0]) : 1.0;
+	for (int r = 0; r < int(records.size()); r++)
+	{
+		const LogRecord &record = records[r];
+		double us = (double(record.timestamp) - double(firstClock[0])) * nsPerTick / 1000.0 + firstClock[1] / 1000.0;
+		if (record.format >= formatText.size())
+			continue;
+		fprintf(out, "%12.1f us  t%-2u %-24s ", us, record.thread, formatSite[record.format].c_str());
+		PrintLogRecord(out, formatText[record.format], record);
+		fputc('\n', out);
+	}
+	return int(records.size());
+}
+
+
+/* Benchmark: the mean cost, in nanoseconds, of reading the */
+/* log's clock alone, which a LOG_EVENT call does once.     */
+double BenchmarkLogTimestamp(long nbrReads)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	volatile unsigned long long sink = 0;
+
+	for (long i = 0; i < nbrReads; i++)
+		sink = sink + LogTimestamp();
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / nbrReads;
+}
+
+
+/* Benchmark: the mean cost, in nanoseconds, of a LOG_EVENT */
+/* call with two arguments that is actually recorded. Calls */
+/* are timed in bursts that fit the ring, and the flush     */
+/* thread is let empty the ring between bursts, so no call  */
+/* takes the cheaper drop path. The log must be running.    */
+double BenchmarkBinaryLog(long nbrCalls)
+{
+	double totalNs = 0.0;
+	long i = 0;
+
+	while (i < nbrCalls)
+	{
+		long burstEnd = (nbrCalls - i < LOG_RING_RECORDS) ? nbrCalls : i + LOG_RING_RECORDS;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for ( ; i < burstEnd; i++)
+			LOG_EVENT("bench call %d of %.1f", i, 0.5 * i);
+		totalNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+		while ( (threadLogRing != NULL) &&
+				(threadLogRing->tail.load() != threadLogRing->head.load(std::memory_order_relaxed)) )
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return totalNs / nbrCalls;
+}
@@ -0,0 +1,201 @@
+/////////////////////////////////////////////////////////////////
+// Class definition file: BinaryLog.h                          //
+//                                                             //
+// This file defines the binary logger.  A LOG_EVENT call      //
+// stores no text: its format string is interned once, the     //
+// first time the call site runs, and every later call writes  //
+// only the format's number, a timestamp and up to four        //
+// numeric arguments into a fixed-size record in the calling   //
+// thread's own ring.  Each ring has one writer (its thread)   //
+// and one reader (the flush thread), so neither side locks;   //
+// a full ring drops the record and counts it rather than      //
+// waiting.  The flush thread empties the rings into the log   //
+// file a few times a second, and -decodelog turns the file    //
+// back into text offline.                                     //
+//                                                             //
+// Arguments may be any integer type or floating-point type.   //
+// Their format specifiers are printf's, without length        //
+// modifiers ("%d", "%x", "%.3f" and the like).                //
+/////////////////////////////////////////////////////////////////
+
+#ifndef BINARY_LOG_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+const int MAX_LOG_ARGS		= 4;		// Arguments Per Record   //
+const int LOG_RING_RECORDS	= 4096;		// Records Per Thread     //
+const int MAX_LOG_THREADS	= 64;		// Rings In All           //
+const int LOG_FLUSH_MS		= 50;		// Flush Thread Period    //
+
+//////////////////////////////////////////////////////////
+// One logged event.  Bit i of "doubles" marks argument //
+// i as a double; the others are 64-bit integers.       //
+//////////////////////////////////////////////////////////
+struct LogRecord
+{
+	unsigned long long timestamp;
+	unsigned short format;
+	unsigned char nbrArgs;
+	unsigned char doubles;
+	unsigned int thread;		// Filled in by the flush thread. //
+	long long args[MAX_LOG_ARGS];
+};
+
+////////////////////////////////////////////////////
+// A thread's ring: the owner advances head, the  //
+// flush thread advances tail.  A ring is handed  //
+// back when its thread exits, for the next new   //
+// thread to take over.                           //
+////////////////////////////////////////////////////
+struct LogRing
+{
+	LogRecord records[LOG_RING_RECORDS];
+	std::atomic<unsigned int> head;
+	std::atomic<unsigned int> tail;
+	std::atomic<unsigned long> dropped;
+	std::atomic<bool> owned;
+};
+
+///////////////////////////////////////////////
+// DECLARATION SECTION FOR BINARY LOG CLASS  //
+///////////////////////////////////////////////
+
+class BinaryLog
+{
+	public:
+		// Class constructor and destructor
+		BinaryLog();
+		~BinaryLog();
+
+		// Member functions
+		bool start(const char *path);
+		void stop();
+		bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+		int registerFormat(const char *format, const char *file, int line);
+		LogRing *threadRing();
+		void releaseRing(LogRing *ring);
+		unsigned long getDropped();
+
+	protected:
+		// Data members
+
+		struct logFormat
+		{
+			const char *format;
+			const char *file;
+			int line;
+		};
+
+		std::atomic<bool> enabled;
+		std::vector<logFormat> formats;
+		int formatsWritten;
+		LogRing *rings[MAX_LOG_THREADS];
+		std::atomic<int> nbrRings;
+		std::mutex lock;				// Guards formats and ring creation. //
+		std::condition_variable wake;
+		std::thread flusher;
+		bool stopping;
+		FILE *file;
+
+		// Member functions
+		void flushLoop();
+		void flushOnce();
+
+	private:
+		// The log owns a thread and a file, so it is never copied.
+		BinaryLog(const BinaryLog &log);
+};
+
+extern BinaryLog binaryLog;
+extern thread_local LogRing *threadLogRing;	// NULL until the thread first logs. //
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+unsigned long long LogTimestamp();
+int DecodeBinaryLog(const char *path, FILE *out);
+double BenchmarkBinaryLog(long nbrCalls);
+double BenchmarkLogTimestamp(long nbrReads);
+
+///////////////////////////////////////////////////////////////
+// IMPLEMENTATION SECTION FOR THE LOGGING FUNCTION TEMPLATES //
+///////////////////////////////////////////////////////////////
+
+// Each argument goes into a 64-bit slot, flagged if it is a double. //
+template <class T>
+inline void StoreLogArg(LogRecord &record, int slot, T value)
+{
+	if (std::is_floating_point<T>::value)
+	{
+		double asDouble = double(value);
+		record.doubles |= (unsigned char)(1 << slot);
+		memcpy(&record.args[slot], &asDouble, sizeof(asDouble));
+	}
+	else
+		record.args[slot] = (long long)value;
+}
+
+inline void StoreLogArgs(LogRecord &record, int slot)
+{
+	record.nbrArgs = (unsigned char)slot;
+}
+
+template <class T, class... Rest>
+inline void StoreLogArgs(LogRecord &record, int slot, T value, Rest... rest)
+{
+	StoreLogArg(record, slot, value);
+	StoreLogArgs(record, slot + 1, rest...);
+}
+
+// Appends one record to the calling thread's ring, or counts a drop. //
+template <class... Args>
+inline void LogEvent(int format, const char *, Args... args)
+{
+	static_assert(sizeof...(Args) <= MAX_LOG_ARGS, "Too many arguments for one log record");
+	LogRing *ring = (threadLogRing != NULL) ? threadLogRing : binaryLog.threadRing();
+	unsigned int head;
+
+	if (ring == NULL)
+		return;
+	head = ring->head.load(std::memory_order_relaxed);
+	if (head - ring->tail.load(std::memory_order_acquire) >= (unsigned int)LOG_RING_RECORDS)
+	{
+		ring->dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	LogRecord &record = ring->records[head % LOG_RING_RECORDS];
+	record.timestamp = LogTimestamp();
+	record.format = (unsigned short)format;
+	record.doubles = 0;
+	StoreLogArgs(record, 0, args...);
+	ring->head.store(head + 1, std::memory_order_release);
+}
+
+template <class... Args>
+inline const char *LogFormatOf(const char *format, Args...)
+{
+	return format;
+}
+
+// The format is interned by the call site's static, once. //
+#define LOG_EVENT(...)																	\
+	do																					\
+	{																					\
+		if (binaryLog.isEnabled())														\
+		{																				\
+			static const int logFormatId =												\
+				binaryLog.registerFormat(LogFormatOf(__VA_ARGS__), __FILE__, __LINE__);	\
+			LogEvent(logFormatId, __VA_ARGS__);											\
+		}																				\
+	} while (0)
+
+#define BINARY_LOG_H
+#endif
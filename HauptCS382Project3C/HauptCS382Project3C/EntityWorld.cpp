@@ -0,0 +1,741 @@
+/////////////////////////////////////////////////////////////////
+// Class implementation file: EntityWorld.cpp                  //
+//                                                             //
+// Every component is plain data, so columns are raw bytes,    //
+// grown by doubling and moved with memcpy; a column's bytes   //
+// are counted against the archetype's memory tag for as long  //
+// as it is allocated.  Ripples keep their rows oldest first   //
+// and ships keep theirs in the order they were added; the     //
+// engines take the ripples newest first, as the lists the     //
+// world replaced kept them, so a world ticks exactly as those //
+// lists did.                                                  //
+/////////////////////////////////////////////////////////////////
+
+#include "EntityWorld.h"
+#include "WorkerPool.h"
+#include "Telemetry.h"
+#include "BinaryLog.h"
+#include <cstring>
+#include <algorithm>
+using namespace std;
+
+// Bytes per component, by kind. //
+static const int COMPONENT_SIZES[NBR_COMPONENT_KINDS] = { sizeof(Position), sizeof(Heading), sizeof(Hue),
+														  sizeof(Sleep), sizeof(Trail), sizeof(Radius),
+														  sizeof(Mask), sizeof(Hunter) };
+
+/* System recording each trailed ship's position before it is displaced. */
+static void RecordTrails(Archetype &archetype, int begin, int end, TickContext &/* tick */)
+{
+	Position *position = archetype.column<Position>();
+	Trail *trail = archetype.column<Trail>();
+
+	for (int i = begin; i < end; i++)
+	{
+		trail[i].pos[trail[i].next][0] = position[i].pos[0];
+		trail[i].pos[trail[i].next][1] = position[i].pos[1];
+		trail[i].next = (trail[i].next + 1) % TRAIL_LENGTH;
+		if (trail[i].count < TRAIL_LENGTH)
+			trail[i].count++;
+	}
+}
+
+/* System expanding every ripple by one increment. */
+static void ExpandRadii(Archetype &archetype, int begin, int end, TickContext &/* tick */)
+{
+	Radius *radius = archetype.column<Radius>();
+
+	for (int i = begin; i < end; i++)
+		radius[i].rad += RADIUS_INCREMENT;
+}
+
+/* System bringing every ship that left a wrapping world back in. */
+static void WrapShipRows(Archetype &archetype, int begin, int end, TickContext &tick)
+{
+	Position *position = archetype.column<Position>();
+
+	for (int i = begin; i < end; i++)
+		WrapPosition(position[i].pos, tick.bounds);
+}
+
+////////////////////////////////////////////////////////
+// The systems run before the ships are displaced, in //
+// this order (as far as their conflicts require).    //
+////////////////////////////////////////////////////////
+const EntitySystem WORLD_SYSTEMS[] = { { "trail",	(1 << positionComponent) | (1 << trailComponent),
+										 (1 << positionComponent), (1 << trailComponent),	RecordTrails,	NULL },
+									   { "expand",	(1 << radiusComponent),
+										 0, (1 << radiusComponent),							ExpandRadii,	NULL } };
+const int NBR_WORLD_SYSTEMS = sizeof(WORLD_SYSTEMS) / sizeof(WORLD_SYSTEMS[0]);
+
+// Run after the engine on a torus. //
+static const EntitySystem WRAP_SYSTEM = { "wrap", SHIP_COMPONENTS, (1 << positionComponent),
+										  (1 << positionComponent), WrapShipRows, NULL };
+
+/////////////////////////////////////////////////
+// IMPLEMENTATION SECTION FOR ARCHETYPE CLASS  //
+/////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////
+// Constructor: An empty table with a column for every //
+// component in "components", counted under "tag".     //
+/////////////////////////////////////////////////////////
+Archetype::Archetype(componentSet components, memoryTag tag)
+{
+	this->components = components;
+	this->tag = tag;
+	size = capacity = 0;
+	for (int k = 0; k < NBR_COMPONENT_KINDS; k++)
+		columns[k] = NULL;
+}
+
+//////////////////////////////////////
+// Destructor: Frees every column.  //
+//////////////////////////////////////
+Archetype::~Archetype()
+{
+	for (int k = 0; k < NBR_COMPONENT_KINDS; k++)
+		delete [] columns[k];
+	CountRelease(tag, size_t(capacity) * getRowBytes());
+}
+
+////////////////////////////////////////////////////
+// Functions to report the archetype's components, //
+// whether it holds ripples or ships, its number   //
+// of rows, and the bytes each row takes.          //
+////////////////////////////////////////////////////
+componentSet Archetype::getComponents()
+{
+	return components;
+}
+
+bool Archetype::isRipple()
+{
+	return (components == RIPPLE_COMPONENTS);
+}
+
+bool Archetype::isShip()
+{
+	return ( (components & SHIP_COMPONENTS) == SHIP_COMPONENTS );
+}
+
+int Archetype::getSize()
+{
+	return size;
+}
+
+int Archetype::getRowBytes()
+{
+	int bytes = 0;
+	for (int k = 0; k < NBR_COMPONENT_KINDS; k++)
+		if (components & ComponentBit(componentKind(k)))
+			bytes += COMPONENT_SIZES[k];
+	return bytes;
+}
+
+//////////////////////////////////////////////////////////
+// Function to add a zeroed row, returning its index.   //
+//////////////////////////////////////////////////////////
+int Archetype::append()
+{
+	return appendRows(1);
+}
+
+//////////////////////////////////////////////////////////
+// Function to add "count" zeroed rows at once (growing //
+// the columns no more than once), returning the index  //
+// of the first.                                        //
+//////////////////////////////////////////////////////////
+int Archetype::appendRows(int count)
+{
+	int first = size;
+
+	if (size + count > capacity)
+		reserve( max(size + count, (capacity < MIN_ARCHETYPE_ROWS) ? MIN_ARCHETYPE_ROWS : 2 * capacity) );
+	for (int k = 0; k < NBR_COMPONENT_KINDS; k++)
+		if (columns[k] != NULL)
+			memset(columns[k] + size_t(size) * COMPONENT_SIZES[k], 0, size_t(count) * COMPONENT_SIZES[k]);
+	size += count;
+	return first;
+}
+
+//////////////////////////////////////////////////////////
+// Function to drop the first "count" rows, keeping the //
+// order of the rest.                                   //
+//////////////////////////////////////////////////////////
+void Archetype::eraseFront(int count)
+{
+	if (count <= 0)
+		return;
+	if (count > size)
+		count = size;
+	for (int k = 0; k < NBR_COMPONENT_KINDS; k++)
+		if (columns[k] != NULL)
+			memmove(columns[k], columns[k] + size_t(count) * COMPONENT_SIZES[k],
+					size_t(size - count) * COMPONENT_SIZES[k]);
+	size -= count;
+}
+
+////////////////////////////////////////////////////////
+// Functions to drop every row, and to give back the  //
+// capacity the rows no longer need.                  //
+////////////////////////////////////////////////////////
+void Archetype::clear()
+{
+	size = 0;
+}
+
+void Archetype::shrink()
+{
+	reserve( (size < MIN_ARCHETYPE_ROWS) ? MIN_ARCHETYPE_ROWS : size );
+}
+
+///////////////////////////////////////////////////////
+// Functions to read and write a row as a whole ship //
+// (the row's other components are left alone).      //
+///////////////////////////////////////////////////////
+Ship Archetype::getShip(int row)
+{
+	Ship shp;
+
+	shp.pos[0] = column<Position>()[row].pos[0];
+	shp.pos[1] = column<Position>()[row].pos[1];
+	shp.delta[0] = column<Heading>()[row].delta[0];
+	shp.delta[1] = column<Heading>()[row].delta[1];
+	shp.clr = column<Hue>()[row].clr;
+	shp.idle = column<Sleep>()[row].idle;
+	return shp;
+}
+
+void Archetype::setShip(int row, const Ship &shp)
+{
+	column<Position>()[row].pos[0] = shp.pos[0];
+	column<Position>()[row].pos[1] = shp.pos[1];
+	column<Heading>()[row].delta[0] = shp.delta[0];
+	column<Heading>()[row].delta[1] = shp.delta[1];
+	column<Hue>()[row].clr = shp.clr;
+	column<Sleep>()[row].idle = shp.idle;
+}
+
+///////////////////////////////////////////////////////
+// Functions to read and write a row as a ripple.    //
+///////////////////////////////////////////////////////
+Ripple Archetype::getRipple(int row)
+{
+	Ripple cir;
+
+	cir.pos[0] = column<Position>()[row].pos[0];
+	cir.pos[1] = column<Position>()[row].pos[1];
+	cir.rad = column<Radius>()[row].rad;
+	cir.clr = column<Hue>()[row].clr;
+	cir.mask = column<Mask>()[row].mask;
+	return cir;
+}
+
+void Archetype::setRipple(int row, const Ripple &cir)
+{
+	column<Position>()[row].pos[0] = cir.pos[0];
+	column<Position>()[row].pos[1] = cir.pos[1];
+	column<Radius>()[row].rad = cir.rad;
+	column<Hue>()[row].clr = cir.clr;
+	column<Mask>()[row].mask = cir.mask;
+}
+
+//////////////////////////////////////////////////////////
+// Function to move every column to a capacity of       //
+// "rows" (never less than the rows in use).            //
+//////////////////////////////////////////////////////////
+void Archetype::reserve(int rows)
+{
+	if ( (rows < size) || (rows == capacity) )
+		return;
+	for (int k = 0; k < NBR_COMPONENT_KINDS; k++)
+		if (components & ComponentBit(componentKind(k)))
+		{
+			unsigned char *grown = new unsigned char[size_t(rows) * COMPONENT_SIZES[k]];
+			if (columns[k] != NULL)
+				memcpy(grown, columns[k], size_t(size) * COMPONENT_SIZES[k]);
+			delete [] columns[k];
+			columns[k] = grown;
+		}
+	CountRelease(tag, size_t(capacity) * getRowBytes());
+	CountAllocation(tag, size_t(rows) * getRowBytes());
+	capacity = rows;
+}
+
+//////////////////////////////////////////////
+// Function to copy one row over another.   //
+//////////////////////////////////////////////
+void Archetype::moveRow(int from, int to)
+{
+	for (int k = 0; k < NBR_COMPONENT_KINDS; k++)
+		if (columns[k] != NULL)
+			memcpy(columns[k] + size_t(to) * COMPONENT_SIZES[k],
+				   columns[k] + size_t(from) * COMPONENT_SIZES[k], COMPONENT_SIZES[k]);
+}
+
+////////////////////////////////////////////////////
+// IMPLEMENTATION SECTION FOR ENTITY WORLD CLASS  //
+////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////
+// Default constructor: No ships, and an empty ripple  //
+// archetype in the first slot.                        //
+/////////////////////////////////////////////////////////
+EntityWorld::EntityWorld()
+{
+	archetypes.push_back(new Archetype(RIPPLE_COMPONENTS, rippleMemory));
+}
+
+//////////////////////////////////////////
+// Destructor: Frees every archetype.   //
+//////////////////////////////////////////
+EntityWorld::~EntityWorld()
+{
+	for (int a = 0; a < int(archetypes.size()); a++)
+		delete archetypes[a];
+}
+
+//////////////////////////////////////////////////////////
+// Function to find the archetype of exactly the given  //
+// components, creating it if there is none yet.        //
+//////////////////////////////////////////////////////////
+Archetype &EntityWorld::archetypeFor(componentSet components)
+{
+	for (int a = 0; a < int(archetypes.size()); a++)
+		if (archetypes[a]->getComponents() == components)
+			return *archetypes[a];
+	archetypes.push_back(new Archetype(components, (components == RIPPLE_COMPONENTS) ? rippleMemory : shipMemory));
+	return *archetypes.back();
+}
+
+/////////////////////////////////////////////////
+// Functions to count and reach the archetypes. //
+/////////////////////////////////////////////////
+int EntityWorld::getArchetypeCount()
+{
+	return int(archetypes.size());
+}
+
+Archetype &EntityWorld::getArchetype(int index)
+{
+	return *archetypes[index];
+}
+
+//////////////////////////////////////////////////////////
+// Function to add a ship carrying the "extras" besides //
+// the components every ship has (zeroed to start).     //
+//////////////////////////////////////////////////////////
+void EntityWorld::addShip(const Ship &shp, componentSet extras)
+{
+	Archetype &archetype = archetypeFor(SHIP_COMPONENTS | extras);
+	archetype.setShip(archetype.append(), shp);
+}
+
+////////////////////////////////////////////////
+// Function to add a ripple, as the newest.   //
+////////////////////////////////////////////////
+void EntityWorld::addRipple(const Ripple &cir)
+{
+	Archetype &ripples = *archetypes[0];
+	ripples.setRipple(ripples.append(), cir);
+}
+
+//////////////////////////////////////////////////////////
+// Function to add every queued ripple, oldest first,   //
+// returning how many there were.                       //
+//////////////////////////////////////////////////////////
+int EntityWorld::drainRipples(LockFreeStack<Ripple> &queue)
+{
+	LinkedList<Ripple> fresh;
+	vector<Ripple> newestFirst;
+	int count = queue.drainInto(fresh);
+
+	newestFirst.reserve(count);
+	fresh.visit([&newestFirst](Ripple &cir) { newestFirst.push_back(cir); });
+	for (int i = count - 1; i >= 0; i--)
+		addRipple(newestFirst[i]);
+	return count;
+}
+
+/////////////////////////////////////////////////////////
+// Function to drop the ripples that have reached      //
+// their final radius, returning how many there were.  //
+/////////////////////////////////////////////////////////
+int EntityWorld::expireRipples()
+{
+	Archetype &ripples = *archetypes[0];
+	Radius *radius = ripples.column<Radius>();
+
+	return ripples.retain([radius](int row) { return (radius[row].rad < FINAL_RADIUS); });
+}
+
+//////////////////////////////////////////////////////////
+// Function to shed the oldest ripples while the        //
+// ripples are over their memory budget, keeping only   //
+// as many as the budget holds and giving back the rest //
+// of their columns. The number dropped is returned.    //
+//////////////////////////////////////////////////////////
+int EntityWorld::enforceRippleBudget()
+{
+	Archetype &ripples = *archetypes[0];
+	long long nbrKept;
+
+	if (!IsOverBudget(rippleMemory))
+		return 0;
+	nbrKept = GetMemoryBudget(rippleMemory) / ripples.getRowBytes();
+	if (nbrKept >= ripples.getSize())
+		return 0;
+	return shedRipples(int(nbrKept));
+}
+
+//////////////////////////////////////////////////////////
+// Function to shed the oldest ripples while this       //
+// world's own ripples take more than "budgetBytes"     //
+// (zero: no budget), whatever other worlds hold, as    //
+// above. The number dropped is returned.               //
+//////////////////////////////////////////////////////////
+int EntityWorld::enforceRippleBudget(long long budgetBytes)
+{
+	Archetype &ripples = *archetypes[0];
+	long long nbrKept;
+
+	if (budgetBytes <= 0)
+		return 0;
+	nbrKept = budgetBytes / ripples.getRowBytes();
+	if (nbrKept >= ripples.getSize())
+		return 0;
+	return shedRipples(int(nbrKept));
+}
+
+//////////////////////////////////////////////////////////
+// Function to drop all but the newest "nbrKept"        //
+// ripples and give back the columns' spare capacity,   //
+// returning how many were dropped.                     //
+//////////////////////////////////////////////////////////
+int EntityWorld::shedRipples(int nbrKept)
+{
+	Archetype &ripples = *archetypes[0];
+	int nbrRipples = ripples.getSize();
+
+	ripples.eraseFront(nbrRipples - nbrKept);
+	ripples.shrink();
+	LOG_EVENT("ripple budget: shed %d, kept %d", nbrRipples - nbrKept, nbrKept);
+	return nbrRipples - nbrKept;
+}
+
+/////////////////////////////////////////////////
+// Functions to count the ships and ripples.   //
+/////////////////////////////////////////////////
+int EntityWorld::getShipCount()
+{
+	int count = 0;
+	for (int a = 1; a < int(archetypes.size()); a++)
+		if (archetypes[a]->isShip())
+			count += archetypes[a]->getSize();
+	return count;
+}
+
+int EntityWorld::getRippleCount()
+{
+	return archetypes[0]->getSize();
+}
+
+//////////////////////////////////////////////////////////
+// Function to append every ship to a list, archetype   //
+// by archetype, for importShips to read back in the    //
+// same order.                                          //
+//////////////////////////////////////////////////////////
+void EntityWorld::exportShips(LinkedList<Ship> &shipList)
+{
+	for (int a = 1; a < int(archetypes.size()); a++)
+		for (int row = 0; archetypes[a]->isShip() && (row < archetypes[a]->getSize()); row++)
+		{
+			shipList.insert( archetypes[a]->getShip(row) );
+			++shipList;
+		}
+}
+
+//////////////////////////////////////////////////////////
+// Function to append every ripple to a list, newest    //
+// first, as the simulation keeps them.                 //
+//////////////////////////////////////////////////////////
+void EntityWorld::exportRipples(LinkedList<Ripple> &circleList)
+{
+	Archetype &ripples = *archetypes[0];
+
+	for (int row = ripples.getSize() - 1; row >= 0; row--)
+	{
+		circleList.insert( ripples.getRipple(row) );
+		++circleList;
+	}
+}
+
+//////////////////////////////////////////////////////////
+// Function to read the ships back from a list left in  //
+// exportShips' order, emptying the list.               //
+//////////////////////////////////////////////////////////
+void EntityWorld::importShips(LinkedList<Ship> &shipList)
+{
+	for (int a = 1; a < int(archetypes.size()); a++)
+		for (int row = 0; archetypes[a]->isShip() && (row < archetypes[a]->getSize()) && !shipList.isEmpty(); row++)
+		{
+			archetypes[a]->setShip(row, shipList.getHeadValue());
+			shipList.removeHead();
+		}
+}
+
+//////////////////////////////////////////////////////////
+// Function to replace every ripple with those of a     //
+// list (newest first), emptying the list.              //
+//////////////////////////////////////////////////////////
+void EntityWorld::importRipples(LinkedList<Ripple> &circleList)
+{
+	vector<Ripple> newestFirst;
+
+	newestFirst.reserve(circleList.getSize());
+	while (!circleList.isEmpty())
+	{
+		newestFirst.push_back( circleList.getHeadValue() );
+		circleList.removeHead();
+	}
+	archetypes[0]->clear();
+	for (int i = int(newestFirst.size()) - 1; i >= 0; i--)
+		addRipple(newestFirst[i]);
+}
+
+/////////////////////////////////////////
+// Function to remove every ship.      //
+/////////////////////////////////////////
+void EntityWorld::clearShips()
+{
+	for (int a = 1; a < int(archetypes.size()); a++)
+		if (archetypes[a]->isShip())
+			archetypes[a]->clear();
+}
+
+/////////////////////////////////////////
+// Function to remove every ripple.    //
+/////////////////////////////////////////
+void EntityWorld::clearRipples()
+{
+	archetypes[0]->clear();
+}
+
+////////////////////////////////////////////////////
+// IMPLEMENTATION SECTION FOR TICK CONTEXT CLASS  //
+////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////
+// Constructor: No ripples, ships or scratch.    //
+///////////////////////////////////////////////////
+TickContext::TickContext()
+{
+	bounds = worldBounds;
+	nbrShips = 0;
+	scratch = NULL;
+}
+
+////////////////////////////////////////////
+// Destructor: Frees the engine's scratch. //
+////////////////////////////////////////////
+TickContext::~TickContext()
+{
+	delete scratch;
+}
+
+//////////////////////////////////////////////////////////
+// Function to set the context up for a tick of the     //
+// world: the ripples newest first, each followed by    //
+// its ghosts if the world wraps, and the world's ship  //
+// archetypes, numbering the ships as exportShips       //
+// orders them.                                         //
+//////////////////////////////////////////////////////////
+void TickContext::begin(EntityWorld &world, const WorldBounds &bounds)
+{
+	Archetype &rows = world.getArchetype(0);
+	Ripple ghosts[MAX_GHOST_RIPPLES];
+
+	this->bounds = bounds;
+	ripples.clear();
+	for (int row = rows.getSize() - 1; row >= 0; row--)
+	{
+		Ripple cir = rows.getRipple(row);
+		int nbrGhosts = bounds.wrap ? GhostRipples(cir, bounds, ghosts) : 0;
+		ripples.push_back(cir);
+		ripples.insert(ripples.end(), ghosts, ghosts + nbrGhosts);
+	}
+
+	blocks.clear();
+	firstShips.clear();
+	nbrShips = 0;
+	for (int a = 1; a < world.getArchetypeCount(); a++)
+		if (world.getArchetype(a).isShip())
+		{
+			blocks.push_back(&world.getArchetype(a));
+			firstShips.push_back(nbrShips);
+			nbrShips += world.getArchetype(a).getSize();
+		}
+}
+
+//////////////////////////////////////////////////////////
+// Function to return the index, among the tick's       //
+// ships, of a ship archetype's first row.              //
+//////////////////////////////////////////////////////////
+int TickContext::firstShipOf(Archetype &ships)
+{
+	for (int b = 0; b < int(blocks.size()); b++)
+		if (blocks[b] == &ships)
+			return firstShips[b];
+	return 0;
+}
+
+////////////////////////////////////////////////////
+// IMPLEMENTATION SECTION FOR SYSTEM SCHEDULE     //
+////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////
+// Constructor: Each system joins the latest stage      //
+// unless it conflicts with a system already there, in  //
+// which case it opens a new stage, so conflicting      //
+// systems still run in the order given.                //
+//////////////////////////////////////////////////////////
+SystemSchedule::SystemSchedule(const EntitySystem systems[], int nbrSystems)
+{
+	for (int s = 0; s < nbrSystems; s++)
+	{
+		bool fits = !stages.empty();
+		for (int t = 0; fits && (t < int(stages.back().size())); t++)
+			if (conflicts(systems[s], *stages.back()[t]))
+				fits = false;
+		if (!fits)
+			stages.push_back( vector<const EntitySystem *>() );
+		stages.back().push_back(&systems[s]);
+	}
+}
+
+//////////////////////////////////////////////////////////
+// Functions to run every stage in turn, and to run one //
+// system alone, as a stage of its own.                 //
+//////////////////////////////////////////////////////////
+void SystemSchedule::run(EntityWorld &world)
+{
+	for (int t = 0; t < int(stages.size()); t++)
+		runStage(world, stages[t]);
+}
+
+void SystemSchedule::runSystem(EntityWorld &world, const EntitySystem &system)
+{
+	runStage(world, vector<const EntitySystem *>(1, &system));
+}
+
+//////////////////////////////////////////////////////////
+// Function to reach the context the schedule's systems //
+// are handed.                                          //
+//////////////////////////////////////////////////////////
+TickContext &SystemSchedule::getTickContext()
+{
+	return tick;
+}
+
+////////////////////////////////////////////
+// Function to report how many stages run. //
+////////////////////////////////////////////
+int SystemSchedule::getStageCount()
+{
+	return int(stages.size());
+}
+
+//////////////////////////////////////////////////////////
+// Function to run one stage: each of its systems that  //
+// prepares does so, in order, and then the systems are //
+// cut into chunks of ENTITY_GRAIN rows of each         //
+// archetype they visit, and all the chunks of the      //
+// stage are shared out among the worker pool.          //
+//////////////////////////////////////////////////////////
+void SystemSchedule::runStage(EntityWorld &world, const vector<const EntitySystem *> &stage)
+{
+	struct systemChunk
+	{
+		const EntitySystem *system;
+		Archetype *archetype;
+		int begin, end;
+	};
+	vector<systemChunk> chunks;
+	TickContext &tick = this->tick;
+
+	for (int s = 0; s < int(stage.size()); s++)
+	{
+		if (stage[s]->prepare != NULL)
+			stage[s]->prepare(world, tick);
+		for (int a = 0; a < world.getArchetypeCount(); a++)
+		{
+			Archetype &archetype = world.getArchetype(a);
+			const EntitySystem *system = stage[s];
+			if ( (archetype.getComponents() & system->required) != system->required )
+				continue;
+			for (int begin = 0; begin < archetype.getSize(); begin += ENTITY_GRAIN)
+			{
+				systemChunk chunk = { system, &archetype, begin, min(begin + ENTITY_GRAIN, archetype.getSize()) };
+				chunks.push_back(chunk);
+			}
+		}
+	}
+
+	if (chunks.size() == 1)
+		chunks[0].system->run(*chunks[0].archetype, chunks[0].begin, chunks[0].end, tick);
+	else if (chunks.size() > 1)
+		SimulationPool().parallelFor(int(chunks.size()), 1, [&chunks, &tick](int begin, int end)
+		{
+			for (int c = begin; c < end; c++)
+				chunks[c].system->run(*chunks[c].archetype, chunks[c].begin, chunks[c].end, tick);
+		});
+}
+
+//////////////////////////////////////////////////////////
+// Function to tell whether two systems may not run at  //
+// once: one writes a component the other touches.     //
+//////////////////////////////////////////////////////////
+bool SystemSchedule::conflicts(const EntitySystem &a, const EntitySystem &b)
+{
+	return ( (a.writes & (b.reads | b.writes)) != 0 ) || ( (b.writes & a.reads) != 0 );
+}
+
+/* Function to advance a world of the given bounds by one  */
+/* tick: its systems run (the ripples expand, trails are   */
+/* recorded), the ripples that have run their course are   */
+/* dropped, and the chosen engine displaces the ships (see */
+/* DisplaceWorld). Each stage is marked on the tick's      */
+/* stage timer.                                            */
+void AdvanceWorldTick(EntityWorld &world, SystemSchedule &schedule,
+					  const SimulationEngine &engine, const WorldBounds &bounds)
+{
+	schedule.run(world);
+	world.expireRipples();
+	tickStages.mark("systems");
+	DisplaceWorld(world, schedule, engine, bounds);
+	LOG_EVENT("tick: %d ships, %d ripples", world.getShipCount(), world.getRippleCount());
+}
+
+/* Function to displace a world's ships by its (already      */
+/* expanded) ripples: the engine runs as a system over the   */
+/* ship archetypes, writing their columns in place, handed   */
+/* the ripples together with their ghosts on a torus, and a  */
+/* second system wraps the ships afterwards.                 */
+void DisplaceWorld(EntityWorld &world, SystemSchedule &schedule,
+				   const SimulationEngine &engine, const WorldBounds &bounds)
+{
+	EntitySystem displace = { engine.name, SHIP_COMPONENTS, SHIP_COMPONENTS,
+							  (1 << positionComponent) | (1 << headingComponent) | (1 << sleepComponent),
+							  engine.displace, engine.prepare };
+
+	schedule.getTickContext().begin(world, bounds);
+	tickStages.mark("ghosts");
+	schedule.runSystem(world, displace);
+	tickStages.mark("displace");
+	if (bounds.wrap)
+	{
+		schedule.runSystem(world, WRAP_SYSTEM);
+		tickStages.mark("wrap");
+	}
+}
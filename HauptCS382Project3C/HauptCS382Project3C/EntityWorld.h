@@ -0,0 +1,342 @@
+/////////////////////////////////////////////////////////////////
+// Class definition file: EntityWorld.h                        //
+//                                                             //
+// This file defines an entity-component store for the ships   //
+// and ripples.  An entity is a row in an archetype: a table   //
+// holding one contiguous column per component its entities    //
+// have, so that an attribute only some ships need (a trail,   //
+// say) lives in the archetype of those ships alone, and a     //
+// system that touches two components streams two columns.     //
+// Ships are the entities with a position, heading, hue and    //
+// sleep counter (plus whatever else they carry); ripples have //
+// a position, radius, hue and color mask, and all share one   //
+// archetype whose rows run from the oldest ripple to the      //
+// newest.  Predators (see Predators.h) have a position,       //
+// heading, hue and hunter state, and are not ships.           //
+//                                                             //
+// Systems declare the components they read and write, and a  //
+// SystemSchedule groups them into stages of systems that do   //
+// not conflict, which then run together on the worker pool,   //
+// each over its archetypes' rows in chunks.  A system may     //
+// also prepare once a tick, before its chunks run.  The       //
+// displacement engines (see Simulation.h) are such systems,   //
+// run over the ship archetypes' columns in place; the tick's  //
+// context carries what they share: the ripples with their     //
+// ghosts, the world's bounds, and the engine's scratch.       //
+//                                                             //
+// A world belongs to the thread stepping it.  Its columns are //
+// written in place every tick, so no other thread reads them: //
+// the recorder and the watchdog take their copies on the      //
+// stepping thread between ticks (see Recording.h), and other  //
+// threads hand ripples over through a LockFreeStack.          //
+/////////////////////////////////////////////////////////////////
+
+#ifndef ENTITY_WORLD_H
+
+#include "Flocking.h"
+#include "Simulation.h"
+#include "LinkedList.h"
+#include "LockFreeStack.h"
+#include "MemoryAccounting.h"
+#include <vector>
+
+enum componentKind { positionComponent, headingComponent, hueComponent, sleepComponent,
+					 trailComponent, radiusComponent, maskComponent, hunterComponent };
+
+typedef unsigned int componentSet;	// One bit per component kind. //
+
+const int NBR_COMPONENT_KINDS	= 8;	// Kinds Of Component      //
+const int TRAIL_LENGTH			= 16;	// Positions Per Trail     //
+const int ENTITY_GRAIN			= 512;	// Rows Per System Chunk   //
+const int MIN_ARCHETYPE_ROWS	= 64;	// Smallest Column Capacity //
+
+// Function to return a component kind's bit in a component set. //
+inline componentSet ComponentBit(componentKind kind)
+{
+	return componentSet(1) << int(kind);
+}
+
+////////////////
+// Components //
+////////////////
+struct Position	{ float pos[2]; };
+struct Heading	{ float delta[2]; };
+struct Hue		{ color clr; };
+struct Sleep	{ unsigned char idle; };
+struct Radius	{ float rad; };
+struct Mask		{ unsigned char mask; };
+
+// A predator's ticks until its next ripple, and its ticks between ripples. //
+struct Hunter
+{
+	int cooldown;
+	int period;
+};
+
+// The latest TRAIL_LENGTH positions of a ship, oldest at "next" once full. //
+struct Trail
+{
+	float pos[TRAIL_LENGTH][2];
+	int next;
+	int count;
+};
+
+// Each component type names its kind, so that columns can be looked up by type. //
+template <class C> struct ComponentKindOf;
+template <> struct ComponentKindOf<Position>	{ static const componentKind kind = positionComponent; };
+template <> struct ComponentKindOf<Heading>		{ static const componentKind kind = headingComponent; };
+template <> struct ComponentKindOf<Hue>			{ static const componentKind kind = hueComponent; };
+template <> struct ComponentKindOf<Sleep>		{ static const componentKind kind = sleepComponent; };
+template <> struct ComponentKindOf<Trail>		{ static const componentKind kind = trailComponent; };
+template <> struct ComponentKindOf<Radius>		{ static const componentKind kind = radiusComponent; };
+template <> struct ComponentKindOf<Mask>		{ static const componentKind kind = maskComponent; };
+template <> struct ComponentKindOf<Hunter>		{ static const componentKind kind = hunterComponent; };
+
+const componentSet SHIP_COMPONENTS		= (1 << positionComponent) | (1 << headingComponent) |
+										  (1 << hueComponent) | (1 << sleepComponent);
+const componentSet RIPPLE_COMPONENTS	= (1 << positionComponent) | (1 << radiusComponent) |
+										  (1 << hueComponent) | (1 << maskComponent);
+const componentSet PREDATOR_COMPONENTS	= (1 << positionComponent) | (1 << headingComponent) |
+										  (1 << hueComponent) | (1 << hunterComponent);
+
+/////////////////////////////////////////////
+// DECLARATION SECTION FOR ARCHETYPE CLASS //
+/////////////////////////////////////////////
+
+class Archetype
+{
+	public:
+		// Class constructor and destructor
+		Archetype(componentSet components, memoryTag tag);
+		~Archetype();
+
+		// Member functions
+		componentSet getComponents();
+		bool isRipple();
+		bool isShip();
+		int getSize();
+		int getRowBytes();
+		int append();
+		int appendRows(int count);
+		void eraseFront(int count);
+		void clear();
+		void shrink();
+		Ship getShip(int row);
+		void setShip(int row, const Ship &shp);
+		Ripple getRipple(int row);
+		void setRipple(int row, const Ripple &cir);
+		template <class Keep> int retain(Keep keep);
+
+		// The column of component C, or NULL if these entities lack it. //
+		template <class C> C *column()
+		{
+			return (C *)columns[ComponentKindOf<C>::kind];
+		}
+
+	protected:
+		// Data members
+		componentSet components;
+		memoryTag tag;
+		int size;
+		int capacity;
+		unsigned char *columns[NBR_COMPONENT_KINDS];
+
+		// Member functions
+		void reserve(int rows);
+		void moveRow(int from, int to);
+
+	private:
+		// Archetypes own their columns, so they are never copied.
+		Archetype(const Archetype &archetype);
+};
+
+//////////////////////////////////////////////////////////
+// Function to keep, in order, only the rows for which  //
+// "keep" returns true, returning how many were dropped. //
+//////////////////////////////////////////////////////////
+template <class Keep>
+int Archetype::retain(Keep keep)
+{
+	int row, kept = 0, dropped;
+
+	for (row = 0; row < size; row++)
+		if (keep(row))
+		{
+			if (kept != row)
+				moveRow(row, kept);
+			kept++;
+		}
+	dropped = size - kept;
+	size = kept;
+	return dropped;
+}
+
+//////////////////////////////////////////////////////////
+// Scratch an engine keeps from one tick to the next (a //
+// grid, an index), owned by the tick's context.        //
+//////////////////////////////////////////////////////////
+class EngineScratch
+{
+	public:
+		virtual ~EngineScratch() {}
+};
+
+//////////////////////////////////////////////////////////
+// What a tick's systems see besides their own rows:    //
+// the ripples as the engines take them (newest first,  //
+// each followed by its ghosts on a torus), the world's //
+// bounds, the ship archetypes in the world's order     //
+// with the index of each one's first ship, and the     //
+// engine's scratch.  A schedule keeps one, so that     //
+// what it holds is reused from tick to tick.           //
+//////////////////////////////////////////////////////////
+class TickContext
+{
+	public:
+		// Class constructor and destructor
+		TickContext();
+		~TickContext();
+
+		// Member functions
+		void begin(EntityWorld &world, const WorldBounds &bounds);
+		int firstShipOf(Archetype &ships);
+		template <class S> S &scratchAs();
+
+		// Data members
+		std::vector<Ripple> ripples;
+		WorldBounds bounds;
+		std::vector<Archetype *> blocks;
+		std::vector<int> firstShips;
+		int nbrShips;
+
+	protected:
+		// Data member
+		EngineScratch *scratch;
+
+	private:
+		// Contexts own their scratch, so they are never copied.
+		TickContext(const TickContext &tick);
+};
+
+//////////////////////////////////////////////////////////
+// Function to return the engine's scratch as an "S",   //
+// replacing whatever another engine left there.  The   //
+// engine's prepare function makes it, before any chunk //
+// runs, so the chunks only ever find it.               //
+//////////////////////////////////////////////////////////
+template <class S>
+S &TickContext::scratchAs()
+{
+	S *found = dynamic_cast<S *>(scratch);
+
+	if (found == NULL)
+	{
+		delete scratch;
+		scratch = found = new S;
+	}
+	return *found;
+}
+
+//////////////////////////////////////////////////////////
+// A system: the components an archetype must have for  //
+// the system to visit it, those it reads and writes,   //
+// the function run over a range of its rows, and the   //
+// function run once before its chunks (or NULL).       //
+//////////////////////////////////////////////////////////
+typedef DisplaceFunction SystemFunction;
+
+struct EntitySystem
+{
+	const char *name;
+	componentSet required;
+	componentSet reads;
+	componentSet writes;
+	SystemFunction run;
+	PrepareFunction prepare;
+};
+
+extern const EntitySystem WORLD_SYSTEMS[];
+extern const int NBR_WORLD_SYSTEMS;
+
+///////////////////////////////////////////////
+// DECLARATION SECTION FOR ENTITY WORLD CLASS //
+///////////////////////////////////////////////
+
+class EntityWorld
+{
+	public:
+		// Class constructor and destructor
+		EntityWorld();
+		~EntityWorld();
+
+		// Member functions
+		Archetype &archetypeFor(componentSet components);
+		int getArchetypeCount();
+		Archetype &getArchetype(int index);
+		void addShip(const Ship &shp, componentSet extras);
+		void addRipple(const Ripple &cir);
+		int drainRipples(LockFreeStack<Ripple> &queue);
+		int expireRipples();
+		int enforceRippleBudget();
+		int enforceRippleBudget(long long budgetBytes);
+		int getShipCount();
+		int getRippleCount();
+		void exportShips(LinkedList<Ship> &shipList);
+		void exportRipples(LinkedList<Ripple> &circleList);
+		void importShips(LinkedList<Ship> &shipList);
+		void importRipples(LinkedList<Ripple> &circleList);
+		void clearShips();
+		void clearRipples();
+
+	protected:
+		// Data members
+		std::vector<Archetype *> archetypes;	// [0] holds the ripples. //
+
+		// Member function
+		int shedRipples(int nbrKept);
+
+	private:
+		// Worlds own their archetypes, so they are never copied.
+		EntityWorld(const EntityWorld &world);
+};
+
+////////////////////////////////////////////////
+// DECLARATION SECTION FOR SYSTEM SCHEDULE    //
+////////////////////////////////////////////////
+
+class SystemSchedule
+{
+	public:
+		// Class constructor
+		SystemSchedule(const EntitySystem systems[], int nbrSystems);
+
+		// Member functions
+		void run(EntityWorld &world);
+		void runSystem(EntityWorld &world, const EntitySystem &system);
+		TickContext &getTickContext();
+		int getStageCount();
+
+	protected:
+		// Data members
+		std::vector< std::vector<const EntitySystem *> > stages;
+		TickContext tick;
+
+		// Member functions
+		void runStage(EntityWorld &world, const std::vector<const EntitySystem *> &stage);
+		static bool conflicts(const EntitySystem &a, const EntitySystem &b);
+
+	private:
+		// Schedules own their tick's context, so they are never copied.
+		SystemSchedule(const SystemSchedule &schedule);
+};
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+void AdvanceWorldTick(EntityWorld &world, SystemSchedule &schedule,
+					  const SimulationEngine &engine, const WorldBounds &bounds);
+void DisplaceWorld(EntityWorld &world, SystemSchedule &schedule,
+				   const SimulationEngine &engine, const WorldBounds &bounds);
+
+#define ENTITY_WORLD_H
+#endif
@@ -0,0 +1,88 @@
+/////////////////////////////////////////////////////////////////
+// Definition file: Flocking.h                                 //
+//                                                             //
+// This file defines the constants, the color index values,    //
+// and the Ripple and Ship classes shared by the simulation    //
+// core and the display code, so that more than one source     //
+// file can step or draw the same world.  It does not depend   //
+// on OpenGL: the window draws ships and ripples itself (see   //
+// DrawShip and DrawRipple), so the core builds without it.    //
+/////////////////////////////////////////////////////////////////
+
+#ifndef FLOCKING_H
+
+#include <cmath>			// Header File For Math Library
+#include "MemoryAccounting.h"	// Header File For Memory Tags
+
+//////////////////////
+// Global Constants //
+//////////////////////
+const float INITIAL_RADIUS				= 0.0f;					// Init. Ripple Radius //
+const float FINAL_RADIUS				= 0.5f;					// Final Ripple Radius //
+const float RADIUS_INCREMENT			= 0.01f;					// Rad. Expansion Rate //
+const int   NBR_LINKS					= 25;					// Polygonal Circle    //
+const int	NBR_SHIPS					= 1000;					// # Of Ships          //
+const float PI_OVER_180					= 0.0174532925f;			// 1 Degree in Radians //
+const int   NBR_COLORS					= 7;					// # Point Colors      //
+const float CIRCLE_COLOR[NBR_COLORS][3]	= { { 1.0f, 1.0f, 1.0f },	// All Ripple Colors   //
+											{ 1.0f, 0.3f, 0.3f },
+											{ 1.0f, 1.0f, 0.3f },
+											{ 0.3f, 1.0f, 0.3f },
+											{ 0.3f, 1.0f, 1.0f },
+											{ 0.3f, 0.3f, 1.0f },
+											{ 1.0f, 0.3f, 1.0f } };
+const float SHIP_RADIUS					= 0.02f;
+const float SHIP_THICKNESS				= 2.0f;
+const float MIN_SHIP_DELTA				= -0.0001f;				// Ship Trajectory's   //
+const float MAX_SHIP_DELTA				=  0.0001f;				// Lower, Upper Bounds //
+const float VECTOR_SIZE					= 0.01f;
+
+enum color { white, red, yellow, green, cyan, blue, magenta, none };	// Color Index Values //
+
+const unsigned char ALL_COLORS_MASK		= (1 << NBR_COLORS) - 1;	// Every Color's Bit   //
+
+// Function to return a color's bit in a ripple's color mask; //
+// the invisible "none" stands for every color at once.       //
+inline unsigned char ColorBit(color clr)
+{
+	return (clr == none) ? ALL_COLORS_MASK : (unsigned char)(1 << int(clr));
+}
+
+////////////////////////////////////////
+// 2D ripple class (for convenience). //
+////////////////////////////////////////
+class Ripple
+{
+	public:
+		float pos[2];	// 2-D position of circle's center //
+		float rad;		// Radius of circle                //
+		color clr;		// Initial color of circle         //
+		unsigned char mask;	// Colors of ships it displaces //
+
+		// The setColor member function makes a single-color ripple, //
+		// or an invisible one that displaces ships of every color.  //
+		void setColor(color c)
+		{
+			clr = c;
+			mask = ColorBit(c);
+		}
+};
+
+//////////////////////////////////////
+// 2D ship class (for convenience). //
+//////////////////////////////////////
+class Ship
+{
+	public:
+		float pos[2];	// 2-D position of flocker      //
+		float delta[2];	// Trajectory vector of flocker //
+		color clr;		// Color of flocker             //
+		unsigned char idle;	// Ticks it may skip the ripples //
+};
+
+// List and stack nodes of ships and ripples are counted under their own tags. //
+template <> struct MemoryTagOf<Ripple>	{ static const memoryTag tag = rippleMemory; };
+template <> struct MemoryTagOf<Ship>	{ static const memoryTag tag = shipMemory; };
+
+#define FLOCKING_H
+#endif
@@ -0,0 +1,236 @@
+/////////////////////////////////////////////////////////////////
+// Implementation file: FlockingAPI.cpp                        //
+//                                                             //
+// A simulation is an entity world of its own, with its own    //
+// ripple queue, system schedule and bounds, stepped as the    //
+// window steps its world, less the predators and obstacles.   //
+// Its ship blocks are its ship archetypes, in the world's     //
+// order, and views point straight into their columns.  All    //
+// simulations share the one worker pool; none reads the       //
+// window's bounds.                                            //
+/////////////////////////////////////////////////////////////////
+
+#include "FlockingAPI.h"
+#include "Flocking.h"
+#include "Simulation.h"
+#include "EntityWorld.h"
+#include "LockFreeStack.h"
+#include "Workload.h"
+#include <mutex>
+
+static_assert(sizeof(Hue) == sizeof(int), "hues are viewed as ints");
+
+struct FlockSim
+{
+	FlockSim() : schedule(WORLD_SYSTEMS, NBR_WORLD_SYSTEMS), rippleBudget(0), tick(0), shed(0) {}
+
+	EntityWorld world;
+	SystemSchedule schedule;
+	LockFreeStack<Ripple> queue;		// Ripples awaiting the next step. //
+	const SimulationEngine *engine;
+	WorldBounds bounds;
+	long long rippleBudget;				// Bytes; zero for none.           //
+	long tick;
+	long shed;
+};
+
+// The extent flock_create gives a simulation: the window-sized plane. //
+static WorldBounds defaultBounds = { false, 2.0f, 2.0f };
+static std::mutex defaultBoundsLock;	// Any thread may set or read it. //
+
+/* Function to find a simulation's ship archetype of a block, */
+/* or NULL if there is no such block.                         */
+static Archetype *ShipBlock(FlockSim *sim, int block)
+{
+	for (int a = 0; a < sim->world.getArchetypeCount(); a++)
+		if (sim->world.getArchetype(a).isShip() && (block-- == 0))
+			return &sim->world.getArchetype(a);
+	return NULL;
+}
+
+
+/* Function to report the interface's version. */
+int flock_api_version(void)
+{
+	return FLOCK_API_VERSION;
+}
+
+
+/* Function to set the default extent, centered on the       */
+/* origin, and whether it wraps around, for the simulations  */
+/* flock_create makes from now on; those already made keep   */
+/* their own. Kept for version 1 callers; new callers pass   */
+/* the extent to flock_create_bounded instead. Any thread    */
+/* may call it, even while others create simulations.        */
+void flock_set_bounds(float width, float height, int wrap)
+{
+	std::lock_guard<std::mutex> guard(defaultBoundsLock);
+
+	if ( (width > 0.0f) && (height > 0.0f) )
+	{
+		defaultBounds.width = width;
+		defaultBounds.height = height;
+	}
+	defaultBounds.wrap = (wrap != 0);
+}
+
+
+/* Function to create a simulation of the default extent (see */
+/* flock_create_bounded).                                     */
+FlockSim *flock_create(const char *engine, const char *shape, int nbrShips, unsigned int seed)
+{
+	WorldBounds bounds;
+	{
+		std::lock_guard<std::mutex> guard(defaultBoundsLock);
+		bounds = defaultBounds;
+	}
+	return flock_create_bounded(engine, shape, nbrShips, seed, bounds.width, bounds.height, int(bounds.wrap));
+}
+
+
+/* Function to create a simulation of "nbrShips" ships placed */
+/* in the population shape named (see Workload.h), stepped by */
+/* the engine named (see Simulation.h), in a world "width" by */
+/* "height" centered on the origin, which wraps around if     */
+/* "wrap" is not zero. NULL names choose the uniform shape    */
+/* and the reference engine. NULL is returned if either name  */
+/* is unknown or the extent is not positive.                  */
+FlockSim *flock_create_bounded(const char *engine, const char *shape, int nbrShips, unsigned int seed,
+							   float width, float height, int wrap)
+{
+	const SimulationEngine *found = (engine != NULL) ? FindEngine(engine) : &ENGINES[0];
+	const PopulationShape *placer = FindPopulationShape( (shape != NULL) ? shape : "uniform" );
+	WorkloadLayout layout;
+	FlockSim *sim;
+
+	if ( (found == NULL) || (placer == NULL) || (nbrShips < 0) || !(width > 0.0f) || !(height > 0.0f) )
+		return NULL;
+	sim = new FlockSim;
+	sim->engine = found;
+	sim->bounds.width = width;
+	sim->bounds.height = height;
+	sim->bounds.wrap = (wrap != 0);
+	MakeWorkloadLayout(layout, width, height, seed);
+	GeneratePopulation(sim->world, *placer, nbrShips, layout, seed);
+	return sim;
+}
+
+
+/* Function to destroy a simulation, and with it its views. */
+void flock_destroy(FlockSim *sim)
+{
+	delete sim;
+}
+
+
+/* Function to queue a ripple of color "hue" at (x, y), to  */
+/* join the simulation on its next step; any thread may     */
+/* call it. Zero is returned (and nothing queued) for a hue */
+/* that is not a color.                                     */
+int flock_add_ripple(FlockSim *sim, float x, float y, int hue)
+{
+	Ripple cir;
+
+	if ( (hue < 0) || (hue >= NBR_COLORS) )
+		return 0;
+	cir.pos[0] = x;
+	cir.pos[1] = y;
+	cir.rad = INITIAL_RADIUS;
+	cir.setColor(color(hue));
+	sim->queue.push(cir);
+	return 1;
+}
+
+
+/* Function to cap the bytes a simulation's ripples may take */
+/* (zero, as it starts: no cap). Past it, the oldest are     */
+/* shed on its next step, whatever other simulations hold.   */
+void flock_set_ripple_budget(FlockSim *sim, long long budgetBytes)
+{
+	sim->rippleBudget = (budgetBytes > 0) ? budgetBytes : 0;
+}
+
+
+/* Function to step a simulation "nbrTicks" ticks: each tick  */
+/* the queued ripples join it, those over its own ripple      */
+/* budget are shed, and its world advances.                   */
+void flock_step(FlockSim *sim, int nbrTicks)
+{
+	for (int t = 0; t < nbrTicks; t++)
+	{
+		sim->world.drainRipples(sim->queue);
+		sim->shed += sim->world.enforceRippleBudget(sim->rippleBudget);
+		AdvanceWorldTick(sim->world, sim->schedule, *sim->engine, sim->bounds);
+		sim->tick++;
+	}
+}
+
+
+/* Functions to report a simulation's ticks, ships, ripples, */
+/* and the ripples it has shed over its budget.              */
+long flock_tick(const FlockSim *sim)
+{
+	return sim->tick;
+}
+
+int flock_ship_count(FlockSim *sim)
+{
+	return sim->world.getShipCount();
+}
+
+int flock_ripple_count(FlockSim *sim)
+{
+	return sim->world.getRippleCount();
+}
+
+long flock_ripples_shed(const FlockSim *sim)
+{
+	return sim->shed;
+}
+
+
+/* Function to count a simulation's blocks of ships. */
+int flock_ship_block_count(FlockSim *sim)
+{
+	int count = 0;
+	for (int a = 0; a < sim->world.getArchetypeCount(); a++)
+		if (sim->world.getArchetype(a).isShip())
+			count++;
+	return count;
+}
+
+
+/* Function to fill "view" with a block of ships' columns.  */
+/* Zero is returned (and the view left alone) if there is   */
+/* no such block.                                           */
+int flock_ship_view(FlockSim *sim, int block, FlockShipView *view)
+{
+	Archetype *ships = ShipBlock(sim, block);
+	Position *position;
+	Heading *heading;
+	Hue *hue;
+
+	if (ships == NULL)
+		return 0;
+	if (ships->getSize() == 0)
+	{
+		view->x = view->y = view->dx = view->dy = NULL;
+		view->hue = NULL;
+		view->positionStride = view->headingStride = view->hueStride = 0;
+		view->length = 0;
+		return 1;
+	}
+	position = ships->column<Position>();
+	heading = ships->column<Heading>();
+	hue = ships->column<Hue>();
+	view->x = &position->pos[0];
+	view->y = &position->pos[1];
+	view->positionStride = sizeof(Position);
+	view->dx = &heading->delta[0];
+	view->dy = &heading->delta[1];
+	view->headingStride = sizeof(Heading);
+	view->hue = (const int *)hue;
+	view->hueStride = sizeof(Hue);
+	view->length = ships->getSize();
+	return 1;
+}
@@ -0,0 +1,90 @@
+/////////////////////////////////////////////////////////////////
+// Definition file: FlockingAPI.h                              //
+//                                                             //
+// This file declares the C interface of the FlockingAPI       //
+// shared library, for programs that drive the simulation in   //
+// their own process: create a simulation, queue ripples,      //
+// step it, and read its ships where they lie.  It is plain C  //
+// so that any runtime with a foreign function interface can   //
+// bind it, and only ever grows: functions are not changed     //
+// once published.                                             //
+//                                                             //
+// The ships are not copied out.  A simulation keeps them in   //
+// blocks (the archetypes of its entity world, see             //
+// EntityWorld.h), each a set of columns, and a view of a      //
+// block gives the address of the first ship's x, y, heading   //
+// and hue in each column, the stride in bytes from one ship   //
+// to the next, and the number of ships.  A view stays valid   //
+// until the simulation is next stepped or destroyed.          //
+//                                                             //
+// Ripples may be queued from any thread, even while another   //
+// steps the simulation; they join it at the start of the      //
+// next step.  Stepping, viewing and destroying a simulation   //
+// must not overlap, though different simulations may be       //
+// stepped on different threads.  Each simulation keeps the    //
+// extent it was created with (flock_create_bounded); those    //
+// made by flock_create take the default extent, which         //
+// flock_set_bounds changes for simulations created after it.  //
+// Each also has a ripple budget of its own (none until        //
+// flock_set_ripple_budget sets one), which only its own       //
+// ripples count against.                                      //
+/////////////////////////////////////////////////////////////////
+
+#ifndef FLOCKING_API_H
+
+#include <stddef.h>
+
+#if defined(_WIN32) && defined(FLOCKING_API_EXPORTS)
+#define FLOCKING_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define FLOCKING_API __declspec(dllimport)
+#elif defined(__GNUC__)
+#define FLOCKING_API __attribute__((visibility("default")))
+#else
+#define FLOCKING_API
+#endif
+
+#define FLOCK_API_VERSION	3		/* Bumped When Functions Are Added */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FlockSim FlockSim;	/* An opaque simulation. */
+
+/* One block of ships: each field's first element, and its stride in bytes. */
+typedef struct FlockShipView
+{
+	const float *x;				/* Positions            */
+	const float *y;
+	size_t positionStride;
+	const float *dx;			/* Headings (per tick)  */
+	const float *dy;
+	size_t headingStride;
+	const int *hue;				/* Colors, 0 to 6       */
+	size_t hueStride;
+	int length;					/* Ships in the block   */
+} FlockShipView;
+
+FLOCKING_API int flock_api_version(void);
+FLOCKING_API void flock_set_bounds(float width, float height, int wrap);
+FLOCKING_API FlockSim *flock_create(const char *engine, const char *shape, int nbrShips, unsigned int seed);
+FLOCKING_API FlockSim *flock_create_bounded(const char *engine, const char *shape, int nbrShips, unsigned int seed,
+											 float width, float height, int wrap);	/* Since Version 2 */
+FLOCKING_API void flock_destroy(FlockSim *sim);
+FLOCKING_API int flock_add_ripple(FlockSim *sim, float x, float y, int hue);
+FLOCKING_API void flock_set_ripple_budget(FlockSim *sim, long long budgetBytes);	/* Since Version 3 */
+FLOCKING_API void flock_step(FlockSim *sim, int nbrTicks);
+FLOCKING_API long flock_tick(const FlockSim *sim);
+FLOCKING_API int flock_ship_count(FlockSim *sim);
+FLOCKING_API int flock_ripple_count(FlockSim *sim);
+FLOCKING_API long flock_ripples_shed(const FlockSim *sim);
+FLOCKING_API int flock_ship_block_count(FlockSim *sim);
+FLOCKING_API int flock_ship_view(FlockSim *sim, int block, FlockShipView *view);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define FLOCKING_API_H
+#endif
@@ -0,0 +1,300 @@
+/********************************************************************/
+/* Filename: Fuzzer.cpp                                             */
+/*                                                                  */
+/* Differential fuzzing of the displacement engines. Populations    */
+/* mix uniform scatter with the awkward cases: ships stacked on     */
+/* one spot, ships with no trajectory at all, and ripples dropped   */
+/* exactly on a ship's center. Every other case runs on a torus.    */
+/* The reference they are checked by, BaselineTick, is the original */
+/* program's list loop, and shares no staging with the engines.     */
+/* Exact engines must agree with it bit for bit; the rest within    */
+/* LOCKSTEP_TOLERANCE.  Rule sets that claim to be the reference's  */
+/* rule (see ShipRules.h) are checked exactly too; the others       */
+/* change the ships' behavior on purpose, so are not.               */
+/********************************************************************/
+
+#include "Fuzzer.h"
+#include "ShipRules.h"
+#include <cstdio>			// Header File For Console Output          //
+using namespace std;
+
+const float FUZZ_WORLD_SIZE = 2.0f;		// Side Of Fuzzed World //
+
+
+/* Function to fill a ship list with a random population. */
+/* Roughly one ship in eight is stacked on a shared spot, */
+/* and one in sixteen has no trajectory to normalize.     */
+void GenerateFuzzShips(LinkedList<Ship> &shipList, int nbrShips, float width, float height,
+					   mt19937 &rng)
+{
+	uniform_real_distribution<float> across(-0.5f * width, 0.5f * width);
+	uniform_real_distribution<float> down(-0.5f * height, 0.5f * height);
+	uniform_real_distribution<float> drift(MIN_SHIP_DELTA, MAX_SHIP_DELTA);
+	uniform_int_distribution<int> hue(0, NBR_COLORS - 1);
+	uniform_int_distribution<int> kind(0, 15);
+	float stack[2] = { across(rng), down(rng) };
+	Ship shp;
+
+	for (int i = 0; i < nbrShips; i++)
+	{
+		int k = kind(rng);
+		if (k < 2)
+		{
+			shp.pos[0] = stack[0];
+			shp.pos[1] = stack[1];
+		}
+		else
+		{
+			shp.pos[0] = across(rng);
+			shp.pos[1] = down(rng);
+		}
+		shp.delta[0] = (k == 2) ? 0.0f : drift(rng);
+		shp.delta[1] = (k == 2) ? 0.0f : drift(rng);
+		Normalize(shp.delta);
+		shp.clr = color(hue(rng));
+		shp.idle = 0;
+		shipList.insert(shp);
+	}
+}
+
+
+/* Function to build a stream of ripple events, about one  */
+/* every "odds" ticks, at random spots and in random       */
+/* colors (including the invisible, all-affecting ripple). */
+/* One ripple in four targets a random set of colors.      */
+void GenerateRippleEvents(vector<RippleEvent> &events, long nbrTicks, int odds,
+						  float width, float height, mt19937 &rng)
+{
+	uniform_real_distribution<float> across(-0.5f * width, 0.5f * width);
+	uniform_real_distribution<float> down(-0.5f * height, 0.5f * height);
+	uniform_int_distribution<int> hue(0, NBR_COLORS);
+	uniform_int_distribution<int> chance(0, odds - 1);
+	uniform_int_distribution<int> quarter(0, 3);
+	uniform_int_distribution<int> colorSet(1, ALL_COLORS_MASK);
+	RippleEvent event;
+
+	for (long tick = 1; tick <= nbrTicks; tick++)
+		if (chance(rng) == 0)
+		{
+			event.tick = tick;
+			event.ripple.pos[0] = across(rng);
+			event.ripple.pos[1] = down(rng);
+			event.ripple.rad = INITIAL_RADIUS;
+			event.ripple.setColor( color(hue(rng)) );
+			if (quarter(rng) == 0)
+				event.ripple.mask = (unsigned char)colorSet(rng);
+			events.push_back(event);
+		}
+}
+
+
+/* Function to move some ripple events onto the exact   */
+/* centers of randomly chosen ships, where the distance */
+/* test and the push direction are both degenerate.     */
+void AimRipplesAtShips(vector<RippleEvent> &events, LinkedList<Ship> &shipList, mt19937 &rng)
+{
+	uniform_int_distribution<int> chance(0, 3);
+	int i, steps;
+
+	if (shipList.isEmpty())
+		return;
+	for (i = 0; i < int(events.size()); i++)
+		if (chance(rng) == 0)
+		{
+			for (steps = rng() % shipList.getSize(); steps > 0; steps--)
+				++shipList;
+			events[i].ripple.pos[0] = shipList.getHeadValue().pos[0];
+			events[i].ripple.pos[1] = shipList.getHeadValue().pos[1];
+		}
+}
+
+
+/* Function to fill "images" with a ripple and, on a torus, */
+/* its copies across the edges its final radius reaches,    */
+/* shifted by the world's width and/or height, returning    */
+/* how many there are.                                      */
+static int RippleImages(const Ripple &cir, const WorldBounds &bounds, Ripple images[])
+{
+	float size[2] = { bounds.width, bounds.height }, shift[2] = { 0.0f, 0.0f };
+	int d, x, y, nbrImages = 0;
+
+	for (d = 0; bounds.wrap && (d <= 1); d++)
+		if (cir.pos[d] - FINAL_RADIUS < -0.5f * size[d])
+			shift[d] = size[d];
+		else if (cir.pos[d] + FINAL_RADIUS >= 0.5f * size[d])
+			shift[d] = -size[d];
+	for (y = 0; y <= 1; y++)
+		for (x = 0; x <= 1; x++)
+			if ( ((x == 0) || (shift[0] != 0.0f)) && ((y == 0) || (shift[1] != 0.0f)) )
+			{
+				images[nbrImages] = cir;
+				if (x == 1)
+					images[nbrImages].pos[0] += shift[0];
+				if (y == 1)
+					images[nbrImages].pos[1] += shift[1];
+				nbrImages++;
+			}
+	return nbrImages;
+}
+
+
+/* Function to advance a list world by one tick as the       */
+/* original program's timer did, sharing none of the         */
+/* engines' staging: every ripple expands (those reaching    */
+/* their final radius are dropped), then each ship is pushed */
+/* by every ripple in turn, newest first, together with its  */
+/* images on a torus, and wrapped back into the world. This  */
+/* is the standalone reference the engines are fuzzed by.    */
+void BaselineTick(LinkedList<Ship> &shipList, LinkedList<Ripple> &circleList, const WorldBounds &bounds)
+{
+	int i, j, k, nbrImages, nbrRipples = circleList.getSize();
+	Ship shp;
+	Ripple cir, images[4];
+	float intensity;
+
+	for (i = 1; i <= nbrRipples; i++)
+	{
+		cir = circleList.getHeadValue();
+		circleList.removeHead();
+		cir.rad += RADIUS_INCREMENT;
+		if (cir.rad < FINAL_RADIUS)
+		{
+			circleList.insert( cir );
+			++circleList;
+		}
+	}
+
+	for (i = 1; i <= shipList.getSize(); i++)
+	{
+		shp = shipList.getHeadValue();
+		shipList.removeHead();
+		for (j = 1; j <= circleList.getSize(); j++)
+		{
+			nbrImages = RippleImages(circleList.getHeadValue(), bounds, images);
+			for (k = 0; k < nbrImages; k++)
+			{
+				cir = images[k];
+				if ( cir.mask & ColorBit(shp.clr) )
+					if ( pow(cir.pos[0] - shp.pos[0], 2) + pow(cir.pos[1] - shp.pos[1], 2) < pow(cir.rad, 2) )
+					{
+						intensity = 0.05f * (FINAL_RADIUS - cir.rad) / (FINAL_RADIUS - INITIAL_RADIUS);
+						shp.delta[0] += intensity * (shp.pos[0] - cir.pos[0]);
+						shp.delta[1] += intensity * (shp.pos[1] - cir.pos[1]);
+						shp.pos[0] += intensity * (shp.pos[0] - cir.pos[0]);
+						shp.pos[1] += intensity * (shp.pos[1] - cir.pos[1]);
+					}
+			}
+			++circleList;
+		}
+		Normalize(shp.delta);
+		if (bounds.wrap)
+		{
+			if (shp.pos[0] >= 0.5f * bounds.width)
+				shp.pos[0] -= bounds.width;
+			else if (shp.pos[0] < -0.5f * bounds.width)
+				shp.pos[0] += bounds.width;
+			if (shp.pos[1] >= 0.5f * bounds.height)
+				shp.pos[1] -= bounds.height;
+			else if (shp.pos[1] < -0.5f * bounds.height)
+				shp.pos[1] += bounds.height;
+		}
+		shipList.insert( shp );
+		++shipList;
+	}
+}
+
+
+/* Function to run an engine in lockstep with BaselineTick   */
+/* from the same starting ships and ripples, as RunLockstep  */
+/* runs two engines, stopping at the first tick on which     */
+/* the engine's world disagrees with the baseline's.         */
+DivergenceReport RunAgainstBaseline(const SimulationEngine &engine,
+									LinkedList<Ship> &shipList, LinkedList<Ripple> &circleList,
+									const vector<RippleEvent> &events, long nbrTicks, float tolerance)
+{
+	LinkedList<Ship> expectedShips(shipList), actualShips(shipList);
+	LinkedList<Ripple> expectedCircles(circleList), actualCircles(circleList);
+	DivergenceReport report;
+	int nextEvent = 0;
+	long tick;
+
+	report.diverged = false;
+	report.tick = nbrTicks;
+	report.ship = 0;
+	for (tick = 1; tick <= nbrTicks; tick++)
+	{
+		while ( (nextEvent < int(events.size())) && (events[nextEvent].tick <= tick) )
+		{
+			expectedCircles.insert( events[nextEvent].ripple );
+			actualCircles.insert( events[nextEvent].ripple );
+			nextEvent++;
+		}
+		BaselineTick(expectedShips, expectedCircles, worldBounds);
+		AdvanceTick(actualShips, actualCircles, engine);
+
+		if (HashShipState(expectedShips, tolerance) != HashShipState(actualShips, tolerance))
+		{
+			int ship = FirstMismatchedShip(expectedShips, actualShips, tolerance, report.expected, report.actual);
+			if (ship != expectedShips.getSize())
+			{
+				report.diverged = true;
+				report.tick = tick;
+				report.ship = ship;
+				return report;
+			}
+		}
+	}
+	return report;
+}
+
+
+/* Function to fuzz every engine, and every exact rule set, */
+/* against BaselineTick for "nbrCases" cases. Case i is     */
+/* generated from seed + i and printed with that seed when  */
+/* any engine disagrees. The number of mismatches found is  */
+/* returned.                                                */
+int FuzzEngines(int nbrCases, unsigned int seed)
+{
+	WorldBounds saved = worldBounds;
+	vector<const SimulationEngine *> checked;
+	int mismatches = 0;
+
+	for (int e = 0; e < NBR_ENGINES; e++)
+		checked.push_back(&ENGINES[e]);
+	for (int r = 0; r < NBR_RULE_SETS; r++)
+		if (RULE_SETS[r].exact)
+			checked.push_back(&RULE_SETS[r]);
+
+	worldBounds.width = FUZZ_WORLD_SIZE;
+	worldBounds.height = FUZZ_WORLD_SIZE;
+	for (int c = 0; c < nbrCases; c++)
+	{
+		mt19937 rng(seed + c);
+		LinkedList<Ship> shipList;
+		LinkedList<Ripple> circleList;
+		vector<RippleEvent> events;
+		long nbrTicks = 1 + long(rng() % FUZZ_MAX_TICKS);
+
+		GenerateFuzzShips(shipList, int(rng() % (FUZZ_MAX_SHIPS + 1)), FUZZ_WORLD_SIZE, FUZZ_WORLD_SIZE, rng);
+		GenerateRippleEvents(events, nbrTicks, 1 + int(rng() % FUZZ_MAX_ODDS),
+							 FUZZ_WORLD_SIZE, FUZZ_WORLD_SIZE, rng);
+		AimRipplesAtShips(events, shipList, rng);
+		worldBounds.wrap = (c % 2 == 1);
+
+		for (int e = 0; e < int(checked.size()); e++)
+		{
+			float tolerance = checked[e]->exact ? 0.0f : LOCKSTEP_TOLERANCE;
+			DivergenceReport report = RunAgainstBaseline(*checked[e], shipList, circleList,
+														 events, nbrTicks, tolerance);
+			if (report.diverged)
+			{
+				mismatches++;
+				printf("MISMATCH: engine %s, seed %u%s, tick %ld, ship %d\n",
+					   checked[e]->name, seed + c, worldBounds.wrap ? " (torus)" : "", report.tick, report.ship);
+			}
+		}
+	}
+	worldBounds = saved;
+	printf("%d cases, %d engines checked, %d mismatches\n", nbrCases, int(checked.size()), mismatches);
+	return mismatches;
+}
@@ -0,0 +1,38 @@
+/////////////////////////////////////////////////////////////////
+// Definition file: Fuzzer.h                                   //
+//                                                             //
+// This file declares the differential fuzzer, which builds    //
+// random ship populations and ripple event streams and runs   //
+// each of them through every engine in lockstep with a        //
+// standalone list-based reference, a copy of the original     //
+// program's loop.  Every case is generated from its own       //
+// seed, so any mismatch it reports can be replayed on its     //
+// own.                                                        //
+/////////////////////////////////////////////////////////////////
+
+#ifndef FUZZER_H
+
+#include "StateHash.h"
+#include <random>
+#include <vector>
+
+const int  FUZZ_MAX_SHIPS	= 600;		// Largest Population  //
+const long FUZZ_MAX_TICKS	= 150;		// Longest Case        //
+const int  FUZZ_MAX_ODDS	= 8;		// Sparsest Ripple Rate //
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+void GenerateFuzzShips(LinkedList<Ship> &shipList, int nbrShips, float width, float height,
+					   std::mt19937 &rng);
+void GenerateRippleEvents(std::vector<RippleEvent> &events, long nbrTicks, int odds,
+						  float width, float height, std::mt19937 &rng);
+void AimRipplesAtShips(std::vector<RippleEvent> &events, LinkedList<Ship> &shipList, std::mt19937 &rng);
+void BaselineTick(LinkedList<Ship> &shipList, LinkedList<Ripple> &circleList, const WorldBounds &bounds);
+DivergenceReport RunAgainstBaseline(const SimulationEngine &engine,
+									LinkedList<Ship> &shipList, LinkedList<Ripple> &circleList,
+									const std::vector<RippleEvent> &events, long nbrTicks, float tolerance);
+int FuzzEngines(int nbrCases, unsigned int seed);
+
+#define FUZZER_H
+#endif
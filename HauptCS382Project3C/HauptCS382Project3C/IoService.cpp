@@ -0,0 +1,271 @@
+/////////////////////////////////////////////////////////////////
+// Class implementation file: IoService.cpp                    //
+//                                                             //
+// The files are unbuffered, so each registered buffer goes    //
+// straight to the operating system with no further copy.  A   //
+// close is queued like a write, so it happens only after the  //
+// stream's earlier writes.  The buffers and the service       //
+// thread are created with the first use of the shared         //
+// service, so runs that never write pay nothing for them.     //
+/////////////////////////////////////////////////////////////////
+
+#include "IoService.h"
+#include <cstring>
+#include "BinaryLog.h"
+
+////////////////////////////////////////////////////////
+// Constructor: Carves the arena into buffers, all of //
+// them free, and starts the service thread.          //
+////////////////////////////////////////////////////////
+IoService::IoService()
+{
+	arena.resize(size_t(NBR_IO_BUFFERS) * IO_BUFFER_SIZE);
+	for (int b = NBR_IO_BUFFERS - 1; b >= 0; b--)
+		freeBuffers.push_back(&arena[size_t(b) * IO_BUFFER_SIZE]);
+	for (int s = 0; s < MAX_IO_STREAMS; s++)
+	{
+		files[s] = NULL;
+		streamInUse[s] = false;
+	}
+	inFlight = 0;
+	stopping = false;
+	bytesWritten.store(0);
+	batches.store(0);
+	stalls.store(0);
+	failedWrites.store(0);
+	worker = std::thread([this]() { serviceLoop(); });
+}
+
+////////////////////////////////////////////////////////////
+// Destructor: Writes everything still queued, stops the  //
+// service thread and closes any stream left open.        //
+////////////////////////////////////////////////////////////
+IoService::~IoService()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	wake.notify_one();
+	worker.join();
+	for (int s = 0; s < MAX_IO_STREAMS; s++)
+		if (files[s] != NULL)
+			fclose(files[s]);
+}
+
+/////////////////////////////////////////////////////////
+// Function to open a file for writing, returning its  //
+// stream number (or -1 if it cannot be opened).       //
+/////////////////////////////////////////////////////////
+int IoService::openStream(const char *path)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	for (int s = 0; s < MAX_IO_STREAMS; s++)
+		if (!streamInUse[s])
+		{
+			files[s] = fopen(path, "wb");
+			if (files[s] == NULL)
+				return -1;
+			setvbuf(files[s], NULL, _IONBF, 0);
+			streamInUse[s] = true;
+			return s;
+		}
+	return -1;
+}
+
+//////////////////////////////////////////////////////////
+// Function to close a stream once its writes are done. //
+//////////////////////////////////////////////////////////
+void IoService::closeStream(int stream)
+{
+	request close = { stream, NULL, 0 };
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		pending.push_back(close);
+		inFlight++;
+	}
+	wake.notify_one();
+}
+
+////////////////////////////////////////////////////////////
+// Function to claim "count" registered buffers at once.  //
+// Either all are claimed or, if too few are free, none   //
+// are and a stall is counted; the caller never waits.    //
+////////////////////////////////////////////////////////////
+bool IoService::acquireBuffers(int count, char *buffers[])
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	if (int(freeBuffers.size()) < count)
+	{
+		LOG_EVENT("io stall: %d buffers wanted, %d free", count, int(freeBuffers.size()));
+		stalls++;
+		return false;
+	}
+	for (int b = 0; b < count; b++)
+	{
+		buffers[b] = freeBuffers.back();
+		freeBuffers.pop_back();
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////
+// Function to queue a filled buffer for writing.  The  //
+// buffer returns to the free set once it is written.   //
+//////////////////////////////////////////////////////////
+void IoService::submit(int stream, char *buffer, int length)
+{
+	request write = { stream, buffer, length };
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		pending.push_back(write);
+		inFlight++;
+	}
+	wake.notify_one();
+}
+
+//////////////////////////////////////////////////////////
+// Function to copy data of any length into as many     //
+// buffers as it needs and submit them, returning false //
+// (having written nothing) when the buffers run short. //
+// Data larger than every buffer together could never   //
+// be claimed at once, so it is instead written in      //
+// successive claims, each waiting for written buffers  //
+// to come back: it stalls the caller (and is counted   //
+// as a stall) but is never dropped.                    //
+//////////////////////////////////////////////////////////
+bool IoService::write(int stream, const void *data, int length)
+{
+	int count = (length + IO_BUFFER_SIZE - 1) / IO_BUFFER_SIZE;
+	std::vector<char *> buffers( (count < NBR_IO_BUFFERS) ? count : NBR_IO_BUFFERS );
+	const char *bytes = (const char *)data;
+
+	if (count == 0)
+		return true;
+	if (count <= NBR_IO_BUFFERS)
+	{
+		if (!acquireBuffers(count, &buffers[0]))
+			return false;
+		fill(stream, &buffers[0], count, bytes, length);
+		return true;
+	}
+
+	LOG_EVENT("io stall: %d bytes exceed the buffers, written in parts", length);
+	stalls++;
+	while (length > 0)
+	{
+		int part = (count < NBR_IO_BUFFERS) ? count : NBR_IO_BUFFERS;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			drained.wait(guard, [this, part]() { return int(freeBuffers.size()) >= part; });
+			for (int b = 0; b < part; b++)
+			{
+				buffers[b] = freeBuffers.back();
+				freeBuffers.pop_back();
+			}
+		}
+		fill(stream, &buffers[0], part, bytes, length);
+		count -= part;
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////
+// Function to copy as much of "bytes" as "count"       //
+// claimed buffers hold into them and submit them,      //
+// advancing "bytes" and "length" past what was taken.  //
+//////////////////////////////////////////////////////////
+void IoService::fill(int stream, char *buffers[], int count, const char *&bytes, int &length)
+{
+	for (int b = 0; (b < count) && (length > 0); b++)
+	{
+		int chunk = (length < IO_BUFFER_SIZE) ? length : IO_BUFFER_SIZE;
+		memcpy(buffers[b], bytes, chunk);
+		submit(stream, buffers[b], chunk);
+		bytes += chunk;
+		length -= chunk;
+	}
+}
+
+//////////////////////////////////////////////////////
+// Function to wait until every submission so far   //
+// has been written.                                //
+//////////////////////////////////////////////////////
+void IoService::flush()
+{
+	std::unique_lock<std::mutex> guard(lock);
+	drained.wait(guard, [this]() { return inFlight == 0; });
+}
+
+////////////////////////////////////////////
+// Function to report the service's state. //
+////////////////////////////////////////////
+IoStats IoService::getStats()
+{
+	IoStats stats;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stats.buffersInUse = NBR_IO_BUFFERS - long(freeBuffers.size());
+	}
+	stats.bytesWritten = bytesWritten.load();
+	stats.batches = batches.load();
+	stats.stalls = stalls.load();
+	stats.failedWrites = failedWrites.load();
+	return stats;
+}
+
+////////////////////////////////////////////////////////////
+// The service thread: takes the whole queue as a batch,  //
+// writes it in submission order without holding the      //
+// lock, then frees its buffers and streams in one go.    //
+////////////////////////////////////////////////////////////
+void IoService::serviceLoop()
+{
+	std::vector<request> batch;
+	std::unique_lock<std::mutex> guard(lock);
+
+	for (;;)
+	{
+		wake.wait(guard, [this]() { return stopping || !pending.empty(); });
+		if (pending.empty())
+			return;
+		batch.swap(pending);
+		guard.unlock();
+
+		for (int r = 0; r < int(batch.size()); r++)
+		{
+			FILE *file = files[batch[r].stream];
+			if (batch[r].buffer == NULL)
+				fclose(file);
+			else if (fwrite(batch[r].buffer, 1, batch[r].length, file) == size_t(batch[r].length))
+				bytesWritten += batch[r].length;
+			else
+				failedWrites++;
+		}
+		batches++;
+
+		guard.lock();
+		for (int r = 0; r < int(batch.size()); r++)
+			if (batch[r].buffer == NULL)
+			{
+				files[batch[r].stream] = NULL;
+				streamInUse[batch[r].stream] = false;
+			}
+			else
+				freeBuffers.push_back(batch[r].buffer);
+		inFlight -= int(batch.size());
+		batch.clear();
+		drained.notify_all();
+	}
+}
+
+
+/* The service shared by every writer in the program, */
+/* created on first use.                              */
+IoService &SharedIoService()
+{
+	static IoService service;
+	return service;
+}
@@ -0,0 +1,106 @@
+/////////////////////////////////////////////////////////////////
+// Class definition file: IoService.h                          //
+//                                                             //
+// This file defines the IoService class, the one shared       //
+// asynchronous writer behind trajectory recording, checkpoints //
+// and frame capture.  Data is written from a fixed set of     //
+// registered buffers: a writer claims buffers, fills them,    //
+// and submits them with a stream; a single service thread     //
+// takes every submission queued since its last pass as one    //
+// batch, writes it, and returns the buffers.  Claiming never  //
+// blocks the tick thread; when too few buffers are free the   //
+// claim fails and is counted as a stall, which is how the     //
+// service reports backpressure.  Only a write larger than all //
+// the buffers together waits, claiming them as they return.   //
+/////////////////////////////////////////////////////////////////
+
+#ifndef IO_SERVICE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include "MemoryAccounting.h"
+#include <mutex>
+#include <thread>
+#include <vector>
+
+const int IO_BUFFER_SIZE	= 1 << 20;	// Bytes Per Buffer       //
+const int NBR_IO_BUFFERS	= 32;		// Registered Buffers     //
+const int MAX_IO_STREAMS	= 16;		// Files Open At Once     //
+
+//////////////////////////////////////////////////////////
+// Counters for the service since it started: what it   //
+// has written, in how many batches, how many buffers   //
+// are in flight now, and how many claims have failed.  //
+//////////////////////////////////////////////////////////
+struct IoStats
+{
+	long long bytesWritten;
+	long batches;
+	long buffersInUse;
+	long stalls;
+	long failedWrites;
+};
+
+/////////////////////////////////////////////
+// DECLARATION SECTION FOR IO SERVICE CLASS //
+/////////////////////////////////////////////
+
+class IoService
+{
+	public:
+		// Class constructor and destructor
+		IoService();
+		~IoService();
+
+		// Member functions (tick thread)
+		int openStream(const char *path);
+		void closeStream(int stream);
+		bool acquireBuffers(int count, char *buffers[]);
+		void submit(int stream, char *buffer, int length);
+		bool write(int stream, const void *data, int length);
+		void flush();
+		IoStats getStats();
+
+	protected:
+		// Data members
+
+		struct request
+		{
+			int stream;
+			char *buffer;		// NULL for a close request. //
+			int length;
+		};
+
+		std::vector<char, TaggedAllocator<char, recorderMemory> > arena;	// The registered buffers. //
+		std::vector<char *> freeBuffers;
+		std::vector<request> pending;
+		FILE *files[MAX_IO_STREAMS];
+		bool streamInUse[MAX_IO_STREAMS];
+		int inFlight;						// Submitted, not yet written.  //
+		std::mutex lock;
+		std::condition_variable wake;
+		std::condition_variable drained;
+		std::thread worker;
+		bool stopping;
+		std::atomic<long long> bytesWritten;
+		std::atomic<long> batches;
+		std::atomic<long> stalls;
+		std::atomic<long> failedWrites;
+
+		// Member functions
+		void fill(int stream, char *buffers[], int count, const char *&bytes, int &length);
+		void serviceLoop();
+
+	private:
+		// The service owns a thread and its buffers, so it is never copied.
+		IoService(const IoService &service);
+};
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+IoService &SharedIoService();
+
+#define IO_SERVICE_H
+#endif
@@ -7,11 +7,16 @@
 // member functions include constructors, a destructor, and    //
 // standard isEmpty, getHeadValue, and getSize functions.      //
 // Insertion and removal always occur at the head of the list. //
+//                                                             //
+// Nodes are counted against the memory tag of E (see          //
+// MemoryAccounting.h) from allocation until they are freed.   //
 /////////////////////////////////////////////////////////////////
 
 #ifndef LINKED_LIST_H
 
 #include <assert.h>
+#include <cstddef>
+#include "MemoryAccounting.h"
 
 ////////////////////////////////////////////////////////
 // DECLARATION SECTION FOR LINKED LIST CLASS TEMPLATE //
@@ -33,6 +38,8 @@ template <class E> class LinkedList
 		E getHeadNextValue();
 		int getSize();
 		LinkedList<E>& operator ++ ();
+		template <class F> void visit(F visitor);
+		static int getNodeBytes();
 	
 	protected:
 		// Data members
@@ -73,16 +80,17 @@ LinkedList<E>::LinkedList()
 template <class E>
 LinkedList<E>::LinkedList(const LinkedList<E> &list)
 {
-	nodePtr copyPreviousPtr, copyCurrentPtr, origCurrentPtr;
+	nodePtr copyHeadPtr, copyPreviousPtr, copyCurrentPtr, origCurrentPtr;
+	nodePtr origHeadPtr = list.head;
 	size = list.size;
-	if (list.head == NULL)
+	if (origHeadPtr == NULL)
 		head = NULL;
 	else
 	{
-		head = (nodePtr)getNode(list.head->data);
-		copyPreviousPtr = head;
-		origCurrentPtr = list.head->next;
-		while (origCurrentPtr != list.head)
+		copyHeadPtr = (nodePtr)getNode(origHeadPtr->data);
+		copyPreviousPtr = copyHeadPtr;
+		origCurrentPtr = origHeadPtr->next;
+		while (origCurrentPtr != origHeadPtr)
 		{
 			copyCurrentPtr = (nodePtr)getNode(origCurrentPtr->data);
 			copyPreviousPtr->next = copyCurrentPtr;
@@ -90,8 +98,9 @@ LinkedList<E>::LinkedList(const LinkedList<E> &list)
 			copyPreviousPtr = copyCurrentPtr;
 			origCurrentPtr = origCurrentPtr->next;
 		}
-		copyPreviousPtr->next = head;
-		head->previous = copyPreviousPtr;
+		copyPreviousPtr->next = copyHeadPtr;
+		copyHeadPtr->previous = copyPreviousPtr;
+		head = copyHeadPtr;
 	}
 }
 
@@ -105,14 +114,15 @@ LinkedList<E>::~LinkedList()
 	while (head != NULL)
 	{
 		ptr = head;
-		if (head == head->next)
+		if (ptr == ptr->next)
 			head = NULL;
 		else
 		{
-			head = head->next;
+			head = ptr->next;
 			head->previous = ptr->previous;
-			head->previous->next = head;
+			ptr->previous->next = ptr->next;
 		}
+		CountRelease(MemoryTagOf<E>::tag, sizeof(node));
 		delete ptr;
 	}
 }
@@ -132,24 +142,23 @@ bool LinkedList<E>::isEmpty()
 template <class E>
 void LinkedList<E>::insert(E item)
 {
-	nodePtr insertPtr;
+	nodePtr insertPtr, headPtr = head;
 
-	size++;
 	insertPtr = (nodePtr)getNode(item);
-	if (head == NULL)
+	if (headPtr == NULL)
 	{
-		head = insertPtr;
-		head->next = head;
-		head->previous = head;
+		insertPtr->next = insertPtr;
+		insertPtr->previous = insertPtr;
 	}
 	else
 	{
-		insertPtr->next = head;
-		insertPtr->previous = head->previous;
-		head->previous->next = insertPtr;
-		head->previous = insertPtr;
-		head = insertPtr;
+		insertPtr->next = headPtr;
+		insertPtr->previous = headPtr->previous;
+		headPtr->previous->next = insertPtr;
+		headPtr->previous = insertPtr;
 	}
+	head = insertPtr;
+	size++;
 
 	return;
 }
@@ -162,28 +171,25 @@ void LinkedList<E>::insert(E item)
 template <class E>
 bool LinkedList<E>::removeHead()
 {
-	nodePtr currentPtr;
+	nodePtr currentPtr = head;
 
-	if ( ( size == 0) || (head == NULL) )
+	if ( ( size == 0) || (currentPtr == NULL) )
 		return false;
+	if (currentPtr->next == currentPtr)
+	{
+		size = 0;
+		head = NULL;
+	}
 	else
 	{
-		currentPtr = head;
-		if (head->next == head)
-		{
-			size = 0;
-			head = NULL;
-		}
-		else
-		{
-			size--;
-			head = currentPtr->next;
-			head->previous = currentPtr->previous;
-			currentPtr->previous->next = head;
-		}
-		delete currentPtr;
-		return true;
+		size--;
+		head = currentPtr->next;
+		head->previous = currentPtr->previous;
+		currentPtr->previous->next = currentPtr->next;
 	}
+	CountRelease(MemoryTagOf<E>::tag, sizeof(node));
+	delete currentPtr;
+	return true;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -229,6 +235,23 @@ LinkedList<E>& LinkedList<E>::operator ++ ()
 	return *this;
 }
 
+////////////////////////////////////////////////////////////////
+// Function visit hands a reference to each value in turn to  //
+// "visitor", starting at the head, without moving the head.  //
+////////////////////////////////////////////////////////////////
+template <class E>
+template <class F>
+void LinkedList<E>::visit(F visitor)
+{
+	nodePtr currentPtr = head;
+
+	for (int i = 0; (i < size) && (currentPtr != NULL); i++)
+	{
+		visitor(currentPtr->data);
+		currentPtr = currentPtr->next;
+	}
+}
+
 //////////////////////////////////////////////////////////////////
 // Function to generate a new node with the data value provided //
 // in parameter item, and returning a pointer to this new node. //
@@ -239,12 +262,23 @@ void* LinkedList<E>::getNode(E item)
 	nodePtr temp = new node;
 
 	assert(temp != NULL);
+	CountAllocation(MemoryTagOf<E>::tag, sizeof(node));
 	temp->data = item;
 	temp->next = NULL;
 	temp->previous = NULL;
 	return temp;
 }
 
+//////////////////////////////////////////////////////
+// Function getNodeBytes returns the memory used by //
+// each value held in the list.                     //
+//////////////////////////////////////////////////////
+template <class E>
+int LinkedList<E>::getNodeBytes()
+{
+	return int(sizeof(node));
+}
+
 #define LINKED_LIST_H
 #endif
 
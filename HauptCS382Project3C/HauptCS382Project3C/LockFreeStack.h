@@ -0,0 +1,166 @@
+/////////////////////////////////////////////////////////////////
+// Class definition file: LockFreeStack.h                      //
+//                                                             //
+// This file defines the LockFreeStack class template, an      //
+// intrusive Treiber stack of nodes containing values of type  //
+// E.  Any number of producer threads may push values without  //
+// locking, while a single consumer thread drains the entire   //
+// stack in one atomic exchange, receiving the values in the   //
+// order in which they were pushed.  Because the consumer only //
+// ever detaches the whole stack, no ABA hazard can arise.     //
+/////////////////////////////////////////////////////////////////
+
+#ifndef LOCK_FREE_STACK_H
+
+#include <assert.h>
+#include <atomic>
+#include "LinkedList.h"
+
+/////////////////////////////////////////////////////////////
+// DECLARATION SECTION FOR LOCK-FREE STACK CLASS TEMPLATE //
+/////////////////////////////////////////////////////////////
+
+template <class E> class LockFreeStack
+{
+	public:
+		// Class constructor and destructor
+		LockFreeStack();
+		~LockFreeStack();
+
+		// Member functions
+		bool isEmpty();
+		void push(E item);
+		int drainInto(LinkedList<E> &list);
+
+	protected:
+		// Data members
+
+		struct node;
+		typedef node *nodePtr;
+		struct node
+		{
+			E data;
+			nodePtr next;
+		};
+
+		std::atomic<nodePtr> head;
+
+		// Member function
+		void* getNode(E item);
+
+	private:
+		// Stacks are shared between threads, never copied.
+		LockFreeStack(const LockFreeStack<E> &stack);
+};
+
+///////////////////////////////////////////////
+// IMPLEMENTATION SECTION FOR CLASS TEMPLATE //
+///////////////////////////////////////////////
+
+///////////////////////////////////////////////
+// Default constructor: Sets up empty stack. //
+///////////////////////////////////////////////
+template <class E>
+LockFreeStack<E>::LockFreeStack()
+{
+	head.store(NULL);
+}
+
+///////////////////////////////////////////////////////////
+// Destructor: Frees any values that were never drained. //
+///////////////////////////////////////////////////////////
+template <class E>
+LockFreeStack<E>::~LockFreeStack()
+{
+	nodePtr ptr = head.exchange(NULL);
+	while (ptr != NULL)
+	{
+		nodePtr nextPtr = ptr->next;
+		CountRelease(MemoryTagOf<E>::tag, sizeof(node));
+		delete ptr;
+		ptr = nextPtr;
+	}
+}
+
+///////////////////////////////////////////////////////
+// Function to determine whether the stack is empty. //
+// The answer may be stale as soon as it is returned //
+// if producers are still pushing.                   //
+///////////////////////////////////////////////////////
+template <class E>
+bool LockFreeStack<E>::isEmpty()
+{
+	return (head.load(std::memory_order_acquire) == NULL);
+}
+
+//////////////////////////////////////////////////////////
+// Function to push value "item" onto the stack.  Safe  //
+// to call from any number of threads at once; a failed //
+// compare-exchange reloads the head and simply retries. //
+//////////////////////////////////////////////////////////
+template <class E>
+void LockFreeStack<E>::push(E item)
+{
+	nodePtr insertPtr = (nodePtr)getNode(item);
+
+	insertPtr->next = head.load(std::memory_order_relaxed);
+	while (!head.compare_exchange_weak(insertPtr->next, insertPtr,
+									   std::memory_order_release,
+									   std::memory_order_relaxed))
+		;
+	return;
+}
+
+//////////////////////////////////////////////////////////////
+// Function to detach every pushed value in one exchange    //
+// and insert them into "list" in the order they were       //
+// pushed, so the list ends up exactly as if each value had //
+// been inserted directly.  Only one thread may drain a     //
+// given stack.  The number of values moved is returned.    //
+//////////////////////////////////////////////////////////////
+template <class E>
+int LockFreeStack<E>::drainInto(LinkedList<E> &list)
+{
+	nodePtr chain = head.exchange(NULL, std::memory_order_acquire);
+	nodePtr reversed = NULL;
+	int count = 0;
+
+	// The chain is newest-first; reverse it to recover arrival order. //
+	while (chain != NULL)
+	{
+		nodePtr nextPtr = chain->next;
+		chain->next = reversed;
+		reversed = chain;
+		chain = nextPtr;
+	}
+
+	while (reversed != NULL)
+	{
+		nodePtr nextPtr = reversed->next;
+		list.insert(reversed->data);
+		CountRelease(MemoryTagOf<E>::tag, sizeof(node));
+		delete reversed;
+		reversed = nextPtr;
+		count++;
+	}
+	return count;
+}
+
+//////////////////////////////////////////////////////////////////
+// Function to generate a new node with the data value provided //
+// in parameter item, and returning a pointer to this new node. //
+//////////////////////////////////////////////////////////////////
+template <class E>
+void* LockFreeStack<E>::getNode(E item)
+{
+	nodePtr temp = new node;
+
+	assert(temp != NULL);
+	CountAllocation(MemoryTagOf<E>::tag, sizeof(node));
+	temp->data = item;
+	temp->next = NULL;
+	return temp;
+}
+
+#define LOCK_FREE_STACK_H
+#endif
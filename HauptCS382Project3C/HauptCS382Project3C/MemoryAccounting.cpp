@@ -0,0 +1,108 @@
+/********************************************************************/
+/* Filename: MemoryAccounting.cpp                                   */
+/*                                                                  */
+/* Per-tag byte counters. Allocations happen on the worker and I/O  */
+/* threads as well as the tick thread, so the counters are atomic;  */
+/* the peak is raised with a compare-and-swap loop.                 */
+/********************************************************************/
+
+#include "MemoryAccounting.h"
+#include <atomic>
+#include <cstdio>			// Header File For String Formatting       //
+#include <cstring>			// Header File For String Operations       //
+
+const char *MEMORY_TAG_NAMES[NBR_MEMORY_TAGS] = { "ships", "ripples", "index", "render", "recorders", "other" };
+
+std::atomic<long long> liveBytes[NBR_MEMORY_TAGS];
+std::atomic<long long> peakBytes[NBR_MEMORY_TAGS];
+std::atomic<long long> budgetBytes[NBR_MEMORY_TAGS];	// Zero: no budget. //
+
+
+/* Function to count an allocation of "bytes" against "tag". */
+void CountAllocation(memoryTag tag, size_t bytes)
+{
+	long long live = liveBytes[tag].fetch_add( (long long)bytes, std::memory_order_relaxed ) + (long long)bytes;
+	long long peak = peakBytes[tag].load(std::memory_order_relaxed);
+
+	while ( (live > peak) && !peakBytes[tag].compare_exchange_weak(peak, live, std::memory_order_relaxed) )
+		;
+}
+
+
+/* Function to count the release of "bytes" from "tag". */
+void CountRelease(memoryTag tag, size_t bytes)
+{
+	liveBytes[tag].fetch_sub( (long long)bytes, std::memory_order_relaxed );
+}
+
+
+/* Functions to report a tag's current and highest usage. */
+long long GetLiveBytes(memoryTag tag)	{ return liveBytes[tag].load(std::memory_order_relaxed); }
+long long GetPeakBytes(memoryTag tag)	{ return peakBytes[tag].load(std::memory_order_relaxed); }
+
+
+/* Function to set a tag's soft budget; zero removes it. */
+void SetMemoryBudget(memoryTag tag, long long bytes)
+{
+	budgetBytes[tag].store(bytes);
+}
+
+
+/* Function to report a tag's soft budget (zero: none). */
+long long GetMemoryBudget(memoryTag tag)
+{
+	return budgetBytes[tag].load();
+}
+
+
+/* Function to tell whether a tag's usage exceeds its budget. */
+bool IsOverBudget(memoryTag tag)
+{
+	long long budget = budgetBytes[tag].load(std::memory_order_relaxed);
+	return (budget > 0) && (liveBytes[tag].load(std::memory_order_relaxed) > budget);
+}
+
+
+/* Function to name a tag, as shown in telemetry. */
+const char *MemoryTagName(memoryTag tag)
+{
+	return MEMORY_TAG_NAMES[tag];
+}
+
+
+/* Function to look a tag up by name, returning false */
+/* if no tag of that name exists.                     */
+bool FindMemoryTag(const char *name, memoryTag &tag)
+{
+	for (int t = 0; t < NBR_MEMORY_TAGS; t++)
+		if (strcmp(MEMORY_TAG_NAMES[t], name) == 0)
+		{
+			tag = memoryTag(t);
+			return true;
+		}
+	return false;
+}
+
+
+/* Function to summarize the tags in use (live/peak, in */
+/* kilobytes) in "buffer", returning the length written. */
+int FormatMemoryUsage(char *buffer, int size)
+{
+	int length = 0;
+
+	if (size > 0)
+		buffer[0] = '\0';
+	for (int t = 0; (t < NBR_MEMORY_TAGS) && (length < size); t++)
+	{
+		if (peakBytes[t].load() == 0)
+			continue;
+		int written = snprintf(buffer + length, size - length, "%s%s %lld/%lldK%s",
+							   (length > 0) ? ", " : "", MEMORY_TAG_NAMES[t],
+							   liveBytes[t].load() / 1024, peakBytes[t].load() / 1024,
+							   IsOverBudget(memoryTag(t)) ? "!" : "");
+		if (written < 0)
+			break;
+		length += written;
+	}
+	return (length < size) ? length : size - 1;
+}
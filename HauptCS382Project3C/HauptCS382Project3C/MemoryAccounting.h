@@ -0,0 +1,82 @@
+/////////////////////////////////////////////////////////////////
+// Definition file: MemoryAccounting.h                         //
+//                                                             //
+// This file declares the memory accounting: every allocation  //
+// made by the lists, indices and buffers is counted against   //
+// a tag naming the subsystem that owns it, with the live and  //
+// peak byte counts kept per tag.  A tag may also be given a   //
+// soft budget; nothing is refused when it is exceeded, but    //
+// the owning subsystem can see it and shed load instead.      //
+//                                                             //
+// Containers opt in through TaggedAllocator; the list node    //
+// types find their tag through MemoryTagOf, which element     //
+// types specialize.                                           //
+/////////////////////////////////////////////////////////////////
+
+#ifndef MEMORY_ACCOUNTING_H
+
+#include <cstddef>
+#include <new>
+
+enum memoryTag { shipMemory, rippleMemory, indexMemory, renderMemory, recorderMemory, otherMemory };
+
+const int NBR_MEMORY_TAGS = 6;		// # Of Memory Tags //
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+void CountAllocation(memoryTag tag, size_t bytes);
+void CountRelease(memoryTag tag, size_t bytes);
+long long GetLiveBytes(memoryTag tag);
+long long GetPeakBytes(memoryTag tag);
+void SetMemoryBudget(memoryTag tag, long long bytes);
+long long GetMemoryBudget(memoryTag tag);
+bool IsOverBudget(memoryTag tag);
+const char *MemoryTagName(memoryTag tag);
+bool FindMemoryTag(const char *name, memoryTag &tag);
+int FormatMemoryUsage(char *buffer, int size);
+
+//////////////////////////////////////////////////////////
+// The tag for the nodes of a list or stack of E;       //
+// element types that belong to a subsystem specialize  //
+// this alongside their definition.                     //
+//////////////////////////////////////////////////////////
+template <class E> struct MemoryTagOf
+{
+	static const memoryTag tag = otherMemory;
+};
+
+///////////////////////////////////////////////////////////
+// DECLARATION AND IMPLEMENTATION OF THE TAGGED ALLOCATOR //
+///////////////////////////////////////////////////////////
+
+template <class T, memoryTag Tag> class TaggedAllocator
+{
+	public:
+		typedef T value_type;
+		template <class U> struct rebind { typedef TaggedAllocator<U, Tag> other; };
+
+		TaggedAllocator() {}
+		template <class U> TaggedAllocator(const TaggedAllocator<U, Tag> &) {}
+
+		T *allocate(size_t n)
+		{
+			T *block = static_cast<T *>( ::operator new(n * sizeof(T)) );
+			CountAllocation(Tag, n * sizeof(T));
+			return block;
+		}
+
+		void deallocate(T *block, size_t n)
+		{
+			CountRelease(Tag, n * sizeof(T));
+			::operator delete(block);
+		}
+};
+
+template <class T, class U, memoryTag Tag>
+bool operator == (const TaggedAllocator<T, Tag> &, const TaggedAllocator<U, Tag> &)	{ return true; }
+template <class T, class U, memoryTag Tag>
+bool operator != (const TaggedAllocator<T, Tag> &, const TaggedAllocator<U, Tag> &)	{ return false; }
+
+#define MEMORY_ACCOUNTING_H
+#endif
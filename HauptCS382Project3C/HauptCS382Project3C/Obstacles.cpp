@@ -0,0 +1,288 @@
+/////////////////////////////////////////////////////////////////
+// Class implementation file: Obstacles.cpp                    //
+//                                                             //
+// Baking measures the exact distance from every grid node to  //
+// every obstacle, rows of nodes being shared out among the    //
+// worker pool, and takes the least; a point inside any        //
+// obstacle gets the negated distance to its edge, so that the //
+// field of several obstacles is their union.  Gradients are   //
+// then taken by central differences (one-sided at the edges   //
+// of the grid).  A sample interpolates the four nodes around  //
+// a point bilinearly; points beyond the grid take its edge.   //
+/////////////////////////////////////////////////////////////////
+
+#include "Obstacles.h"
+#include "WorkerPool.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+using namespace std;
+
+const int MAX_OBSTACLE_LINE = 4096;	// Longest Line In A File //
+
+//////////////////////////////////////////////////////
+// IMPLEMENTATION SECTION FOR OBSTACLE FIELD CLASS  //
+//////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////
+// Default constructor: Not baked, no nodes.   //
+/////////////////////////////////////////////////
+ObstacleField::ObstacleField()
+{
+	columns = rows = 0;
+	left = bottom = 0.0f;
+	cellSize = SDF_CELL;
+}
+
+//////////////////////////////////////////////////////////
+// Function to bake the obstacles into a grid over the  //
+// world, of cells SDF_CELL across (coarser if need be, //
+// to keep to MAX_SDF_SIDE cells a side). No obstacles  //
+// leave the field unbaked.                             //
+//////////////////////////////////////////////////////////
+void ObstacleField::bake(const vector<Obstacle> &obstacles, const WorldBounds &bounds)
+{
+	float side = (bounds.width > bounds.height) ? bounds.width : bounds.height;
+
+	nodes.clear();
+	if (obstacles.empty())
+		return;
+	cellSize = (side / MAX_SDF_SIDE > SDF_CELL) ? side / MAX_SDF_SIDE : SDF_CELL;
+	columns = int(ceil(bounds.width / cellSize));
+	rows = int(ceil(bounds.height / cellSize));
+	columns = (columns < 1) ? 1 : columns;
+	rows = (rows < 1) ? 1 : rows;
+	left = -0.5f * bounds.width;
+	bottom = -0.5f * bounds.height;
+	nodes.resize(size_t(columns + 1) * (rows + 1));
+
+	SimulationPool().parallelFor(rows + 1, 1, [this, &obstacles](int begin, int end)
+	{
+		for (int r = begin; r < end; r++)
+			for (int c = 0; c <= columns; c++)
+			{
+				float x = left + c * cellSize, y = bottom + r * cellSize;
+				float nearest = ObstacleDistance(obstacles[0], x, y);
+				for (int o = 1; o < int(obstacles.size()); o++)
+				{
+					float distance = ObstacleDistance(obstacles[o], x, y);
+					if (distance < nearest)
+						nearest = distance;
+				}
+				nodes[size_t(r) * (columns + 1) + c].distance = nearest;
+			}
+	});
+
+	SimulationPool().parallelFor(rows + 1, 1, [this](int begin, int end)
+	{
+		for (int r = begin; r < end; r++)
+			for (int c = 0; c <= columns; c++)
+			{
+				int c0 = (c > 0) ? c - 1 : c, c1 = (c < columns) ? c + 1 : c;
+				int r0 = (r > 0) ? r - 1 : r, r1 = (r < rows) ? r + 1 : r;
+				node &n = nodes[size_t(r) * (columns + 1) + c];
+				float gx = (nodes[size_t(r) * (columns + 1) + c1].distance -
+							nodes[size_t(r) * (columns + 1) + c0].distance) / ((c1 - c0) * cellSize);
+				float gy = (nodes[size_t(r1) * (columns + 1) + c].distance -
+							nodes[size_t(r0) * (columns + 1) + c].distance) / ((r1 - r0) * cellSize);
+				float size = sqrt(gx * gx + gy * gy);
+
+				n.gradient[0] = (size > 0.0f) ? gx / size : 0.0f;
+				n.gradient[1] = (size > 0.0f) ? gy / size : 0.0f;
+			}
+	});
+}
+
+//////////////////////////////////////////////////
+// Function to tell whether there is a field.   //
+//////////////////////////////////////////////////
+bool ObstacleField::isBaked() const
+{
+	return !nodes.empty();
+}
+
+//////////////////////////////////////////////////////////
+// Function to sample the field at "pos": the signed    //
+// distance to the nearest obstacle and the (unit)      //
+// direction away from it, interpolated bilinearly.     //
+//////////////////////////////////////////////////////////
+void ObstacleField::sample(const float pos[], float &distance, float gradient[]) const
+{
+	float x = (pos[0] - left) / cellSize, y = (pos[1] - bottom) / cellSize;
+	int c, r;
+	float fx, fy, weights[4], size;
+	const node *corners[4];
+
+	x = (x < 0.0f) ? 0.0f : ((x > float(columns)) ? float(columns) : x);
+	y = (y < 0.0f) ? 0.0f : ((y > float(rows)) ? float(rows) : y);
+	c = (int(x) < columns) ? int(x) : columns - 1;
+	r = (int(y) < rows) ? int(y) : rows - 1;
+	fx = x - c;
+	fy = y - r;
+
+	corners[0] = &nodes[size_t(r) * (columns + 1) + c];
+	corners[1] = corners[0] + 1;
+	corners[2] = corners[0] + (columns + 1);
+	corners[3] = corners[2] + 1;
+	weights[0] = (1.0f - fx) * (1.0f - fy);
+	weights[1] = fx * (1.0f - fy);
+	weights[2] = (1.0f - fx) * fy;
+	weights[3] = fx * fy;
+
+	distance = gradient[0] = gradient[1] = 0.0f;
+	for (int k = 0; k < 4; k++)
+	{
+		distance += weights[k] * corners[k]->distance;
+		gradient[0] += weights[k] * corners[k]->gradient[0];
+		gradient[1] += weights[k] * corners[k]->gradient[1];
+	}
+	size = sqrt(gradient[0] * gradient[0] + gradient[1] * gradient[1]);
+	if (size > 0.0f)
+	{
+		gradient[0] /= size;
+		gradient[1] /= size;
+	}
+}
+
+//////////////////////////////////////////
+// IMPLEMENTATION SECTION FOR OBSTACLES //
+//////////////////////////////////////////
+
+/* Function to tell whether nothing but blanks is left of a */
+/* line from "p" on.                                        */
+static bool AtLineEnd(const char *p)
+{
+	while ( (*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n') )
+		p++;
+	return (*p == '\0');
+}
+
+
+/* Function to read the obstacles of a file, appending them  */
+/* to "obstacles". False is returned if the file cannot be   */
+/* read or has a malformed line (one with anything after its */
+/* numbers, say), whose number is then set in "badLine" (0   */
+/* if the file could not be opened).                         */
+bool LoadObstacles(const char *path, vector<Obstacle> &obstacles, int &badLine)
+{
+	FILE *file = fopen(path, "r");
+	char line[MAX_OBSTACLE_LINE];
+	int number = 0;
+
+	badLine = 0;
+	if (file == NULL)
+		return false;
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		char *p = line, *next;
+		Obstacle obstacle;
+
+		number++;
+		while ( (*p == ' ') || (*p == '\t') )
+			p++;
+		if ( (*p == '\0') || (*p == '\n') || (*p == '\r') || (*p == '#') )
+			continue;
+
+		if (strncmp(p, "circle", 6) == 0)
+		{
+			int used = 0;
+			int n = sscanf(p + 6, "%f %f %f%n", &obstacle.center[0], &obstacle.center[1], &obstacle.radius, &used);
+			if ( (n != 3) || !AtLineEnd(p + 6 + used) || (obstacle.radius <= 0.0f) )
+				badLine = number;
+		}
+		else if (strncmp(p, "polygon", 7) == 0)
+		{
+			for (p += 7; ; p = next)
+			{
+				float value = strtof(p, &next);
+				if (next == p)
+					break;
+				obstacle.vertices.push_back(value);
+			}
+			if ( !AtLineEnd(p) || (obstacle.vertices.size() < 6) || (obstacle.vertices.size() % 2 != 0) )
+				badLine = number;
+		}
+		else
+			badLine = number;
+
+		if (badLine != 0)
+			break;
+		obstacles.push_back(obstacle);
+	}
+	fclose(file);
+	return (badLine == 0);
+}
+
+
+/* Function to find the signed distance from (x, y) to an    */
+/* obstacle's edge: negative inside it. A polygon's inside   */
+/* is found by counting the edges a ray from the point       */
+/* crosses, so a self-crossing polygon follows the even-odd  */
+/* rule.                                                     */
+float ObstacleDistance(const Obstacle &obstacle, float x, float y)
+{
+	int nbrVertices = int(obstacle.vertices.size()) / 2;
+	float nearest = -1.0f;
+	bool inside = false;
+
+	if (nbrVertices == 0)
+		return sqrt( pow(x - obstacle.center[0], 2) + pow(y - obstacle.center[1], 2) ) - obstacle.radius;
+
+	for (int i = 0, j = nbrVertices - 1; i < nbrVertices; j = i++)
+	{
+		float ax = obstacle.vertices[2 * j], ay = obstacle.vertices[2 * j + 1];
+		float bx = obstacle.vertices[2 * i], by = obstacle.vertices[2 * i + 1];
+		float ex = bx - ax, ey = by - ay;
+		float length = ex * ex + ey * ey;
+		float t = (length > 0.0f) ? ((x - ax) * ex + (y - ay) * ey) / length : 0.0f;
+		float distance;
+
+		t = (t < 0.0f) ? 0.0f : ((t > 1.0f) ? 1.0f : t);
+		distance = sqrt( pow(x - (ax + t * ex), 2) + pow(y - (ay + t * ey), 2) );
+		if ( (nearest < 0.0f) || (distance < nearest) )
+			nearest = distance;
+		if ( ((ay > y) != (by > y)) && (x < ax + (y - ay) * ex / ey) )
+			inside = !inside;
+	}
+	return inside ? -nearest : nearest;
+}
+
+
+/* Function to keep every ship of the world clear of the      */
+/* obstacles, sampling the field once per ship on the worker  */
+/* pool: a ship within OBSTACLE_MARGIN of an obstacle (or in  */
+/* it) is moved out to the margin along the gradient, and any */
+/* part of its heading into the obstacle is reflected.        */
+void CollideShips(EntityWorld &world, const ObstacleField &field)
+{
+	if (!field.isBaked())
+		return;
+	for (int a = 0; a < world.getArchetypeCount(); a++)
+	{
+		Archetype &ships = world.getArchetype(a);
+		Position *position = ships.column<Position>();
+		Heading *heading = ships.column<Heading>();
+
+		if (!ships.isShip())
+			continue;
+		SimulationPool().parallelFor(ships.getSize(), OBSTACLE_GRAIN, [&field, position, heading](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				float distance, gradient[2], inward;
+
+				field.sample(position[i].pos, distance, gradient);
+				if (distance >= OBSTACLE_MARGIN)
+					continue;
+				position[i].pos[0] += (OBSTACLE_MARGIN - distance) * gradient[0];
+				position[i].pos[1] += (OBSTACLE_MARGIN - distance) * gradient[1];
+				inward = heading[i].delta[0] * gradient[0] + heading[i].delta[1] * gradient[1];
+				if (inward < 0.0f)
+				{
+					heading[i].delta[0] -= 2.0f * inward * gradient[0];
+					heading[i].delta[1] -= 2.0f * inward * gradient[1];
+				}
+			}
+		});
+	}
+}
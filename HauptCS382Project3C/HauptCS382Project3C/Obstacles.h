@@ -0,0 +1,82 @@
+/////////////////////////////////////////////////////////////////
+// Definition file: Obstacles.h                                //
+//                                                             //
+// This file declares the static obstacles: circles and        //
+// polygons, loaded from a text file with one per line,        //
+//                                                             //
+//   circle x y radius                                         //
+//   polygon x1 y1 x2 y2 x3 y3 ...                             //
+//                                                             //
+// (blank lines and lines starting with '#' are ignored).      //
+// When loaded they are baked into an ObstacleField: a grid of //
+// the signed distance to the nearest obstacle (negative       //
+// inside one) and its gradient, sampled every SDF_CELL across //
+// the world.  Keeping the ships out of the obstacles then     //
+// costs one interpolated sample per ship, however many        //
+// obstacles there are: a ship closer than OBSTACLE_MARGIN to  //
+// an obstacle (or inside it) is moved out along the gradient  //
+// and its heading turned away.                                //
+/////////////////////////////////////////////////////////////////
+
+#ifndef OBSTACLES_H
+
+#include "Flocking.h"
+#include "Simulation.h"
+#include "EntityWorld.h"
+#include <vector>
+
+const float SDF_CELL			= 0.01f;	// Spacing Of Grid Samples //
+const int   MAX_SDF_SIDE		= 1024;		// Most Cells Per Side     //
+const float OBSTACLE_MARGIN		= 0.02f;	// Ships' Clearance        //
+const float OBSTACLE_COLOR[3]	= { 0.5f, 0.5f, 0.5f };	// Outline Color //
+const int   OBSTACLE_GRAIN		= 4096;		// Ships Per Task          //
+
+//////////////////////////////////////////////////////////
+// An obstacle: a polygon, if it has vertices (x and y  //
+// in turn, in either winding), or else a circle.       //
+//////////////////////////////////////////////////////////
+struct Obstacle
+{
+	std::vector<float> vertices;
+	float center[2];
+	float radius;
+};
+
+//////////////////////////////////////////////////
+// DECLARATION SECTION FOR OBSTACLE FIELD CLASS //
+//////////////////////////////////////////////////
+
+class ObstacleField
+{
+	public:
+		// Class constructor
+		ObstacleField();
+
+		// Member functions
+		void bake(const std::vector<Obstacle> &obstacles, const WorldBounds &bounds);
+		bool isBaked() const;
+		void sample(const float pos[], float &distance, float gradient[]) const;
+
+	protected:
+		// A grid node: the signed distance there, and its unit gradient. //
+		struct node
+		{
+			float distance;
+			float gradient[2];
+		};
+
+		// Data members
+		int columns, rows;
+		float left, bottom, cellSize;
+		std::vector<node> nodes;		// (columns + 1) x (rows + 1), by row. //
+};
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+bool LoadObstacles(const char *path, std::vector<Obstacle> &obstacles, int &badLine);
+float ObstacleDistance(const Obstacle &obstacle, float x, float y);
+void CollideShips(EntityWorld &world, const ObstacleField &field);
+
+#define OBSTACLES_H
+#endif
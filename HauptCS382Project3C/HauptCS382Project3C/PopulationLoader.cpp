@@ -0,0 +1,423 @@
+/////////////////////////////////////////////////////////////////
+// Class implementation file: PopulationLoader.cpp             //
+//                                                             //
+// Both loaders fill the world's plain ship archetype: its     //
+// rows are appended all at once and then written in parallel, //
+// each task converting its own range, so no ship is ever held //
+// in a list.  CSV numbers are parsed by hand, bounded by the  //
+// end of the mapping (which is not NUL-terminated), and do    //
+// not depend on the C locale.                                 //
+/////////////////////////////////////////////////////////////////
+
+#include "PopulationLoader.h"
+#include "Recording.h"
+#include "WorkerPool.h"
+#include "BinaryLog.h"
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+const int MAX_CSV_FIELDS = 5;		// x, y, dx, dy, color //
+const int MAX_EXACT_POWER = 22;		// Largest Exact 10^n  //
+
+// The powers of ten a double holds exactly. //
+static const double POWERS_OF_TEN[MAX_EXACT_POWER + 1] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+														   1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16,
+														   1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+///////////////////////////////////////////////////
+// IMPLEMENTATION SECTION FOR MAPPED FILE CLASS  //
+///////////////////////////////////////////////////
+
+/////////////////////////////////////
+// Default constructor: Unmapped.  //
+/////////////////////////////////////
+MappedFile::MappedFile()
+{
+	data = NULL;
+	size = 0;
+#ifdef _WIN32
+	file = mapping = NULL;
+#endif
+}
+
+///////////////////////////////////////////
+// Destructor: Unmaps the file, if any.  //
+///////////////////////////////////////////
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+//////////////////////////////////////////////////////////
+// Function to map a whole file for reading, returning  //
+// false if it cannot be. An empty file maps to no data //
+// at all, which is not an error.                       //
+//////////////////////////////////////////////////////////
+bool MappedFile::open(const char *path)
+{
+	close();
+#ifdef _WIN32
+	LARGE_INTEGER length;
+
+	file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		file = NULL;
+		return false;
+	}
+	if (!GetFileSizeEx(file, &length))
+	{
+		close();
+		return false;
+	}
+	size = size_t(length.QuadPart);
+	if (size == 0)
+		return true;
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping != NULL)
+		data = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	int descriptor = ::open(path, O_RDONLY);
+	struct stat status;
+	void *mapped;
+
+	if (descriptor < 0)
+		return false;
+	if (fstat(descriptor, &status) != 0)
+	{
+		::close(descriptor);
+		return false;
+	}
+	size = size_t(status.st_size);
+	if (size == 0)
+	{
+		::close(descriptor);
+		return true;
+	}
+	mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	::close(descriptor);
+	if (mapped != MAP_FAILED)
+	{
+		data = (const char *)mapped;
+		madvise(mapped, size, MADV_SEQUENTIAL);
+	}
+#endif
+	if (data == NULL)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+///////////////////////////////////////
+// Function to unmap the file.       //
+///////////////////////////////////////
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (data != NULL)
+		UnmapViewOfFile(data);
+	if (mapping != NULL)
+		CloseHandle(mapping);
+	if (file != NULL)
+		CloseHandle(file);
+	file = mapping = NULL;
+#else
+	if (data != NULL)
+		munmap((void *)data, size);
+#endif
+	data = NULL;
+	size = 0;
+}
+
+/////////////////////////////////////////////////
+// Functions to reach the mapped bytes.        //
+/////////////////////////////////////////////////
+const char *MappedFile::getData()
+{
+	return data;
+}
+
+size_t MappedFile::getSize()
+{
+	return size;
+}
+
+/////////////////////////////////////////
+// IMPLEMENTATION SECTION FOR LOADERS  //
+/////////////////////////////////////////
+
+/* Function to parse a decimal number ("-1.5", "2e-3") at "p", */
+/* stopping at "end", and to leave "p" just past it. False is  */
+/* returned if there is no number there.                       */
+static bool ParseNumber(const char *&p, const char *end, float &value)
+{
+	unsigned long long mantissa = 0;
+	int exponent = 0, digits = 0;
+	bool negative = false;
+	double scaled;
+
+	if ( (p < end) && ((*p == '-') || (*p == '+')) )
+		negative = (*p++ == '-');
+	for (; (p < end) && (*p >= '0') && (*p <= '9'); p++, digits++)
+		if (mantissa < 100000000000000000ULL)
+			mantissa = 10 * mantissa + (*p - '0');
+		else
+			exponent++;
+	if ( (p < end) && (*p == '.') )
+		for (p++; (p < end) && (*p >= '0') && (*p <= '9'); p++, digits++)
+			if (mantissa < 100000000000000000ULL)
+			{
+				mantissa = 10 * mantissa + (*p - '0');
+				exponent--;
+			}
+	if (digits == 0)
+		return false;
+	if ( (p < end) && ((*p == 'e') || (*p == 'E')) )
+	{
+		const char *q = p + 1;
+		bool negativeExponent = false;
+		int power = 0;
+
+		if ( (q < end) && ((*q == '-') || (*q == '+')) )
+			negativeExponent = (*q++ == '-');
+		if ( (q == end) || (*q < '0') || (*q > '9') )
+			return false;
+		for (; (q < end) && (*q >= '0') && (*q <= '9'); q++)
+			if (power < 1000)
+				power = 10 * power + (*q - '0');
+		exponent += negativeExponent ? -power : power;
+		p = q;
+	}
+
+	scaled = double(mantissa);
+	if ( (exponent >= -MAX_EXACT_POWER) && (exponent <= MAX_EXACT_POWER) )
+		scaled = (exponent < 0) ? scaled / POWERS_OF_TEN[-exponent] : scaled * POWERS_OF_TEN[exponent];
+	else
+		scaled *= pow(10.0, double(exponent));
+	value = float(negative ? -scaled : scaled);
+	return true;
+}
+
+
+/* Function to parse one CSV line, [p, end), into a ship. */
+/* 1 is returned for a ship, 0 for a line to ignore (blank */
+/* or a comment), and -1 for a malformed line.             */
+static int ParseShipLine(const char *p, const char *end, Ship &shp)
+{
+	float fields[MAX_CSV_FIELDS] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	int nbrFields = 0;
+
+	while ( (end > p) && ((end[-1] == '\r') || (end[-1] == ' ') || (end[-1] == '\t')) )
+		end--;
+	while ( (p < end) && ((*p == ' ') || (*p == '\t')) )
+		p++;
+	if ( (p == end) || (*p == '#') )
+		return 0;
+
+	for (;;)
+	{
+		if ( (nbrFields == MAX_CSV_FIELDS) || !ParseNumber(p, end, fields[nbrFields]) )
+			return -1;
+		nbrFields++;
+		while ( (p < end) && ((*p == ' ') || (*p == '\t')) )
+			p++;
+		if (p == end)
+			break;
+		if (*p++ != ',')
+			return -1;
+		while ( (p < end) && ((*p == ' ') || (*p == '\t')) )
+			p++;
+	}
+	if ( (nbrFields == 1) || (nbrFields == 3) ||
+		 (fields[4] != floor(fields[4])) || (fields[4] < 0.0f) || (fields[4] >= float(NBR_COLORS)) )
+		return -1;
+
+	shp.pos[0] = fields[0];
+	shp.pos[1] = fields[1];
+	shp.delta[0] = fields[2];
+	shp.delta[1] = fields[3];
+	shp.clr = color(int(fields[4]));
+	shp.idle = 0;
+	return 1;
+}
+
+
+/* Function to find where the line holding byte "offset" ends */
+/* (just past its newline), so that a chunk boundary falls    */
+/* between lines.                                             */
+static size_t NextLineStart(const char *data, size_t size, size_t offset)
+{
+	const char *newline;
+
+	if (offset == 0)
+		return 0;
+	if (offset >= size)
+		return size;
+	newline = (const char *)memchr(data + offset - 1, '\n', size - (offset - 1));
+	return (newline == NULL) ? size : size_t(newline - data) + 1;
+}
+
+
+/* Function to map a population file and load it by its kind. */
+bool LoadPopulation(const char *path, EntityWorld &world, PopulationReport &report)
+{
+	MappedFile mapped;
+	bool loaded;
+
+	report.nbrShips = report.nbrRipples = report.nbrSkipped = 0;
+	if (!mapped.open(path))
+		return false;
+	if ( (mapped.getSize() >= sizeof(CHECKPOINT_MAGIC)) &&
+		 (memcmp(mapped.getData(), &CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) == 0) )
+		loaded = LoadBinaryPopulation(mapped, world, report);
+	else
+		loaded = LoadCsvPopulation(mapped, world, report);
+	LOG_EVENT("population: %d ships, %d ripples, %d lines skipped", report.nbrShips, report.nbrRipples, report.nbrSkipped);
+	return loaded;
+}
+
+
+/* Function to load a mapped checkpoint: its ship records are */
+/* read in place and converted into the world in parallel,    */
+/* and its ripples are added oldest first. Records holding a  */
+/* color or mask the simulation does not know are skipped and */
+/* counted. The checkpoint's bounds and mode are not applied; */
+/* the run's own options decide those. False is returned,     */
+/* with the world untouched, if the file is cut short.        */
+bool LoadBinaryPopulation(MappedFile &mapped, EntityWorld &world, PopulationReport &report)
+{
+	size_t headerBytes = sizeof(CHECKPOINT_MAGIC) + sizeof(TickRecord) + sizeof(WorldRecord), recordBytes;
+	TickRecord header;
+	const char *ships;
+	const RippleRecord *ripples;
+	vector<unsigned char> valid;
+	int nbrBad;
+
+	if (mapped.getSize() < headerBytes)
+		return false;
+	memcpy(&header, mapped.getData() + sizeof(CHECKPOINT_MAGIC), sizeof(header));
+
+	// The counts are checked by division so that a 32-bit size_t cannot overflow. //
+	recordBytes = mapped.getSize() - headerBytes;
+	if ( (header.nbrShips < 0) || (header.nbrRipples < 0) ||
+		 (size_t(header.nbrShips) > recordBytes / sizeof(ShipRecord)) ||
+		 (size_t(header.nbrRipples) > (recordBytes - size_t(header.nbrShips) * sizeof(ShipRecord)) / sizeof(RippleRecord)) )
+		return false;
+	ships = mapped.getData() + headerBytes;
+	ripples = (const RippleRecord *)(ships + size_t(header.nbrShips) * sizeof(ShipRecord));
+
+	Archetype &archetype = world.archetypeFor(SHIP_COMPONENTS);
+	int first = archetype.appendRows(header.nbrShips);
+	valid.resize(header.nbrShips);
+	SimulationPool().parallelFor(header.nbrShips, LOAD_GRAIN, [&archetype, first, ships, &valid](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			ShipRecord record;
+			Ship shp;
+
+			memcpy(&record, ships + size_t(i) * sizeof(ShipRecord), sizeof(record));
+			valid[i] = ValidShipRecord(record);
+			shp.pos[0] = record.pos[0];
+			shp.pos[1] = record.pos[1];
+			shp.delta[0] = record.delta[0];
+			shp.delta[1] = record.delta[1];
+			shp.clr = valid[i] ? color(record.clr) : white;
+			shp.idle = valid[i] ? (unsigned char)record.idle : 0;
+			archetype.setShip(first + i, shp);
+		}
+	});
+	nbrBad = int( count(valid.begin(), valid.end(), 0) );
+	if (nbrBad > 0)
+		archetype.retain([first, &valid](int row) { return (row < first) || valid[row - first]; });
+	report.nbrShips = header.nbrShips - nbrBad;
+	report.nbrSkipped = nbrBad;
+
+	// Checkpoints list the ripples newest first. //
+	for (int j = header.nbrRipples - 1; j >= 0; j--)
+	{
+		RippleRecord record;
+		Ripple cir;
+
+		memcpy(&record, &ripples[j], sizeof(record));
+		if (!ValidRippleRecord(record))
+		{
+			report.nbrSkipped++;
+			continue;
+		}
+		cir.pos[0] = record.pos[0];
+		cir.pos[1] = record.pos[1];
+		cir.rad = record.rad;
+		cir.clr = color(record.clr);
+		cir.mask = (unsigned char)record.mask;
+		world.addRipple(cir);
+		report.nbrRipples++;
+	}
+	return true;
+}
+
+
+/* Function to load a mapped CSV file: the mapping is cut at   */
+/* newlines into chunks of about CSV_CHUNK_BYTES, the chunks   */
+/* are parsed in parallel, and their ships are then written to */
+/* the world in parallel too, in file order.                   */
+bool LoadCsvPopulation(MappedFile &mapped, EntityWorld &world, PopulationReport &report)
+{
+	const char *data = mapped.getData();
+	size_t size = mapped.getSize();
+	int nbrChunks = int( (size + CSV_CHUNK_BYTES - 1) / CSV_CHUNK_BYTES );
+	vector< vector<Ship, TaggedAllocator<Ship, shipMemory> > > parsed(nbrChunks);
+	vector<int> skipped(nbrChunks, 0), firstRow(nbrChunks + 1, 0);
+
+	SimulationPool().parallelFor(nbrChunks, 1, [data, size, &parsed, &skipped](int begin, int end)
+	{
+		for (int c = begin; c < end; c++)
+		{
+			size_t line = NextLineStart(data, size, size_t(c) * CSV_CHUNK_BYTES);
+			size_t stop = NextLineStart(data, size, size_t(c + 1) * CSV_CHUNK_BYTES);
+
+			while (line < stop)
+			{
+				const char *newline = (const char *)memchr(data + line, '\n', stop - line);
+				size_t next = (newline == NULL) ? stop : size_t(newline - data) + 1;
+				Ship shp;
+				int result = ParseShipLine(data + line, data + ((newline == NULL) ? stop : next - 1), shp);
+
+				if (result > 0)
+					parsed[c].push_back(shp);
+				else if ( (result < 0) && (line != 0) )		// The first line may be a header. //
+					skipped[c]++;
+				line = next;
+			}
+		}
+	});
+
+	for (int c = 0; c < nbrChunks; c++)
+	{
+		firstRow[c + 1] = firstRow[c] + int(parsed[c].size());
+		report.nbrSkipped += skipped[c];
+	}
+	report.nbrShips = firstRow[nbrChunks];
+
+	Archetype &archetype = world.archetypeFor(SHIP_COMPONENTS);
+	int first = archetype.appendRows(report.nbrShips);
+	SimulationPool().parallelFor(nbrChunks, 1, [&archetype, first, &parsed, &firstRow](int begin, int end)
+	{
+		for (int c = begin; c < end; c++)
+			for (int i = 0; i < int(parsed[c].size()); i++)
+				archetype.setShip(first + firstRow[c] + i, parsed[c][i]);
+	});
+	return true;
+}
@@ -0,0 +1,86 @@
+/////////////////////////////////////////////////////////////////
+// Definition file: PopulationLoader.h                         //
+//                                                             //
+// This file declares the loaders that start the world from a  //
+// file rather than from random ships.  Either format is read  //
+// through a memory mapping, never copied into a buffer first: //
+//                                                             //
+//   Binary file:  a checkpoint (see Recording.h), whose ship  //
+//                 records are converted straight out of the   //
+//                 mapping into the world's columns, in        //
+//                 parallel, and whose ripples join the world. //
+//                 Records of an unknown color or mask are     //
+//                 skipped and counted.                        //
+//   CSV file:     one ship per line, "x,y" or "x,y,dx,dy" or  //
+//                 "x,y,dx,dy,color" (a color index, 0 to 6;   //
+//                 the missing fields are zero).  Blank lines, //
+//                 lines starting with '#', and a first line   //
+//                 that is not numbers (a header) are ignored; //
+//                 other bad lines are skipped and counted.    //
+//                 The mapping is cut into chunks at newlines  //
+//                 and the chunks are parsed in parallel.      //
+//                                                             //
+// A file is taken as binary when it starts with               //
+// CHECKPOINT_MAGIC, and as CSV otherwise.                     //
+/////////////////////////////////////////////////////////////////
+
+#ifndef POPULATION_LOADER_H
+
+#include "Flocking.h"
+#include "EntityWorld.h"
+#include <cstddef>
+
+const int CSV_CHUNK_BYTES = 1 << 20;	// Bytes Parsed Per Task  //
+const int LOAD_GRAIN      = 65536;		// Ships Converted Per Task //
+
+////////////////////////////////////////////////////////////
+// What a load found: the ships and ripples added, and    //
+// the CSV lines or binary records skipped as malformed.  //
+////////////////////////////////////////////////////////////
+struct PopulationReport
+{
+	int nbrShips;
+	int nbrRipples;
+	int nbrSkipped;
+};
+
+///////////////////////////////////////////////
+// DECLARATION SECTION FOR MAPPED FILE CLASS //
+///////////////////////////////////////////////
+
+class MappedFile
+{
+	public:
+		// Class constructor and destructor
+		MappedFile();
+		~MappedFile();
+
+		// Member functions
+		bool open(const char *path);
+		void close();
+		const char *getData();
+		size_t getSize();
+
+	protected:
+		// Data members
+		const char *data;
+		size_t size;
+#ifdef _WIN32
+		void *file;
+		void *mapping;
+#endif
+
+	private:
+		// Mappings are owned, never copied.
+		MappedFile(const MappedFile &mapped);
+};
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+bool LoadPopulation(const char *path, EntityWorld &world, PopulationReport &report);
+bool LoadBinaryPopulation(MappedFile &mapped, EntityWorld &world, PopulationReport &report);
+bool LoadCsvPopulation(MappedFile &mapped, EntityWorld &world, PopulationReport &report);
+
+#define POPULATION_LOADER_H
+#endif
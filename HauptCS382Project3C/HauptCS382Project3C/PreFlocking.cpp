@@ -17,113 +17,58 @@
 
 #include <gl/freeglut.h>
 #include <cmath>			// Header File For Math Library
+#include "Flocking.h"		// Header File For Ships And Ripples       //
+#include "Simulation.h"		// Header File For Simulation Core         //
+#include "StateHash.h"		// Header File For Lockstep Comparison     //
+#include "Fuzzer.h"			// Header File For Differential Fuzzing    //
+#include "WorkerPool.h"		// Header File For Worker Threads          //
+#include "Telemetry.h"		// Header File For Per-Tick Statistics     //
+#include "TiledWorld.h"		// Header File For Sleeping Tiles           //
+#include "IoService.h"		// Header File For Asynchronous Writes      //
+#include "Recording.h"		// Header File For Recording And Capture    //
+#include "MemoryAccounting.h"	// Header File For Memory Budgets        //
+#include "Watchdog.h"		// Header File For Slow-Tick Dumps         //
+#include "BinaryLog.h"		// Header File For Binary Logging          //
+#include "Scenario.h"		// Header File For Scripted Scenarios      //
+#include "EntityWorld.h"		// Header File For Entity Storage          //
+#include "PopulationLoader.h"	// Header File For Loading Ships          //
+#include "Workload.h"		// Header File For Synthetic Workloads     //
+#include "Predators.h"		// Header File For Roaming Emitters        //
+#include "Obstacles.h"		// Header File For Static Obstacles        //
+#include "StencilGrid.h"		// Header File For Ripple Stencils         //
+#include "SessionHost.h"		// Header File For Hosted Sessions         //
 #include <ctime>			// Header File For Accessing System Time
+#include <cstdlib>			// Header File For Random Numbers          //
 #include "LinkedList.h"		// Header File For Linked List Class       //
+#include "LockFreeStack.h"	// Header File For Lock-Free Ripple Stack  //
 #include <cstring>			// Header File For String Operations       //
+#include <cctype>			// Header File For Character Tests         //
+#include <cstdio>			// Header File For Console Output          //
+#include <thread>			// Header File For Benchmark Producers     //
+#include <chrono>			// Header File For Benchmark Timing        //
 using namespace std;
 
 //////////////////////
 // Global Constants //
 //////////////////////
 const int   INIT_WINDOW_POSITION[2]		= { 50, 50 };			// Window Offset       //
-const float INITIAL_RADIUS				= 0.0f;					// Init. Ripple Radius //
-const float FINAL_RADIUS				= 0.5f;					// Final Ripple Radius //
-const float RADIUS_INCREMENT			= 0.01f;					// Rad. Expansion Rate //
-const int   NBR_LINKS					= 25;					// Polygonal Circle    //
-const int	NBR_SHIPS					= 1000;					// # Of Ships          //
-const float PI_OVER_180					= 0.0174532925f;			// 1 Degree in Radians //
 const int   BEEP_DURATION				= 25;					// # msec Ripple Beep  //
 const int   BEEP_FREQUENCY[8]			= { 500, 1000, 1500,	// All Ripple Beep     //
 											2000, 2500, 3000,	// Frequencies (in     //
 											3500, 5000 };		// hertz)              //
-const int   NBR_COLORS					= 7;					// # Point Colors      //
-const float CIRCLE_COLOR[NBR_COLORS][3]	= { { 1.0f, 1.0f, 1.0f },	// All Ripple Colors   //
-											{ 1.0f, 0.3f, 0.3f },
-											{ 1.0f, 1.0f, 0.3f },
-											{ 0.3f, 1.0f, 0.3f },
-											{ 0.3f, 1.0f, 1.0f },
-											{ 0.3f, 0.3f, 1.0f },
-											{ 1.0f, 0.3f, 1.0f } };
-const float SHIP_RADIUS					= 0.02f;
-const float SHIP_THICKNESS				= 2.0f;
-const float MIN_SHIP_DELTA				= -0.0001f;				// Ship Trajectory's   //
-const float MAX_SHIP_DELTA				=  0.0001f;				// Lower, Upper Bounds //
-const float VECTOR_SIZE					= 0.01f;
-const char  DEFAULT_TITLE[]				= "MOUSE: RIPPLES; KEYBOARD: COLORS (wrygcbmn)";
-
-enum color { white, red, yellow, green, cyan, blue, magenta, none };	// Color Index Values //
-
-////////////////////////////////////////
-// 2D ripple class (for convenience). //
-////////////////////////////////////////
-class Ripple
-{
-	public:
-		float pos[2];	// 2-D position of circle's center //
-		float rad;		// Radius of circle                //
-		color clr;		// Initial color of circle         //
-
-		// The draw member function renders the circle at its current position, //
-		// with its current radius, and colored to dissipate as it expands.     //
-		void draw()
-		{
-			int i;
-			float theta;
-
-			if (clr != none)	// Draw nothing if the circle is "invisible". //
-			{
-				float intensity = (FINAL_RADIUS - rad) / (FINAL_RADIUS - INITIAL_RADIUS);
-				float currColor[3] = { intensity * CIRCLE_COLOR[int(clr)][0],
-										intensity * CIRCLE_COLOR[int(clr)][1],
-										intensity * CIRCLE_COLOR[int(clr)][2] };
-				float thickness = 3.0f * intensity;
-				glColor3fv(currColor);
-				glLineWidth(thickness);
-
-				// Draw a polygonal approximation to the circle. //
-				glBegin(GL_LINES);
-				for (i = 1; i <= NBR_LINKS; i++)
-					{
-						theta = 360 * i * PI_OVER_180 / NBR_LINKS;
-						glVertex2f(pos[0] + rad * cos(theta), pos[1] + rad * sin(theta));
-						theta = 360 * (i + 1) * PI_OVER_180 / NBR_LINKS;
-						glVertex2f(pos[0] + rad * cos(theta), pos[1] + rad * sin(theta));
-					}
-				glEnd();
-			}
-		}
-};
-
-//////////////////////////////////////
-// 2D ship class (for convenience). //
-//////////////////////////////////////
-class Ship
-{
-	public:
-		float pos[2];	// 2-D position of flocker      //
-		float delta[2];	// Trajectory vector of flocker //
-		color clr;		// Color of flocker             //
-
-		void draw()
-		{
-			float theta = atan2(delta[1], delta[0]);
-			float currColor[3] = { CIRCLE_COLOR[int(clr)][0],
-									CIRCLE_COLOR[int(clr)][1],
-									CIRCLE_COLOR[int(clr)][2] };
-			glColor3fv(currColor);
-			glLineWidth(SHIP_THICKNESS);
-
-			// Draw a delta-shaped representation of the ship. //
-			glBegin(GL_TRIANGLE_FAN);
-				glVertex2f(pos[0] + SHIP_RADIUS * cos(theta), pos[1] + SHIP_RADIUS * sin(theta));
-				theta += 120 * PI_OVER_180;
-				glVertex2f(pos[0] + SHIP_RADIUS * cos(theta), pos[1] + SHIP_RADIUS * sin(theta));
-				glVertex2f(pos[0], pos[1]);
-				theta += 120 * PI_OVER_180;
-				glVertex2f(pos[0] + SHIP_RADIUS * cos(theta), pos[1] + SHIP_RADIUS * sin(theta));
-			glEnd();
-		}
-};
+const char  DEFAULT_TITLE[]				= "MOUSE: RIPPLES; KEYBOARD: COLORS (wrygcbmn; SHIFT ADDS), K: CHECKPOINT";
+const int   QUEUE_BENCH_PRODUCERS		= 8;					// Benchmark Threads   //
+const int   QUEUE_BENCH_RIPPLES			= 200000;				// Pushes Per Thread   //
+const int   LOCKSTEP_RIPPLE_ODDS		= 5;					// 1 Ripple Per N Ticks //
+const int   CAPTION_INTERVAL			= 25;					// Ticks Per Caption   //
+const int   TIMER_PERIOD				= 20;					// msec Per Tick       //
+const int   IO_BENCH_TICKS				= 250;					// Ticks Per Phase     //
+const int   IO_BENCH_RATE				= 500;					// MB/s Written        //
+const long  LOG_BENCH_CALLS				= 200000;				// Calls Timed         //
+const int   NBR_TRAILED_SHIPS			= 64;					// Ships With Trails   //
+const float TRAIL_INTENSITY				= 0.4f;					// Trail Brightness    //
+const int   BENCH_RIPPLES_PER_TICK		= 4;					// Benchmark Ripples   //
+const int   HOST_KIOSK_RIPPLES			= 1;					// Session Input/Tick  //
 
 //////////////////////
 // Global Variables //
@@ -131,35 +76,192 @@ class Ship
 int currWindowSize[2]	= { 800, 800 };	// Window size in pixels.          //
 float windowWidth		= 2.0f;			// Resized window width.           //
 float windowHeight		= 2.0f;			// Resized window height.          //
-LinkedList<Ripple> circleList;			// Linked list of ripple circles.  //
-LinkedList<Ship>   shipList;			// Linked list of ships.           //
+EntityWorld world;						// Every ship and ripple.          //
+SystemSchedule worldSystems(WORLD_SYSTEMS, NBR_WORLD_SYSTEMS);	// Run on it every tick. //
+LockFreeStack<Ripple> rippleQueue;		// Ripples awaiting the next tick. //
 color currColor			= none;			// Current new ripple color.       //
+unsigned char currMask	= ALL_COLORS_MASK;	// Colors new ripples displace. //
+const SimulationEngine *currEngine = &ENGINES[0];	// Displacement engine in use. //
+TiledWorld tiledWorld;					// Ships, when kept in tiles.      //
+bool tiledMode			= false;		// Whether the ships are in tiles. //
+const char *recordPath	= NULL;			// Trajectory file, if recording.  //
+const char *capturePath	= NULL;			// Frame file, if capturing.       //
+int recordStream		= -1;			// I/O stream of the recording.    //
+int captureStream		= -1;			// I/O stream of the capture.      //
+Watchdog watchdog;						// Dumps the state on a slow tick. //
+ScenarioRunner scenarioRunner;			// Scripts driving the ripples.    //
+ScenarioContext scenarioContext(rippleQueue, (unsigned int)time(NULL));	// What they see. //
+bool scriptMode			= false;		// Whether a scenario is running.  //
+const char *populationPath = NULL;		// Ships' file, if not random.     //
+const PopulationShape *generatedShape = NULL;	// Shape, if generating ships. //
+int nbrGenerated		= NBR_SHIPS;	// Ships to generate in that shape. //
+int nbrPredators		= 0;			// Predators to add to the world.  //
+ClusterGrid shipClusters;				// Where predators look for prey.  //
+const char *obstaclePath = NULL;		// Obstacles' file, if any.        //
+vector<Obstacle> obstacles;				// The obstacles, as loaded.       //
+ObstacleField obstacleField;			// Their baked distance field.     //
 
 /////////////////////////
 // Function Prototypes //
 /////////////////////////
+bool ParseOptions(int argc, char **argv);
 void SetCaption();
 void MouseClick(int mouseButton, int mouseState, int mouseXPosition, int mouseYPosition);
 void KeyboardPress(unsigned char pressedKey, int mouseXPosition, int mouseYPosition);
 void TimerFunction(int value);
-void DisplaceShips();
 void Display();
-void InitShips();
-void Normalize(float vector[]);
+void InitShips(LinkedList<Ship> &shipList, unsigned int seed);
+bool InitWorld(unsigned int seed);
+bool LoadObstacleField();
+void TileWorldShips();
+void ExportShips(LinkedList<Ship> &shipList);
+WorldRecord CurrentWorldRecord();
+void StepWorld();
+void DrawRipple(const Ripple &cir);
+void DrawShip(const Ship &shp);
+void DrawTrails(Archetype &ships);
+void DrawPredators(Archetype &predators);
+void DrawObstacles();
 void ResizeWindow(GLsizei w, GLsizei h);
+void BenchmarkRippleQueue(int nbrProducers);
+void LockstepCommand(const char *nameA, const char *nameB, long nbrTicks);
+void BenchmarkIoService(const char *path);
+void ReplayCheckpoint(const char *path, long nbrTicks);
+void ScenarioCommand(const char *name, long nbrTicks, unsigned int seed);
+void LoadCommand(const char *path);
+void BenchmarkWorkloads(const char *shapeName, const char *patternName, int nbrShips, long nbrTicks,
+						unsigned int seed);
+void RunWorkload(const PopulationShape &shape, const RipplePattern &pattern, int nbrShips, long nbrTicks,
+				 unsigned int seed);
+void HostCommand(int nbrSessions, long nbrTicks, double objectiveMs, int stormRipples, unsigned int seed);
 
 
 /* The main function: uses the OpenGL Utility Toolkit to set */
 /* the window up to display the window and its contents.     */
 void main(int argc, char **argv)
 {
+	/* Apply the engine and worker pool options first, */
+	/* so that they hold for the headless modes too.    */
+	if (!ParseOptions(argc, argv))
+		return;
+
+	/* Run the ripple queue contention benchmark instead */
+	/* of the simulation when asked on the command line. */
+	if ( (argc > 1) && (strcmp(argv[1], "-queuebench") == 0) )
+	{
+		BenchmarkRippleQueue(QUEUE_BENCH_PRODUCERS);
+		return;
+	}
+
+	/* Compare two displacement engines tick by tick, headlessly. */
+	if ( (argc > 4) && (strcmp(argv[1], "-lockstep") == 0) )
+	{
+		LockstepCommand(argv[2], argv[3], atol(argv[4]));
+		return;
+	}
+
+	/* Fuzz every engine against the reference, headlessly. */
+	if ( (argc > 2) && (strcmp(argv[1], "-fuzz") == 0) )
+	{
+		FuzzEngines(atoi(argv[2]), (argc > 3) ? (unsigned int)atol(argv[3]) : (unsigned int)time(NULL));
+		return;
+	}
+
+	/* Measure the tick cost of heavy asynchronous writing. */
+	if ( (argc > 2) && (strcmp(argv[1], "-iobench") == 0) )
+	{
+		BenchmarkIoService(argv[2]);
+		return;
+	}
+
+	/* Turn a binary log back into text. */
+	if ( (argc > 2) && (strcmp(argv[1], "-decodelog") == 0) )
+	{
+		if (DecodeBinaryLog(argv[2], stdout) < 0)
+			printf("Cannot decode %s\n", argv[2]);
+		return;
+	}
+
+	/* Time the logging call itself, logging to a scratch file. */
+	if ( (argc > 2) && (strcmp(argv[1], "-logbench") == 0) )
+	{
+		if (binaryLog.isEnabled() || binaryLog.start(argv[2]))
+		{
+			double ns = BenchmarkBinaryLog(LOG_BENCH_CALLS);
+			printf("%ld calls: %.1f ns per call (%.1f ns of it reading the clock), %lu dropped on full rings\n",
+				   LOG_BENCH_CALLS, ns, BenchmarkLogTimestamp(LOG_BENCH_CALLS), binaryLog.getDropped());
+			binaryLog.stop();
+		}
+		return;
+	}
+
+	/* Step a checkpoint (say, a watchdog's) headlessly. */
+	if ( (argc > 3) && (strcmp(argv[1], "-replay") == 0) )
+	{
+		ReplayCheckpoint(argv[2], atol(argv[3]));
+		return;
+	}
+
+	/* Run a built-in scenario headlessly, for stress tests. */
+	if ( (argc > 3) && (strcmp(argv[1], "-scenario") == 0) )
+	{
+		ScenarioCommand(argv[2], atol(argv[3]), (argc > 4) ? (unsigned int)atol(argv[4]) : (unsigned int)time(NULL));
+		return;
+	}
+
+	/* Time loading a population file, headlessly. */
+	if ( (argc > 2) && (strcmp(argv[1], "-load") == 0) )
+	{
+		LoadCommand(argv[2]);
+		return;
+	}
+
+	/* Time the engine on synthetic workloads, headlessly. */
+	if ( (argc > 5) && (strcmp(argv[1], "-bench") == 0) )
+	{
+		BenchmarkWorkloads(argv[2], argv[3], atoi(argv[4]), atol(argv[5]),
+						   (argc > 6) ? (unsigned int)atol(argv[6]) : (unsigned int)time(NULL));
+		return;
+	}
+
+	/* Host several sessions on the one pool, headlessly. */
+	if ( (argc > 4) && (strcmp(argv[1], "-host") == 0) )
+	{
+		HostCommand(atoi(argv[2]), atol(argv[3]), atof(argv[4]), (argc > 5) ? atoi(argv[5]) : 0,
+					(argc > 6) ? (unsigned int)atol(argv[6]) : (unsigned int)time(NULL));
+		return;
+	}
+
+	/* Populate the world (loading or generating the ships,  */
+	/* baking the obstacles, tiling) and build the ripple    */
+	/* stencils on a thread of their own while the window    */
+	/* and GL state are set up, before the render thread is  */
+	/* pinned; the first frame waits for both.              */
+	bool worldReady = false;
+	std::thread warmup([&worldReady]()
+	{
+		worldReady = InitWorld((unsigned int)time(NULL));
+		if (worldReady)
+			StencilForAge(0);
+		telemetry.worldReadyMs = MsSinceStartup();
+	});
+
+	/* Open the recording and capture files, if any. */
+	if (recordPath != NULL)
+		recordStream = SharedIoService().openStream(recordPath);
+	if (capturePath != NULL)
+		captureStream = SharedIoService().openStream(capturePath);
+
+	/* Give the render thread its own CPU if one was chosen. */
+	if (poolConfig.renderCpu >= 0)
+		PinCurrentThread(poolConfig.renderCpu);
+
 	/* Set up the display window. */
 	glutInit(&argc, argv);
 	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA);
 	glutInitWindowPosition(INIT_WINDOW_POSITION[0], INIT_WINDOW_POSITION[1]);
 	glutInitWindowSize(currWindowSize[0], currWindowSize[1]);
-	glutCreateWindow( DEFAULT_TITLE );
-	InitShips();
+	int window = glutCreateWindow( DEFAULT_TITLE );
 	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
 	/* Specify the resizing, refreshing, and interactive routines. */
@@ -167,13 +269,172 @@ void main(int argc, char **argv)
 	glutDisplayFunc( Display );
 	glutMouseFunc( MouseClick );
 	glutKeyboardFunc( KeyboardPress );
-	glutTimerFunc( 20, TimerFunction, 1 );
+	glutTimerFunc( TIMER_PERIOD, TimerFunction, 1 );
+
+	/* A world that could not be set up (its cause already */
+	/* printed) aborts the start before the window shows.  */
+	warmup.join();
+	if (!worldReady)
+	{
+		glutDestroyWindow(window);
+		if (recordStream >= 0)
+			SharedIoService().closeStream(recordStream);
+		if (captureStream >= 0)
+			SharedIoService().closeStream(captureStream);
+		printf("Start aborted\n");
+		return;
+	}
 	glutMainLoop();
 }
 
+/* Function to apply the options that may accompany any run:  */
+/* "-engine name" picks the displacement engine (or a rule    */
+/* set, see ShipRules.h), "-workers n" sizes the worker pool, */
+/* "-cpus mask" (in hexadecimal) pins the workers to those    */
+/* CPUs, and "-rendercpu k" pins the render thread to CPU k   */
+/* and keeps the workers off it (a mask holding no other CPU  */
+/* is refused), "-tiled" keeps the ships in sleeping tiles    */
+/* rather than the world (the engine then goes unused),       */
+/* "-wrap" makes the window a torus, "-record file" writes    */
+/* every tick's ships to the file, "-capture file" every      */
+/* frame's pixels, and "-budget ripples megabytes" sets the   */
+/* ripples' soft memory budget (over it, the oldest ripples   */
+/* are shed; no other tag has a way to shed load, so no other */
+/* tag is accepted), "-watchdog ms" dumps the state whenever  */
+/* a tick takes longer than that, and "-log file" writes a    */
+/* binary log (read it with -decodelog), and "-script name"   */
+/* lets a built-in scenario (see Scenario.cpp) fire ripples   */
+/* alongside the mouse, "-ships file" starts from the ships   */
+/* in a file (see PopulationLoader.h) rather than random      */
+/* ones, "-generate shape n" from n ships of a synthetic      */
+/* shape (see Workload.h), and "-predators n" adds n          */
+/* predators (see Predators.h), and "-obstacles file" loads   */
+/* static obstacles (see Obstacles.h). Predators and          */
+/* obstacles only see the world's ships, not the tiles', so   */
+/* both are refused with "-tiled". False is returned on a bad */
+/* option.                                                    */
+bool ParseOptions(int argc, char **argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-tiled") == 0)
+			tiledMode = true;
+		else if (strcmp(argv[i], "-wrap") == 0)
+			worldBounds.wrap = true;
+		else if (i + 1 == argc)
+			break;
+		else if (strcmp(argv[i], "-engine") == 0)
+		{
+			currEngine = FindEngine(argv[++i]);
+			if (currEngine == NULL)
+			{
+				printf("Unknown engine: %s\n", argv[i]);
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "-workers") == 0)
+			poolConfig.nbrWorkers = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-cpus") == 0)
+			poolConfig.cpuMask = strtoull(argv[++i], NULL, 16);
+		else if (strcmp(argv[i], "-rendercpu") == 0)
+			poolConfig.renderCpu = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-record") == 0)
+			recordPath = argv[++i];
+		else if (strcmp(argv[i], "-capture") == 0)
+			capturePath = argv[++i];
+		else if (strcmp(argv[i], "-ships") == 0)
+			populationPath = argv[++i];
+		else if (strcmp(argv[i], "-predators") == 0)
+			nbrPredators = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-obstacles") == 0)
+			obstaclePath = argv[++i];
+		else if (strcmp(argv[i], "-watchdog") == 0)
+			watchdog.setThreshold(atof(argv[++i]));
+		else if (strcmp(argv[i], "-log") == 0)
+		{
+			if (!binaryLog.start(argv[++i]))
+			{
+				printf("Cannot open log %s\n", argv[i]);
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "-script") == 0)
+		{
+			if (!BuildScenario(argv[++i], scenarioRunner, windowWidth, windowHeight, (unsigned int)time(NULL)))
+			{
+				printf("Unknown scenario: %s\n", argv[i]);
+				return false;
+			}
+			scriptMode = true;
+		}
+		else if ( (strcmp(argv[i], "-generate") == 0) && (i + 2 < argc) )
+		{
+			generatedShape = FindPopulationShape(argv[++i]);
+			if (generatedShape == NULL)
+			{
+				printf("Unknown population shape: %s\n", argv[i]);
+				return false;
+			}
+			nbrGenerated = atoi(argv[++i]);
+		}
+		else if ( (strcmp(argv[i], "-budget") == 0) && (i + 2 < argc) )
+		{
+			memoryTag tag;
+			if (!FindMemoryTag(argv[++i], tag))
+			{
+				printf("Unknown memory tag: %s\n", argv[i]);
+				return false;
+			}
+			if (tag != rippleMemory)
+			{
+				printf("Only the ripples shed load over a budget, not the %s\n", argv[i]);
+				return false;
+			}
+			SetMemoryBudget(tag, (long long)(atof(argv[++i]) * 1048576.0));
+		}
+	}
+
+	if ( tiledMode && (obstaclePath != NULL) )
+	{
+		printf("Obstacles only keep out the world's ships, not the tiles': drop -tiled or -obstacles\n");
+		return false;
+	}
+	if ( tiledMode && (nbrPredators > 0) )
+	{
+		printf("Predators only hunt the world's ships, not the tiles': drop -tiled or -predators\n");
+		return false;
+	}
+	if ( (poolConfig.renderCpu >= 0) && (poolConfig.cpuMask != 0) && (WorkerCpuMask(poolConfig) == 0) )
+	{
+		printf("The -cpus mask leaves the workers nothing but the render CPU\n");
+		return false;
+	}
+	return true;
+}
+
+
+/* Function to show the current engine and the latest */
+/* tick telemetry after the default window caption.   */
+void SetCaption()
+{
+	char stats[384], caption[512];
+
+	FormatTelemetry(stats, sizeof(stats));
+	if (tiledMode)
+		snprintf(caption, sizeof(caption), "%s  [tiles %d/%d awake; %s]", DEFAULT_TITLE,
+				 tiledWorld.getAwakeCount(), tiledWorld.getTileCount(), stats);
+	else
+		snprintf(caption, sizeof(caption), "%s  [%s; %s]", DEFAULT_TITLE, currEngine->name, stats);
+	glutSetWindowTitle(caption);
+}
+
+
 /* Function to react to mouse clicks by generating a new circular */
 /* ripple centered at the current vertex, using the current color */
 /* and accompanied by a audio "beep" of the current frequency.    */
+/* The ripple is queued rather than inserted, so that other input */
+/* threads may create ripples concurrently; the next timer tick   */
+/* moves every queued ripple into the ripple list.                */
 void MouseClick(int mouseButton, int mouseState, int mouseXPosition, int mouseYPosition)
 {
 	Ripple currCircle;
@@ -182,11 +443,14 @@ void MouseClick(int mouseButton, int mouseState, int mouseXPosition, int mouseYP
 
 	if ( mouseState == GLUT_DOWN )
 	{
+		InputEvent event = { telemetry.tick, mouseInput, { x, y }, 0 };
+		watchdog.recordInput( event );
 		currCircle.pos[0] = x;
 		currCircle.pos[1] = y;
 		currCircle.rad = INITIAL_RADIUS;
 		currCircle.clr = currColor;
-		circleList.insert( currCircle );
+		currCircle.mask = currMask;
+		rippleQueue.push( currCircle );
 		Beep( BEEP_FREQUENCY[int(currColor)], BEEP_DURATION );
 	}
 	Display();
@@ -194,135 +458,327 @@ void MouseClick(int mouseButton, int mouseState, int mouseXPosition, int mouseYP
 
 
 /* Function to react to the pressing of keyboard keys by the user, */
-/* by changing the default color of newly generated ripples.       */
+/* by changing the default color of newly generated ripples. With  */
+/* SHIFT held, a color is added to the set of colors new ripples   */
+/* displace instead; such ripples are drawn in the set's average.  */
+/* The K key queues a checkpoint of the world instead.             */
 void KeyboardPress(unsigned char pressedKey, int mouseXPosition, int mouseYPosition)
 {
-	switch(pressedKey)
-	{
-		case 'w':
-		case 'W': { currColor = white;		break; }
-		case 'r':
-		case 'R': { currColor = red;		break; }
-		case 'y':
-		case 'Y': { currColor = yellow;		break; }
-		case 'g':
-		case 'G': { currColor = green;		break; }
-		case 'c':
-		case 'C': { currColor = cyan;		break; }
-		case 'b':
-		case 'B': { currColor = blue;		break; }
-		case 'm':
-		case 'M': { currColor = magenta;	break; }
-		case 'n':
-		case 'N': { currColor = none;		break; }
+	color picked;
+	char path[64];
+	InputEvent event = { telemetry.tick, keyInput, { 0.0f, 0.0f }, pressedKey };
+
+	watchdog.recordInput( event );
+	if (tolower(pressedKey) == 'k')
+	{
+		LinkedList<Ship> shipList;
+		LinkedList<Ripple> circleList;
+		ExportShips(shipList);
+		world.exportRipples(circleList);
+		snprintf(path, sizeof(path), "checkpoint_%ld.bin", telemetry.tick);
+		if (!WriteCheckpoint(SharedIoService(), path, telemetry.tick, CurrentWorldRecord(), shipList, circleList))
+			printf("Checkpoint %s could not be queued\n", path);
+		return;
+	}
+
+	switch(tolower(pressedKey))
+	{
+		case 'w': { picked = white;		break; }
+		case 'r': { picked = red;		break; }
+		case 'y': { picked = yellow;	break; }
+		case 'g': { picked = green;		break; }
+		case 'c': { picked = cyan;		break; }
+		case 'b': { picked = blue;		break; }
+		case 'm': { picked = magenta;	break; }
+		case 'n': { picked = none;		break; }
+		default:  return;
+	}
+
+	if ( isupper(pressedKey) && (picked != none) && (currColor != none) )
+		currMask |= ColorBit(picked);
+	else
+	{
+		currColor = picked;
+		currMask = ColorBit(picked);
 	}
 }
 
 
-/* Function to update the expanding radius values of all       */
-/* current ripples, removing those that exceed a certain size. */
-/* This function also activates the point displacement.        */
+/* Timer routine: moves the ripples queued since the previous */
+/* tick into the world (shedding the oldest if that puts the   */
+/* ripples over budget), then advances the world by one tick:  */
+/* its systems run, then the current displacement engine (or   */
+/* the tiled world's own stepping) moves the ships. A          */
+/* recording only queues the tick's ships; the I/O service     */
+/* writes them in the background. Each stage is timed, for the */
+/* watchdog to report on a hitch; while it is on, it keeps the */
+/* world the tick starts from, which is left out of the tick's */
+/* time. Scenario scripts run first, queueing ripples like     */
+/* clicks.                                                     */
 void TimerFunction(int value)
 {
-	int i;
-	Ripple currCircle;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	SchedulerStats stats;
+	double keptMs = 0.0;
+
+	tickStages.begin();
+	if (scriptMode)
+	{
+		scenarioContext.tick = telemetry.tick;
+		scenarioContext.nbrShips = tiledMode ? tiledWorld.getShipCount() : world.getShipCount();
+		scenarioContext.nbrRipples = world.getRippleCount();
+		scenarioContext.tickMs = telemetry.tickMs;
+		scenarioRunner.tick(scenarioContext);
+		tickStages.mark("script");
+	}
+	if (watchdog.isEnabled())
+	{
+		// The tick's input joins the world first, so the world kept is all the tick starts from. //
+		std::chrono::steady_clock::time_point keepStart = std::chrono::steady_clock::now();
+		LinkedList<Ship> shipList;
+		LinkedList<Ripple> circleList;
+
+		world.drainRipples( rippleQueue );
+		ExportShips(shipList);
+		world.exportRipples(circleList);
+		watchdog.keepStart(telemetry.tick, CurrentWorldRecord(), shipList, circleList);
+		keptMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - keepStart).count();
+		tickStages.mark("keep");
+	}
+	StepWorld();
+	if (recordStream >= 0)
+	{
+		LinkedList<Ship> shipList;
+		ExportShips(shipList);
+		RecordTick(SharedIoService(), recordStream, telemetry.tick + 1, shipList);
+		tickStages.mark("record");
+	}
 
-	for (i = 1; i <= circleList.getSize(); i++)
+	// Record this tick's cost and scheduler behavior. //
+	stats = SimulationPool().sampleSchedulerStats();
+	telemetry.tick++;
+	telemetry.tickMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() - keptMs;
+	telemetry.migrations = stats.migrations;
+	telemetry.involuntarySwitches = stats.involuntarySwitches;
+	watchdog.check(telemetry.tick, telemetry.tickMs, tiledMode ? "tiled" : currEngine->name, tickStages);
+	if ( (recordStream >= 0) || (captureStream >= 0) )
 	{
-		currCircle = circleList.getHeadValue();
-		circleList.removeHead();
-		currCircle.rad += RADIUS_INCREMENT;
-		if (currCircle.rad < FINAL_RADIUS)
-			circleList.insert( currCircle );
-		++circleList;
+		IoStats io = SharedIoService().getStats();
+		telemetry.ioBuffersInUse = io.buffersInUse;
+		telemetry.ioStalls = io.stalls;
 	}
-	DisplaceShips();
+	if (telemetry.tick % CAPTION_INTERVAL == 0)
+		SetCaption();
 
 	// Force a redraw after 20 milliseconds. //
 	glutPostRedisplay();
-	glutTimerFunc( 20, TimerFunction, 1 );
+	glutTimerFunc( TIMER_PERIOD, TimerFunction, 1 );
 }
 
-/* Function to cycle through the ships and determine whether */
-/* any ripple is encapsulating a ship's center. If so, the   */
-/* ship's position is modified to reflect the displacement   */
-/* caused by the emanating ripple.                           */
-void DisplaceShips()
+/* Principal display routine: clears the frame buffer and */
+/* draws the ripples and the ships within the window.     */
+void Display()
 {
-	int i, j;
+	int a, i;
+	Ripple currCircle;
 	Ship shp;
-	Ripple cir;
-	float intensity;
 
-	for (i = 1; i <= shipList.getSize(); i++)
+	glClear( GL_COLOR_BUFFER_BIT );
+	DrawObstacles();
+
+	for (a = 0; a < world.getArchetypeCount(); a++)
 	{
-		shp = shipList.getHeadValue();
-		shipList.removeHead();
-		for (j = 1; j <= circleList.getSize(); j++)
+		Archetype &archetype = world.getArchetype(a);
+		if (!archetype.isRipple())
+			continue;
+		for (i = 0; i < archetype.getSize(); i++)
+		{
+			currCircle = archetype.getRipple(i);
+			DrawRipple(currCircle);
+			if (worldBounds.wrap)
+			{
+				Ripple ghosts[MAX_GHOST_RIPPLES];
+				int nbrGhosts = GhostRipples(currCircle, worldBounds, ghosts);
+				for (int g = 0; g < nbrGhosts; g++)
+					DrawRipple(ghosts[g]);
+			}
+		}
+	}
+
+	for (a = 0; a < world.getArchetypeCount(); a++)
+	{
+		Archetype &archetype = world.getArchetype(a);
+		if (archetype.column<Hunter>() != NULL)
+			DrawPredators(archetype);
+		if (!archetype.isShip())
+			continue;
+		if (archetype.column<Trail>() != NULL)
+			DrawTrails(archetype);
+		for (i = 0; i < archetype.getSize(); i++)
 		{
-			cir = circleList.getHeadValue();
-
-			// If the flocker in question is the same color as the ripple, //
-			// or if the ripple is invisible, then displace the flocker.   //
-			if ( (cir.clr == none) || (cir.clr == shp.clr) )
-				if ( pow(cir.pos[0] - shp.pos[0], 2) + pow(cir.pos[1] - shp.pos[1], 2) < pow(cir.rad, 2) )
-				{
-					// The flocker's current position is altered by a vector //
-					// in the direction of the ripple's emanation, scaled    //
-					// to be inversely proportional to the ripple's current  //
-					// size, to represent the ripple's dissipation.          //
-					intensity = 0.05f * (FINAL_RADIUS - cir.rad) / (FINAL_RADIUS - INITIAL_RADIUS);
-					shp.delta[0] += intensity * (shp.pos[0] - cir.pos[0]);
-					shp.delta[1] += intensity * (shp.pos[1] - cir.pos[1]);
-					shp.pos[0] += intensity * (shp.pos[0] - cir.pos[0]);
-					shp.pos[1] += intensity * (shp.pos[1] - cir.pos[1]);
-				}
-			++circleList;
+			shp = archetype.getShip(i);
+			DrawShip(shp);
 		}
-		Normalize(shp.delta);
-		shipList.insert( shp );
-		++shipList;
+	}
+	tiledWorld.visitVisible(DrawShip);
+
+	if (captureStream >= 0)
+		CaptureFrame(SharedIoService(), captureStream, currWindowSize[0], currWindowSize[1]);
+	glutSwapBuffers();
+	glFlush();
+
+	if (telemetry.firstFrameMs < 0.0)
+	{
+		telemetry.firstFrameMs = MsSinceStartup();
+		printf("First frame after %.0f ms (world ready after %.0f ms)\n",
+			   telemetry.firstFrameMs, telemetry.worldReadyMs);
 	}
 }
 
 
-/* Principal display routine: clears the frame buffer and */
-/* draws the ripples and the ships within the window.     */
-void Display()
+/* Function to draw a ripple at its current position, with  */
+/* its current radius, and colored to dissipate as it       */
+/* expands. A ripple aimed at several colors is drawn in    */
+/* their average; an invisible one is not drawn at all.     */
+void DrawRipple(const Ripple &cir)
 {
-	int i;
-	Ripple currCircle;
-	Ship shp;
+	int i, c, nbrHues = 0;
+	float theta;
+	float hue[3] = { 0.0f, 0.0f, 0.0f };
+
+	if (cir.clr == none)
+		return;
+	for (c = 0; c < NBR_COLORS; c++)
+		if (cir.mask & (1 << c))
+		{
+			for (i = 0; i < 3; i++)
+				hue[i] += CIRCLE_COLOR[c][i];
+			nbrHues++;
+		}
+	for (i = 0; (i < 3) && (nbrHues > 0); i++)
+		hue[i] /= nbrHues;
+
+	float intensity = (FINAL_RADIUS - cir.rad) / (FINAL_RADIUS - INITIAL_RADIUS);
+	float currColor[3] = { intensity * hue[0],
+							intensity * hue[1],
+							intensity * hue[2] };
+	float thickness = 3.0f * intensity;
+	glColor3fv(currColor);
+	glLineWidth(thickness);
+
+	// Draw a polygonal approximation to the circle. //
+	glBegin(GL_LINES);
+	for (i = 1; i <= NBR_LINKS; i++)
+		{
+			theta = 360 * i * PI_OVER_180 / NBR_LINKS;
+			glVertex2f(cir.pos[0] + cir.rad * cos(theta), cir.pos[1] + cir.rad * sin(theta));
+			theta = 360 * (i + 1) * PI_OVER_180 / NBR_LINKS;
+			glVertex2f(cir.pos[0] + cir.rad * cos(theta), cir.pos[1] + cir.rad * sin(theta));
+		}
+	glEnd();
+}
+
+
+/* Function to draw a ship as a delta pointing the way it */
+/* heads, in its color.                                   */
+void DrawShip(const Ship &shp)
+{
+	float theta = atan2(shp.delta[1], shp.delta[0]);
+	float currColor[3] = { CIRCLE_COLOR[int(shp.clr)][0],
+							CIRCLE_COLOR[int(shp.clr)][1],
+							CIRCLE_COLOR[int(shp.clr)][2] };
+	glColor3fv(currColor);
+	glLineWidth(SHIP_THICKNESS);
+
+	// Draw a delta-shaped representation of the ship. //
+	glBegin(GL_TRIANGLE_FAN);
+		glVertex2f(shp.pos[0] + SHIP_RADIUS * cos(theta), shp.pos[1] + SHIP_RADIUS * sin(theta));
+		theta += 120 * PI_OVER_180;
+		glVertex2f(shp.pos[0] + SHIP_RADIUS * cos(theta), shp.pos[1] + SHIP_RADIUS * sin(theta));
+		glVertex2f(shp.pos[0], shp.pos[1]);
+		theta += 120 * PI_OVER_180;
+		glVertex2f(shp.pos[0] + SHIP_RADIUS * cos(theta), shp.pos[1] + SHIP_RADIUS * sin(theta));
+	glEnd();
+}
 
-	glClear( GL_COLOR_BUFFER_BIT );
 
-	for (i = 1; i <= circleList.getSize(); i++)
+/* Function to draw the trail behind each ship of an archetype */
+/* that has them, dimmed, from its oldest position to the ship. */
+void DrawTrails(Archetype &ships)
+{
+	Trail *trail = ships.column<Trail>();
+	Position *position = ships.column<Position>();
+	Hue *hue = ships.column<Hue>();
+
+	glLineWidth(1.0f);
+	for (int i = 0; i < ships.getSize(); i++)
 	{
-		currCircle = circleList.getHeadValue();
-		currCircle.draw();
-		++circleList;
+		int oldest = (trail[i].count < TRAIL_LENGTH) ? 0 : trail[i].next;
+		glColor3f(TRAIL_INTENSITY * CIRCLE_COLOR[int(hue[i].clr)][0],
+				  TRAIL_INTENSITY * CIRCLE_COLOR[int(hue[i].clr)][1],
+				  TRAIL_INTENSITY * CIRCLE_COLOR[int(hue[i].clr)][2]);
+		glBegin(GL_LINE_STRIP);
+		for (int t = 0; t < trail[i].count; t++)
+			glVertex2fv(trail[i].pos[(oldest + t) % TRAIL_LENGTH]);
+		glVertex2fv(position[i].pos);
+		glEnd();
 	}
+}
 
-	for (i = 1; i <= shipList.getSize(); i++)
+
+/* Function to outline every obstacle. */
+void DrawObstacles()
+{
+	glColor3fv(OBSTACLE_COLOR);
+	glLineWidth(SHIP_THICKNESS);
+	for (int o = 0; o < int(obstacles.size()); o++)
 	{
-		shp = shipList.getHeadValue();
-		shp.draw();
-		++shipList;
+		const Obstacle &obstacle = obstacles[o];
+		glBegin(GL_LINE_LOOP);
+		if (obstacle.vertices.empty())
+			for (int k = 0; k < NBR_LINKS; k++)
+				glVertex2f(obstacle.center[0] + obstacle.radius * cos(k * 360.0f / NBR_LINKS * PI_OVER_180),
+						   obstacle.center[1] + obstacle.radius * sin(k * 360.0f / NBR_LINKS * PI_OVER_180));
+		else
+			for (int k = 0; k < int(obstacle.vertices.size()); k += 2)
+				glVertex2f(obstacle.vertices[k], obstacle.vertices[k + 1]);
+		glEnd();
 	}
+}
 
-	glutSwapBuffers();
-	glFlush();
+
+/* Function to draw each predator of an archetype as a */
+/* diamond in its color, pointing the way it heads.    */
+void DrawPredators(Archetype &predators)
+{
+	Position *position = predators.column<Position>();
+	Heading *heading = predators.column<Heading>();
+	Hue *hue = predators.column<Hue>();
+
+	glLineWidth(SHIP_THICKNESS);
+	for (int i = 0; i < predators.getSize(); i++)
+	{
+		float ahead[2] = { heading[i].delta[0] / PREDATOR_SPEED, heading[i].delta[1] / PREDATOR_SPEED };
+		const float *pos = position[i].pos;
+
+		glColor3fv(CIRCLE_COLOR[int(hue[i].clr)]);
+		glBegin(GL_LINE_LOOP);
+			glVertex2f(pos[0] + 2.0f * PREDATOR_SIZE * ahead[0], pos[1] + 2.0f * PREDATOR_SIZE * ahead[1]);
+			glVertex2f(pos[0] - PREDATOR_SIZE * ahead[1], pos[1] + PREDATOR_SIZE * ahead[0]);
+			glVertex2f(pos[0] - PREDATOR_SIZE * ahead[0], pos[1] - PREDATOR_SIZE * ahead[1]);
+			glVertex2f(pos[0] + PREDATOR_SIZE * ahead[1], pos[1] - PREDATOR_SIZE * ahead[0]);
+		glEnd();
+	}
 }
 
 
 /* Random generation of the ships within the window.  */
 /* The color of each ship is also randomly generated. */
-void InitShips()
+/* The same seed always yields the same ships.        */
+void InitShips(LinkedList<Ship> &shipList, unsigned int seed)
 {
 	Ship shp;
-	time_t randomNumberSeed;
-	time(&randomNumberSeed);
-	srand((unsigned int)randomNumberSeed);
+	srand(seed);
 
 	for (int i = 1; i <= NBR_SHIPS; i++)
 	{
@@ -332,18 +788,148 @@ void InitShips()
 		shp.delta[1] = MIN_SHIP_DELTA + (float(rand()) / RAND_MAX) * (MAX_SHIP_DELTA - MIN_SHIP_DELTA);
 		Normalize(shp.delta);
 		shp.clr = color(rand() % NBR_COLORS);
+		shp.idle = 0;
 		shipList.insert(shp);
 	}
 }
 
 
-/* Normalize the parameterized vector. */
-void Normalize(float vector[])
+/* Function to populate the world (or, in tiled mode, the  */
+/* tiles) with the ships of the population file, if one was */
+/* given, or of the synthetic shape, if one was chosen, or  */
+/* else with random ships, the first NBR_TRAILED_SHIPS of   */
+/* which also carry a trail. Generated ships come from the  */
+/* seed. The obstacles, if any, are loaded and baked too.  */
+/* False is returned if a file cannot be loaded.            */
+bool InitWorld(unsigned int seed)
 {
-	float size = sqrt( pow(vector[0], 2) + pow(vector[1], 2) );
-	if (size > 0.0f)
-		for (int i = 0; i <= 1; i++)
-			vector[i] *= (VECTOR_SIZE / size);
+	LinkedList<Ship> shipList;
+	PopulationReport report;
+	WorkloadLayout layout;
+
+	if (!LoadObstacleField())
+		return false;
+
+	if (populationPath != NULL)
+	{
+		if (!LoadPopulation(populationPath, world, report))
+		{
+			printf("Cannot load ships from %s\n", populationPath);
+			return false;
+		}
+		if (report.nbrSkipped > 0)
+			printf("%s: %d malformed lines or records skipped\n", populationPath, report.nbrSkipped);
+	}
+	else if (generatedShape != NULL)
+	{
+		MakeWorkloadLayout(layout, windowWidth, windowHeight, seed);
+		GeneratePopulation(world, *generatedShape, nbrGenerated, layout, seed);
+	}
+	else
+	{
+		InitShips(shipList, seed);
+		for (int i = 0; !shipList.isEmpty(); i++)
+		{
+			world.addShip( shipList.getHeadValue(), (i < NBR_TRAILED_SHIPS) ? ComponentBit(trailComponent) : 0 );
+			shipList.removeHead();
+		}
+	}
+
+	if (nbrPredators > 0)
+		AddPredators(world, nbrPredators, worldBounds, seed);
+	if (tiledMode)
+		TileWorldShips();
+	return true;
+}
+
+
+/* Function to load the obstacles, if any, and bake them  */
+/* over the world's bounds. False is returned if the file */
+/* cannot be loaded.                                      */
+bool LoadObstacleField()
+{
+	int badLine;
+
+	if (obstaclePath == NULL)
+		return true;
+	if (!LoadObstacles(obstaclePath, obstacles, badLine))
+	{
+		if (badLine > 0)
+			printf("%s, line %d: expected \"circle x y r\" or \"polygon x1 y1 x2 y2 x3 y3 ...\"\n",
+				   obstaclePath, badLine);
+		else
+			printf("Cannot load obstacles from %s\n", obstaclePath);
+		return false;
+	}
+	obstacleField.bake(obstacles, worldBounds);
+	return true;
+}
+
+
+/* Function to move every ship of the world into the tiles, */
+/* in the world's order.                                    */
+void TileWorldShips()
+{
+	LinkedList<Ship> shipList;
+
+	world.exportShips(shipList);
+	world.clearShips();
+	while (!shipList.isEmpty())
+	{
+		tiledWorld.addShip( shipList.getHeadValue() );
+		shipList.removeHead();
+	}
+}
+
+
+/* Function to append every ship to a list, from the tiles */
+/* when they hold the ships and from the world otherwise.  */
+void ExportShips(LinkedList<Ship> &shipList)
+{
+	if (tiledMode)
+		tiledWorld.exportShips(shipList);
+	else
+		world.exportShips(shipList);
+}
+
+
+/* Function to describe the window's world for a checkpoint. */
+WorldRecord CurrentWorldRecord()
+{
+	WorldRecord settings = { worldBounds.width, worldBounds.height, int(worldBounds.wrap), int(tiledMode) };
+	return settings;
+}
+
+
+/* Function to advance the window's world by one tick: the  */
+/* predators, if any, hunt (queueing their ripples), the    */
+/* queued ripples join the world, the ripples over their    */
+/* budget are shed, and the world (or the tiles) steps      */
+/* forward, its ships then kept out of the obstacles. The   */
+/* predators and obstacles only see the world's ships, so   */
+/* ParseOptions refuses either with the tiles.              */
+void StepWorld()
+{
+	if (nbrPredators > 0)
+	{
+		shipClusters.build(world, worldBounds);
+		tickStages.mark("clusters");
+		StepPredators(world, shipClusters, rippleQueue, worldBounds);
+		tickStages.mark("hunt");
+	}
+	world.drainRipples( rippleQueue );
+	tickStages.mark("drain");
+	telemetry.droppedRipples += world.enforceRippleBudget();
+	tickStages.mark("budget");
+	if (tiledMode)
+		AdvanceTiledTick(tiledWorld, world, worldSystems, worldBounds);
+	else
+		AdvanceWorldTick(world, worldSystems, *currEngine, worldBounds);
+	if (obstacleField.isBaked())
+	{
+		CollideShips(world, obstacleField);
+		tickStages.mark("obstacles");
+	}
 }
 
 
@@ -370,4 +956,440 @@ void ResizeWindow(GLsizei w, GLsizei h)
         glOrtho(-1.0f * (GLfloat)w / (GLfloat)h, (GLfloat)w / (GLfloat)h, -1.0f, 1.0f, -10.0f, 10.0f);
 	}
     glMatrixMode( GL_MODELVIEW );
+	worldBounds.width = windowWidth;
+	worldBounds.height = windowHeight;
+	obstacleField.bake(obstacles, worldBounds);
+	tiledWorld.setCamera(-0.5f * windowWidth, 0.5f * windowWidth, -0.5f * windowHeight, 0.5f * windowHeight);
+}
+
+
+/* Contention benchmark for the ripple queue: several producer */
+/* threads push ripples as fast as they can while this thread  */
+/* drains the queue in bulk, as the timer tick would.          */
+void BenchmarkRippleQueue(int nbrProducers)
+{
+	LockFreeStack<Ripple> queue;
+	LinkedList<Ripple> drained;
+	std::thread *producers = new std::thread[nbrProducers];
+	long total = long(nbrProducers) * QUEUE_BENCH_RIPPLES;
+	long received = 0;
+	long drains = 0;
+	int i;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (i = 0; i < nbrProducers; i++)
+		producers[i] = std::thread([&queue, i]()
+		{
+			Ripple cir;
+			cir.pos[0] = cir.pos[1] = 0.0f;
+			cir.rad = INITIAL_RADIUS;
+			cir.setColor( color(i % NBR_COLORS) );
+			for (int j = 0; j < QUEUE_BENCH_RIPPLES; j++)
+				queue.push( cir );
+		});
+
+	while (received < total)
+	{
+		received += queue.drainInto( drained );
+		drains++;
+		while (drained.removeHead())
+			;
+	}
+	for (i = 0; i < nbrProducers; i++)
+		producers[i].join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	delete [] producers;
+
+	printf("%d producers, %ld ripples, %ld drains: %.3f s (%.1f ns/ripple)\n",
+		   nbrProducers, total, drains, seconds, 1.0e9 * seconds / total);
+}
+
+
+/* Headless comparison of two displacement engines: both start */
+/* from the same random ships, and the same random ripple      */
+/* falls on both every few ticks. The first tick and ship on   */
+/* which they disagree is reported.                            */
+void LockstepCommand(const char *nameA, const char *nameB, long nbrTicks)
+{
+	const SimulationEngine *engineA = FindEngine(nameA);
+	const SimulationEngine *engineB = FindEngine(nameB);
+	vector<RippleEvent> events;
+	mt19937 rng((unsigned int)time(NULL));
+	DivergenceReport report;
+	LinkedList<Ship> shipList;
+	LinkedList<Ripple> circleList;
+	float tolerance;
+
+	if ( (engineA == NULL) || (engineB == NULL) )
+	{
+		printf("Unknown engine: %s\n", (engineA == NULL) ? nameA : nameB);
+		return;
+	}
+	InitShips(shipList, (unsigned int)time(NULL));
+	GenerateRippleEvents(events, nbrTicks, LOCKSTEP_RIPPLE_ODDS, windowWidth, windowHeight, rng);
+
+	tolerance = (engineA->exact && engineB->exact) ? 0.0f : LOCKSTEP_TOLERANCE;
+	report = RunLockstep(*engineA, *engineB, shipList, circleList, events, nbrTicks, tolerance);
+	if (!report.diverged)
+		printf("%s and %s agree for %ld ticks (tolerance %g)\n", nameA, nameB, nbrTicks, tolerance);
+	else if (report.ship < 0)
+		printf("%s and %s diverge at tick %ld: ship counts differ\n", nameA, nameB, report.tick);
+	else
+		printf("%s and %s diverge at tick %ld, ship %d: (%g, %g) vs (%g, %g)\n",
+			   nameA, nameB, report.tick, report.ship,
+			   report.expected.pos[0], report.expected.pos[1],
+			   report.actual.pos[0], report.actual.pos[1]);
+}
+
+
+/* I/O benchmark: runs the simulation at its usual tick rate,  */
+/* first alone and then while queueing IO_BENCH_RATE megabytes */
+/* per second to "path" through the shared I/O service, and    */
+/* reports what the writing added to the tick thread's time.   */
+void BenchmarkIoService(const char *path)
+{
+	IoService &io = SharedIoService();
+	int stream = io.openStream(path);
+	int buffersPerTick = int( (long long)IO_BENCH_RATE * (1 << 20) * TIMER_PERIOD / 1000 / IO_BUFFER_SIZE );
+	vector<char *> buffers(buffersPerTick);
+	vector<RippleEvent> events;
+	mt19937 rng(1);
+	double meanMs[2], worstMs[2];
+	std::chrono::steady_clock::time_point started;
+	double seconds;
+	IoStats stats;
+	LinkedList<Ship> shipList;
+	EntityWorld benchWorld;
+	SystemSchedule benchSystems(WORLD_SYSTEMS, NBR_WORLD_SYSTEMS);
+
+	if (stream < 0)
+	{
+		printf("Cannot open %s\n", path);
+		return;
+	}
+	InitShips(shipList, (unsigned int)time(NULL));
+	while (!shipList.isEmpty())
+	{
+		benchWorld.addShip(shipList.getHeadValue(), 0);
+		shipList.removeHead();
+	}
+	GenerateRippleEvents(events, IO_BENCH_TICKS, LOCKSTEP_RIPPLE_ODDS, windowWidth, windowHeight, rng);
+
+	for (int phase = 0; phase < 2; phase++)
+	{
+		int nextEvent = 0;
+		meanMs[phase] = worstMs[phase] = 0.0;
+		if (phase == 1)
+			started = std::chrono::steady_clock::now();
+		for (long tick = 1; tick <= IO_BENCH_TICKS; tick++)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			double ms;
+
+			while ( (nextEvent < int(events.size())) && (events[nextEvent].tick <= tick) )
+				benchWorld.addRipple( events[nextEvent++].ripple );
+			AdvanceWorldTick(benchWorld, benchSystems, *currEngine, worldBounds);
+			if ( (phase == 1) && io.acquireBuffers(buffersPerTick, &buffers[0]) )
+				for (int b = 0; b < buffersPerTick; b++)
+					io.submit(stream, buffers[b], IO_BUFFER_SIZE);
+
+			ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			meanMs[phase] += ms / IO_BENCH_TICKS;
+			if (ms > worstMs[phase])
+				worstMs[phase] = ms;
+			std::this_thread::sleep_until(start + std::chrono::milliseconds(TIMER_PERIOD));
+		}
+	}
+	io.closeStream(stream);
+	io.flush();
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+	stats = io.getStats();
+
+	printf("tick alone:        mean %.3f ms, worst %.3f ms\n", meanMs[0], worstMs[0]);
+	printf("tick with writing: mean %.3f ms, worst %.3f ms\n", meanMs[1], worstMs[1]);
+	printf("%.1f MB written at %.1f MB/s in %ld batches; %ld stalls, %ld failed writes\n",
+		   stats.bytesWritten / 1048576.0, stats.bytesWritten / 1048576.0 / seconds,
+		   stats.batches, stats.stalls, stats.failedWrites);
+}
+
+
+/* Replay: loads a checkpoint into the window's world, under  */
+/* the bounds, wrapping and mode it was taken with, and steps  */
+/* it headlessly along the window's own path (see StepWorld),  */
+/* reporting the mean tick time and the stage timings of the   */
+/* slowest tick, for offline profiling. The engine, obstacles  */
+/* and predators come from the options, as in the window.      */
+void ReplayCheckpoint(const char *path, long nbrTicks)
+{
+	StageTimer slowest;
+	double totalMs = 0.0, worstMs = -1.0;
+	long firstTick;
+	WorldRecord settings;
+	LinkedList<Ship> shipList;
+	LinkedList<Ripple> circleList;
+
+	if (!ReadCheckpoint(path, firstTick, settings, shipList, circleList))
+	{
+		printf("Cannot read checkpoint %s\n", path);
+		return;
+	}
+	worldBounds.width = settings.width;
+	worldBounds.height = settings.height;
+	worldBounds.wrap = (settings.wrap != 0);
+	tiledMode = (settings.tiled != 0);
+	printf("%s: tick %ld, %d ships, %d ripples, %.2f x %.2f%s, engine %s\n",
+		   path, firstTick, shipList.getSize(), circleList.getSize(), worldBounds.width, worldBounds.height,
+		   worldBounds.wrap ? " torus" : "", tiledMode ? "tiled" : currEngine->name);
+
+	if (!LoadObstacleField())
+		return;
+	while (!shipList.isEmpty())
+	{
+		world.addShip( shipList.getHeadValue(), 0 );
+		shipList.removeHead();
+	}
+	world.importRipples(circleList);
+	if (nbrPredators > 0)
+		AddPredators(world, nbrPredators, worldBounds, (unsigned int)firstTick);
+	if (tiledMode)
+		TileWorldShips();
+
+	for (long tick = 1; tick <= nbrTicks; tick++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		double ms;
+
+		tickStages.begin();
+		StepWorld();
+		ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		totalMs += ms;
+		if (ms > worstMs)
+		{
+			worstMs = ms;
+			slowest = tickStages;
+		}
+	}
+	if (nbrTicks <= 0)
+		return;
+
+	printf("%ld ticks: mean %.3f ms, worst %.3f ms\n", nbrTicks, totalMs / nbrTicks, worstMs);
+	printf("worst tick's stages:");
+	for (int s = 0; s < slowest.getCount(); s++)
+		printf(" %s %.3f ms", slowest.getName(s), slowest.getMs(s));
+	printf("\n");
+}
+
+
+/* Function to run a built-in scenario headlessly for the given */
+/* number of ticks, on ships generated from the seed, so that   */
+/* the same seed replays the same workload.  The scripts run    */
+/* before each tick, as they would in the window; afterwards,   */
+/* the mean tick, the scripts' cost per resumption, and the     */
+/* failed checks are reported.                                  */
+void ScenarioCommand(const char *name, long nbrTicks, unsigned int seed)
+{
+	ScenarioRunner runner;
+	ScenarioContext ctx(rippleQueue, seed);
+	double totalMs = 0.0, lastMs = 0.0;
+
+	if (!BuildScenario(name, runner, windowWidth, windowHeight, seed))
+	{
+		printf("Unknown scenario: %s (rain, storm or sweep)\n", name);
+		return;
+	}
+	if (!InitWorld(seed))
+		return;
+	printf("%s: %d scripts, %d ships, seed %u, engine %s\n",
+		   name, runner.getActiveCount(), tiledMode ? tiledWorld.getShipCount() : world.getShipCount(), seed, currEngine->name);
+
+	for (long tick = 0; tick < nbrTicks; tick++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		ctx.tick = tick;
+		ctx.nbrShips = tiledMode ? tiledWorld.getShipCount() : world.getShipCount();
+		ctx.nbrRipples = world.getRippleCount();
+		ctx.tickMs = lastMs;
+		tickStages.begin();
+		runner.tick(ctx);
+		tickStages.mark("script");
+		StepWorld();
+		lastMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		totalMs += lastMs;
+	}
+	if (nbrTicks <= 0)
+		return;
+
+	printf("%ld ticks: mean %.3f ms, %d ripples spawned, %d alive at the end\n",
+		   nbrTicks, totalMs / nbrTicks, ctx.getSpawned(), world.getRippleCount());
+	printf("%ld resumptions: %.1f ns each; %d scripts still running\n",
+		   runner.getResumes(), runner.getResumeNs(), runner.getActiveCount());
+	printf("%d checks failed\n", ctx.getFailures());
+}
+
+
+/* Function to time loading a population file (see -ships) */
+/* into an empty world, and to report what it held.        */
+void LoadCommand(const char *path)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	PopulationReport report;
+	double ms;
+
+	if (!LoadPopulation(path, world, report))
+	{
+		printf("Cannot load ships from %s\n", path);
+		return;
+	}
+	ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	printf("%s: %d ships, %d ripples, %d malformed lines or records skipped, loaded in %.1f ms\n",
+		   path, report.nbrShips, report.nbrRipples, report.nbrSkipped, ms);
+}
+
+
+/* Benchmark: times the current engine (or the tiles) on a   */
+/* synthetic population of each chosen shape under each      */
+/* chosen ripple pattern ("all" runs every one), with        */
+/* BENCH_RIPPLES_PER_TICK ripples a tick. A shape and pattern */
+/* pair always gets the same workload from the same seed.    */
+void BenchmarkWorkloads(const char *shapeName, const char *patternName, int nbrShips, long nbrTicks,
+						unsigned int seed)
+{
+	bool allShapes = (strcmp(shapeName, "all") == 0), allPatterns = (strcmp(patternName, "all") == 0);
+	const PopulationShape *shape = allShapes ? &POPULATION_SHAPES[0] : FindPopulationShape(shapeName);
+	const RipplePattern *pattern = allPatterns ? &RIPPLE_PATTERNS[0] : FindRipplePattern(patternName);
+
+	if ( (shape == NULL) || (pattern == NULL) )
+	{
+		printf("Unknown %s: %s\n", (shape == NULL) ? "population shape" : "ripple pattern",
+			   (shape == NULL) ? shapeName : patternName);
+		return;
+	}
+	printf("%d ships, %d predators, %ld ticks, %d ripples per tick, seed %u, engine %s\n",
+		   nbrShips, nbrPredators, nbrTicks, BENCH_RIPPLES_PER_TICK, seed, tiledMode ? "tiled" : currEngine->name);
+
+	for (int s = 0; s < (allShapes ? NBR_POPULATION_SHAPES : 1); s++)
+		for (int p = 0; p < (allPatterns ? NBR_RIPPLE_PATTERNS : 1); p++)
+			RunWorkload(allShapes ? POPULATION_SHAPES[s] : *shape, allPatterns ? RIPPLE_PATTERNS[p] : *pattern,
+						nbrShips, nbrTicks, seed);
+}
+
+
+/* Function to run one benchmark workload from an empty world */
+/* and to report its generation time and its tick times, and  */
+/* how much of them the predators took, against the tick's    */
+/* TIMER_PERIOD.                                              */
+void RunWorkload(const PopulationShape &shape, const RipplePattern &pattern, int nbrShips, long nbrTicks,
+				 unsigned int seed)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	WorkloadLayout layout;
+	vector<RippleEvent> events;
+	double generateMs, totalMs = 0.0, worstMs = 0.0, huntMs = 0.0;
+	int nextEvent = 0;
+
+	world.clearShips();
+	world.clearRipples();
+	world.archetypeFor(PREDATOR_COMPONENTS).clear();
+	tiledWorld.clear();
+	MakeWorkloadLayout(layout, windowWidth, windowHeight, seed);
+	GeneratePopulation(world, shape, nbrShips, layout, seed);
+	AddPredators(world, nbrPredators, worldBounds, seed);
+	GenerateRipplePattern(events, pattern, nbrTicks, BENCH_RIPPLES_PER_TICK, layout, seed);
+	if (tiledMode)
+		TileWorldShips();
+	generateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	for (long tick = 1; tick <= nbrTicks; tick++)
+	{
+		double ms;
+
+		start = std::chrono::steady_clock::now();
+		while ( (nextEvent < int(events.size())) && (events[nextEvent].tick <= tick) )
+			rippleQueue.push( events[nextEvent++].ripple );
+		tickStages.begin();
+		StepWorld();
+		ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		totalMs += ms;
+		if (ms > worstMs)
+			worstMs = ms;
+		for (int s = 0; s < tickStages.getCount(); s++)
+			if ( (strcmp(tickStages.getName(s), "clusters") == 0) || (strcmp(tickStages.getName(s), "hunt") == 0) )
+				huntMs += tickStages.getMs(s);
+	}
+	if (nbrTicks <= 0)
+		return;
+
+	printf("%-8s %-7s generated in %.1f ms; tick mean %.3f ms (predators %.3f ms), worst %.3f ms of %d%s\n",
+		   shape.name, pattern.name, generateMs, totalMs / nbrTicks, huntMs / nbrTicks, worstMs, TIMER_PERIOD,
+		   (worstMs <= TIMER_PERIOD) ? "" : " (behind real time)");
+}
+
+
+/* Host mode: runs "nbrSessions" sessions at once, each with  */
+/* a world of its own (of the -generate shape and size, or    */
+/* uniform, and the window's bounds) and an even share of the */
+/* ripple budget, ticking every TIMER_PERIOD ms with a        */
+/* latency objective of "objectiveMs", and reports each one's */
+/* tick latencies (from the ticks' due times) and ripples. A  */
+/* feeder thread posts every session's input as it falls due: */
+/* HOST_KIOSK_RIPPLES rain ripples a tick, but "stormRipples" */
+/* hotspot ripples a tick for the first session, if that is   */
+/* not zero.                                                  */
+void HostCommand(int nbrSessions, long nbrTicks, double objectiveMs, int stormRipples, unsigned int seed)
+{
+	const PopulationShape *shape = (generatedShape != NULL) ? generatedShape : FindPopulationShape("uniform");
+	vector< vector<RippleEvent> > inputs(nbrSessions > 0 ? nbrSessions : 0);
+	std::chrono::duration<double, std::milli> period(TIMER_PERIOD);
+	std::chrono::steady_clock::time_point start;
+	SessionHost host(TIMER_PERIOD);
+	WorkloadLayout layout;
+
+	if ( (nbrSessions < 1) || (nbrTicks < 1) || (objectiveMs <= 0.0) )
+	{
+		printf("Usage: -host sessions ticks objective-ms [storm-ripples [seed]]\n");
+		return;
+	}
+	for (int s = 0; s < nbrSessions; s++)
+	{
+		Session &session = host.addSession(*currEngine, objectiveMs, worldBounds,
+										   GetMemoryBudget(rippleMemory) / nbrSessions);
+		bool storm = (s == 0) && (stormRipples > 0);
+
+		MakeWorkloadLayout(layout, windowWidth, windowHeight, seed + s);
+		GeneratePopulation(session.getWorld(), *shape, nbrGenerated, layout, seed + s);
+		GenerateRipplePattern(inputs[s], *FindRipplePattern(storm ? "hotspot" : "rain"), nbrTicks,
+							  storm ? stormRipples : HOST_KIOSK_RIPPLES, layout, seed + s);
+	}
+	printf("%d sessions of %d %s ships, %ld ticks of %d ms, objective %.1f ms, %d storm ripples a tick, "
+		   "%d workers, engine %s\n", nbrSessions, nbrGenerated, shape->name, nbrTicks, TIMER_PERIOD, objectiveMs,
+		   stormRipples, SimulationPool().getWorkerCount(), currEngine->name);
+
+	// Each tick's input is posted half a period before the tick is due. //
+	start = std::chrono::steady_clock::now() + std::chrono::milliseconds(TIMER_PERIOD);
+	std::thread feeder([&host, &inputs, &period, start, nbrTicks]()
+	{
+		vector<int> next(inputs.size(), 0);
+
+		for (long tick = 1; tick <= nbrTicks; tick++)
+		{
+			std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+												  period * (tick - 1.5)));
+			for (int s = 0; s < int(inputs.size()); s++)
+				while ( (next[s] < int(inputs[s].size())) && (inputs[s][next[s]].tick <= tick) )
+					host.getSession(s).postRipple( inputs[s][next[s]++].ripple );
+		}
+	});
+	host.run(nbrTicks, start);
+	feeder.join();
+
+	for (int s = 0; s < nbrSessions; s++)
+	{
+		SessionReport r = host.getSession(s).report();
+
+		printf("session %d%s: tick mean %.2f ms, median %.2f, p99 %.2f, worst %.2f; %.1f%% within objective; "
+			   "%ld ripples admitted, %ld held back, %ld shed\n", s, ( (s == 0) && (stormRipples > 0) ) ? " (storm)" : "",
+			   r.meanMs, r.medianMs, r.p99Ms, r.worstMs, 100.0 * r.withinObjective / r.ticks, r.admitted, r.heldBack,
+			   r.shed);
+	}
 }
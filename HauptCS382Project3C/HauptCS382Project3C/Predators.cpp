@@ -0,0 +1,346 @@
+/////////////////////////////////////////////////////////////////
+// Class implementation file: Predators.cpp                    //
+//                                                             //
+// The cluster grid covers the world with cells no smaller     //
+// than CLUSTER_CELL, coarsened if need be so that neither     //
+// side has more than MAX_CLUSTER_SIDE cells; ships beyond the //
+// edge are binned into the edge cells.  A predator steers a   //
+// share PREDATOR_TURN of the way toward its target each tick  //
+// and always moves PREDATOR_SPEED; on a bounded world it      //
+// turns back at the edges.                                    //
+/////////////////////////////////////////////////////////////////
+
+#include "Predators.h"
+#include "WorkerPool.h"
+#include <cmath>
+#include <random>
+using namespace std;
+
+/* Function to find the cell, of "nbrCells" from "origin", */
+/* that holds coordinate v, clamped into the grid.         */
+static inline int CellOf(float v, float origin, float perCell, int nbrCells)
+{
+	float at = (v - origin) * perCell;
+	return (at < 1.0f) ? 0 : ((at >= nbrCells) ? nbrCells - 1 : int(at));
+}
+
+////////////////////////////////////////////////////
+// IMPLEMENTATION SECTION FOR CLUSTER GRID CLASS  //
+////////////////////////////////////////////////////
+
+//////////////////////////////////////////
+// Default constructor: No cells yet.   //
+//////////////////////////////////////////
+ClusterGrid::ClusterGrid()
+{
+	columns = rows = 0;
+	left = bottom = 0.0f;
+	cellSize = CLUSTER_CELL;
+	perCell = 1.0f / CLUSTER_CELL;
+	bounds = worldBounds;
+}
+
+//////////////////////////////////////////////////////////
+// Function to rebin every ship of the world. Each task //
+// bins CLUSTER_GRAIN rows of one ship archetype into a //
+// grid of its own; the grids are then summed.          //
+//////////////////////////////////////////////////////////
+void ClusterGrid::build(EntityWorld &world, const WorldBounds &bounds)
+{
+	struct binTask
+	{
+		Archetype *archetype;
+		int begin, end;
+	};
+	vector<binTask> tasks;
+	vector< vector<cell> > partials;
+	float side = (bounds.width > bounds.height) ? bounds.width : bounds.height;
+	int nbrCells, t, i;
+
+	this->bounds = bounds;
+	cellSize = (side / MAX_CLUSTER_SIDE > CLUSTER_CELL) ? side / MAX_CLUSTER_SIDE : CLUSTER_CELL;
+	perCell = 1.0f / cellSize;
+	columns = int(ceil(bounds.width / cellSize));
+	rows = int(ceil(bounds.height / cellSize));
+	columns = (columns < 1) ? 1 : columns;
+	rows = (rows < 1) ? 1 : rows;
+	left = -0.5f * bounds.width;
+	bottom = -0.5f * bounds.height;
+	nbrCells = columns * rows * NBR_COLORS;
+
+	for (int a = 0; a < world.getArchetypeCount(); a++)
+	{
+		Archetype &archetype = world.getArchetype(a);
+		if (!archetype.isShip())
+			continue;
+		for (int begin = 0; begin < archetype.getSize(); begin += CLUSTER_GRAIN)
+		{
+			binTask task = { &archetype, begin, (begin + CLUSTER_GRAIN < archetype.getSize()) ? begin + CLUSTER_GRAIN
+																							  : archetype.getSize() };
+			tasks.push_back(task);
+		}
+	}
+
+	cell empty = { 0, { 0.0f, 0.0f } };
+	partials.assign(tasks.size(), vector<cell>(nbrCells, empty));
+	SimulationPool().parallelFor(int(tasks.size()), 1, [this, &tasks, &partials](int begin, int end)
+	{
+		// The grid's shape is copied, since the cells' stores might otherwise alias it. //
+		const int nbrColumns = columns, nbrRows = rows;
+		const float x0 = left, y0 = bottom, scale = perCell;
+
+		for (int k = begin; k < end; k++)
+		{
+			const Position *position = tasks[k].archetype->column<Position>();
+			const Hue *hue = tasks[k].archetype->column<Hue>();
+			cell *grid = &partials[k][0];
+
+			for (int row = tasks[k].begin; row < tasks[k].end; row++)
+			{
+				cell &c = grid[ (CellOf(position[row].pos[1], y0, scale, nbrRows) * nbrColumns +
+								 CellOf(position[row].pos[0], x0, scale, nbrColumns)) * NBR_COLORS + int(hue[row].clr) ];
+				c.count++;
+				c.sum[0] += position[row].pos[0];
+				c.sum[1] += position[row].pos[1];
+			}
+		}
+	});
+
+	cells.assign(nbrCells, empty);
+	for (t = 0; t < int(partials.size()); t++)
+		for (i = 0; i < nbrCells; i++)
+		{
+			cells[i].count += partials[t][i].count;
+			cells[i].sum[0] += partials[t][i].sum[0];
+			cells[i].sum[1] += partials[t][i].sum[1];
+		}
+}
+
+//////////////////////////////////////////////////////////
+// Function to find the centroid, nearest to "pos", of  //
+// a cell holding CLUSTER_MIN_SHIPS ships of color clr. //
+// Rings of cells are searched outward until no farther //
+// ring could hold anything nearer. On a torus the      //
+// rings wrap around the grid, and "target" is the      //
+// centroid's image nearest "pos", perhaps beyond the   //
+// edge. False is returned if there is no such cluster. //
+//////////////////////////////////////////////////////////
+bool ClusterGrid::nearest(const float pos[], color clr, float target[]) const
+{
+	int column0 = columnOf(pos[0]), row0 = rowOf(pos[1]);
+	int reach = (columns > rows) ? columns : rows;
+	float best = -1.0f;
+
+	if ( cells.empty() || (int(clr) >= NBR_COLORS) )
+		return false;
+	if (bounds.wrap)
+		reach = reach / 2 + 1;
+	for (int d = 0; d < reach; d++)
+	{
+		// Every cell of ring d lies at least d - 1 cells away. //
+		if ( (best >= 0.0f) && ((d - 1) * cellSize > best) )
+			break;
+		for (int r = row0 - d; r <= row0 + d; r++)
+		{
+			int step = ( (r == row0 - d) || (r == row0 + d) ) ? 1 : 2 * d;
+			int row = wrapIndex(r, rows);
+			if (row < 0)
+				continue;
+			for (int c = column0 - d; c <= column0 + d; c += step)
+			{
+				int column = wrapIndex(c, columns);
+				const cell *k;
+				float toward[2], distance;
+
+				if (column < 0)
+					continue;
+				k = &cells[(row * columns + column) * NBR_COLORS + int(clr)];
+				if (k->count < CLUSTER_MIN_SHIPS)
+					continue;
+				toward[0] = k->sum[0] / k->count - pos[0];
+				toward[1] = k->sum[1] / k->count - pos[1];
+				if (bounds.wrap)
+				{
+					toward[0] -= bounds.width * floor(toward[0] / bounds.width + 0.5f);
+					toward[1] -= bounds.height * floor(toward[1] / bounds.height + 0.5f);
+				}
+				distance = sqrt( pow(toward[0], 2) + pow(toward[1], 2) );
+				if ( (best < 0.0f) || (distance < best) )
+				{
+					best = distance;
+					target[0] = pos[0] + toward[0];
+					target[1] = pos[1] + toward[1];
+				}
+			}
+		}
+	}
+	return (best >= 0.0f);
+}
+
+//////////////////////////////////////////////////////////
+// Function to count the cells and colors that hold a   //
+// cluster, for reports.                                //
+//////////////////////////////////////////////////////////
+int ClusterGrid::getClusterCount() const
+{
+	int count = 0;
+	for (int i = 0; i < int(cells.size()); i++)
+		if (cells[i].count >= CLUSTER_MIN_SHIPS)
+			count++;
+	return count;
+}
+
+//////////////////////////////////////////////////////
+// Functions to find the column and row of a point, //
+// clamped into the grid.                           //
+//////////////////////////////////////////////////////
+int ClusterGrid::columnOf(float x) const
+{
+	return CellOf(x, left, perCell, columns);
+}
+
+int ClusterGrid::rowOf(float y) const
+{
+	return CellOf(y, bottom, perCell, rows);
+}
+
+//////////////////////////////////////////////////////////
+// Function to bring a column or row index that may lie //
+// off the grid back onto it: around the grid on a      //
+// torus, or to -1 (no cell) on a bounded world.        //
+//////////////////////////////////////////////////////////
+int ClusterGrid::wrapIndex(int index, int nbrCells) const
+{
+	if (bounds.wrap)
+		return ((index % nbrCells) + nbrCells) % nbrCells;
+	return ( (index < 0) || (index >= nbrCells) ) ? -1 : index;
+}
+
+/////////////////////////////////////////
+// IMPLEMENTATION SECTION FOR HUNTING  //
+/////////////////////////////////////////
+
+/* Function to add predators anywhere in the world, each of a */
+/* random color and heading, with its own period between      */
+/* ripples and a first ripple due at a random point in it, so */
+/* that the predators do not all fire on the same tick.       */
+void AddPredators(EntityWorld &world, int nbrPredators, const WorldBounds &bounds, unsigned int seed)
+{
+	Archetype &predators = world.archetypeFor(PREDATOR_COMPONENTS);
+	int first = predators.appendRows(nbrPredators);
+	Position *position = predators.column<Position>();
+	Heading *heading = predators.column<Heading>();
+	Hue *hue = predators.column<Hue>();
+	Hunter *hunter = predators.column<Hunter>();
+	mt19937 rng(seed);
+	uniform_real_distribution<float> across(-0.5f * bounds.width, 0.5f * bounds.width);
+	uniform_real_distribution<float> down(-0.5f * bounds.height, 0.5f * bounds.height);
+	uniform_real_distribution<float> angle(0.0f, 360.0f * PI_OVER_180);
+	uniform_int_distribution<int> tint(0, NBR_COLORS - 1);
+	uniform_int_distribution<int> period(PREDATOR_PERIOD[0], PREDATOR_PERIOD[1]);
+
+	for (int i = first; i < first + nbrPredators; i++)
+	{
+		float theta = angle(rng);
+		position[i].pos[0] = across(rng);
+		position[i].pos[1] = down(rng);
+		heading[i].delta[0] = PREDATOR_SPEED * cos(theta);
+		heading[i].delta[1] = PREDATOR_SPEED * sin(theta);
+		hue[i].clr = color(tint(rng));
+		hunter[i].period = period(rng);
+		hunter[i].cooldown = uniform_int_distribution<int>(1, hunter[i].period)(rng);
+	}
+}
+
+
+/* Function to count the predators in the world. */
+int CountPredators(EntityWorld &world)
+{
+	int count = 0;
+	for (int a = 0; a < world.getArchetypeCount(); a++)
+		if (world.getArchetype(a).column<Hunter>() != NULL)
+			count += world.getArchetype(a).getSize();
+	return count;
+}
+
+
+/* Function to step every predator on the worker pool: each  */
+/* turns toward the nearest cluster of its color and moves,  */
+/* and, when its cooldown has run out and the cluster is     */
+/* within PREDATOR_STRIKE_RANGE, fires a ripple of its color */
+/* where it stands. The ripples are queued once the pool is  */
+/* done, in the predators' order, so that a run's ripples do */
+/* not depend on which worker stepped which predator. The    */
+/* number queued is returned.                                */
+int StepPredators(EntityWorld &world, const ClusterGrid &clusters, LockFreeStack<Ripple> &queue,
+				  const WorldBounds &bounds)
+{
+	vector<unsigned char> firing;
+	int fired = 0;
+
+	for (int a = 0; a < world.getArchetypeCount(); a++)
+	{
+		Archetype &predators = world.getArchetype(a);
+		Position *position = predators.column<Position>();
+		Heading *heading = predators.column<Heading>();
+		Hue *hue = predators.column<Hue>();
+		Hunter *hunter = predators.column<Hunter>();
+
+		if (hunter == NULL)
+			continue;
+		firing.assign(predators.getSize(), 0);
+		SimulationPool().parallelFor(predators.getSize(), PREDATOR_GRAIN,
+			[&clusters, &bounds, &firing, position, heading, hue, hunter](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				float target[2], distance = -1.0f, size;
+
+				if (clusters.nearest(position[i].pos, hue[i].clr, target))
+				{
+					float toward[2] = { target[0] - position[i].pos[0], target[1] - position[i].pos[1] };
+					distance = sqrt( pow(toward[0], 2) + pow(toward[1], 2) );
+					if (distance > 0.0f)
+						for (int k = 0; k <= 1; k++)
+							heading[i].delta[k] += PREDATOR_TURN * (PREDATOR_SPEED * toward[k] / distance - heading[i].delta[k]);
+				}
+				size = sqrt( pow(heading[i].delta[0], 2) + pow(heading[i].delta[1], 2) );
+				for (int k = 0; k <= 1; k++)
+				{
+					float half = 0.5f * ((k == 0) ? bounds.width : bounds.height);
+					if (size > 0.0f)
+						heading[i].delta[k] *= PREDATOR_SPEED / size;
+					position[i].pos[k] += heading[i].delta[k];
+					if ( !bounds.wrap && (fabs(position[i].pos[k]) > half) )
+					{
+						position[i].pos[k] = (position[i].pos[k] > 0.0f) ? half : -half;
+						heading[i].delta[k] = -heading[i].delta[k];
+					}
+				}
+				if (bounds.wrap)
+					WrapPosition(position[i].pos, bounds);
+
+				if (hunter[i].cooldown > 0)
+					hunter[i].cooldown--;
+				if ( (hunter[i].cooldown == 0) && (distance >= 0.0f) && (distance < PREDATOR_STRIKE_RANGE) )
+				{
+					firing[i] = 1;
+					hunter[i].cooldown = hunter[i].period;
+				}
+			}
+		});
+
+		for (int i = 0; i < predators.getSize(); i++)
+			if (firing[i])
+			{
+				Ripple cir;
+				cir.pos[0] = position[i].pos[0];
+				cir.pos[1] = position[i].pos[1];
+				cir.rad = INITIAL_RADIUS;
+				cir.setColor(hue[i].clr);
+				queue.push(cir);
+				fired++;
+			}
+	}
+	return fired;
+}
@@ -0,0 +1,89 @@
+/////////////////////////////////////////////////////////////////
+// Definition file: Predators.h                                //
+//                                                             //
+// This file declares the predators: autonomous emitters that  //
+// roam the world, each hunting the nearest cluster of ships   //
+// of its own color and firing a ripple of that color every    //
+// so many ticks once it is within striking range.  Predators  //
+// are entities of the world (see EntityWorld.h) with a        //
+// position, heading, hue and Hunter component.                //
+//                                                             //
+// Clusters are found through a ClusterGrid: cells of          //
+// CLUSTER_CELL across, each holding, per color, how many      //
+// ships are in it and the sum of their positions.  It is      //
+// rebuilt every tick from the ships' columns by the worker    //
+// pool, each task binning its own share of the ships into a   //
+// grid of its own before the grids are summed, and a          //
+// predator's query then searches outward from its own cell,   //
+// ring by ring, for the nearest centroid of a cell holding    //
+// CLUSTER_MIN_SHIPS or more.  Predators are stepped on the    //
+// worker pool too, queueing their ripples like mouse clicks.  //
+// On a torus the search wraps around the grid's edges, and a  //
+// cluster is reached the short way, across the seam if need   //
+// be.                                                         //
+/////////////////////////////////////////////////////////////////
+
+#ifndef PREDATORS_H
+
+#include "Flocking.h"
+#include "Simulation.h"
+#include "EntityWorld.h"
+#include "LockFreeStack.h"
+#include <vector>
+
+const float CLUSTER_CELL			= 0.1f;		// Side Of A Cluster Cell   //
+const int   CLUSTER_MIN_SHIPS		= 8;		// Ships Making A Cluster   //
+const int   CLUSTER_GRAIN			= 65536;	// Ships Binned Per Task    //
+const int   MAX_CLUSTER_SIDE		= 256;		// Most Cells Per Side      //
+const float PREDATOR_SPEED			= 0.004f;	// Distance Per Tick        //
+const float PREDATOR_TURN			= 0.15f;	// Share Turned Per Tick    //
+const int   PREDATOR_PERIOD[2]		= { 20, 60 };	// Ticks Between Ripples //
+const float PREDATOR_STRIKE_RANGE	= 0.15f;	// Reach Of Its Ripples     //
+const float PREDATOR_SIZE			= 0.03f;	// Drawn Half-Width         //
+const int   PREDATOR_GRAIN			= 256;		// Predators Per Task       //
+
+////////////////////////////////////////////////
+// DECLARATION SECTION FOR CLUSTER GRID CLASS //
+////////////////////////////////////////////////
+
+class ClusterGrid
+{
+	public:
+		// Class constructor
+		ClusterGrid();
+
+		// Member functions
+		void build(EntityWorld &world, const WorldBounds &bounds);
+		bool nearest(const float pos[], color clr, float target[]) const;
+		int getClusterCount() const;
+
+	protected:
+		// A cell's ships of one color. //
+		struct cell
+		{
+			int count;
+			float sum[2];
+		};
+
+		// Data members
+		int columns, rows;
+		float left, bottom, cellSize, perCell;
+		WorldBounds bounds;				// Those of the last build. //
+		std::vector<cell> cells;		// By (row * columns + column) * NBR_COLORS + color. //
+
+		// Member functions
+		int columnOf(float x) const;
+		int rowOf(float y) const;
+		int wrapIndex(int index, int nbrCells) const;
+};
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+void AddPredators(EntityWorld &world, int nbrPredators, const WorldBounds &bounds, unsigned int seed);
+int CountPredators(EntityWorld &world);
+int StepPredators(EntityWorld &world, const ClusterGrid &clusters, LockFreeStack<Ripple> &queue,
+				  const WorldBounds &bounds);
+
+#define PREDATORS_H
+#endif
@@ -0,0 +1,199 @@
+/********************************************************************/
+/* Filename: Recording.cpp                                          */
+/*                                                                  */
+/* Trajectory recording, checkpoints (and reading them back), and   */
+/* frame capture. Each writer returns false, having queued nothing, */
+/* when the I/O service is too far behind to take the whole record; */
+/* a recording then skips that tick rather than stall the tick.     */
+/********************************************************************/
+
+#include "Recording.h"
+#include <gl/freeglut.h>
+#include <climits>
+#include <vector>
+using namespace std;
+
+
+/* Function to pack the ships' state onto the end of "bytes". */
+template <class Bytes>
+static void AppendShips(Bytes &bytes, LinkedList<Ship> &shipList)
+{
+	shipList.visit([&bytes](Ship &shp)
+	{
+		ShipRecord record = { { shp.pos[0], shp.pos[1] }, { shp.delta[0], shp.delta[1] }, int(shp.clr), int(shp.idle) };
+		bytes.insert(bytes.end(), (const char *)&record, (const char *)&record + sizeof(record));
+	});
+}
+
+
+/* Function to queue one tick of the trajectory recording. */
+bool RecordTick(IoService &io, int stream, long tick, LinkedList<Ship> &shipList)
+{
+	static thread_local vector<char, TaggedAllocator<char, recorderMemory> > bytes;
+	TickRecord header = { tick, shipList.getSize(), 0 };
+
+	bytes.assign((const char *)&header, (const char *)&header + sizeof(header));
+	AppendShips(bytes, shipList);
+	return io.write(stream, &bytes[0], int(bytes.size()));
+}
+
+
+/* Function to pack a checkpoint of the whole world into */
+/* "bytes", replacing what they held.                    */
+void PackCheckpoint(CheckpointBytes &bytes, long tick, const WorldRecord &settings,
+					LinkedList<Ship> &shipList, LinkedList<Ripple> &circleList)
+{
+	TickRecord header = { tick, shipList.getSize(), circleList.getSize() };
+
+	bytes.assign((const char *)&CHECKPOINT_MAGIC, (const char *)&CHECKPOINT_MAGIC + sizeof(CHECKPOINT_MAGIC));
+	bytes.insert(bytes.end(), (const char *)&header, (const char *)&header + sizeof(header));
+	bytes.insert(bytes.end(), (const char *)&settings, (const char *)&settings + sizeof(settings));
+	AppendShips(bytes, shipList);
+	circleList.visit([&bytes](Ripple &cir)
+	{
+		RippleRecord record = { { cir.pos[0], cir.pos[1] }, cir.rad, int(cir.clr), int(cir.mask) };
+		bytes.insert(bytes.end(), (const char *)&record, (const char *)&record + sizeof(record));
+	});
+}
+
+
+/* Function to queue a packed checkpoint into a file of its */
+/* own, which is closed once it is written.                 */
+bool WriteCheckpointBytes(IoService &io, const char *path, const CheckpointBytes &bytes)
+{
+	int stream = io.openStream(path);
+	bool queued;
+
+	if (stream < 0)
+		return false;
+	queued = io.write(stream, &bytes[0], int(bytes.size()));
+	io.closeStream(stream);
+	return queued;
+}
+
+
+/* Function to queue a checkpoint of the whole world into a */
+/* file of its own, which is closed once it is written.     */
+bool WriteCheckpoint(IoService &io, const char *path, long tick, const WorldRecord &settings,
+					 LinkedList<Ship> &shipList, LinkedList<Ripple> &circleList)
+{
+	CheckpointBytes bytes;
+
+	PackCheckpoint(bytes, tick, settings, shipList, circleList);
+	return WriteCheckpointBytes(io, path, bytes);
+}
+
+
+/* Function to queue the current frame buffer. Bands of rows */
+/* are read straight into the registered buffers, so a frame */
+/* is never copied on the tick thread.                       */
+bool CaptureFrame(IoService &io, int stream, int width, int height)
+{
+	int rowBytes = 3 * width;
+	int bandRows = IO_BUFFER_SIZE / rowBytes;
+	int nbrBands = (height + bandRows - 1) / bandRows;
+	vector<char *> buffers(nbrBands);
+
+	if ( (nbrBands == 0) || !io.acquireBuffers(nbrBands, &buffers[0]) )
+		return false;
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	for (int b = 0; b < nbrBands; b++)
+	{
+		int rows = (height - b * bandRows < bandRows) ? height - b * bandRows : bandRows;
+		glReadPixels(0, b * bandRows, width, rows, GL_RGB, GL_UNSIGNED_BYTE, buffers[b]);
+		io.submit(stream, buffers[b], rows * rowBytes);
+	}
+	return true;
+}
+
+
+/* Function to tell whether a world record holds an extent. */
+bool ValidWorldRecord(const WorldRecord &record)
+{
+	return (record.width > 0.0f) && (record.height > 0.0f);
+}
+
+
+/* Function to tell whether a ship record holds a color */
+/* and an idle count a ship can keep.                   */
+bool ValidShipRecord(const ShipRecord &record)
+{
+	return (record.clr >= 0) && (record.clr < NBR_COLORS) && (record.idle >= 0) && (record.idle <= UCHAR_MAX);
+}
+
+
+/* Function to tell whether a ripple record holds a color */
+/* (or "none") and a mask of colors that exist.           */
+bool ValidRippleRecord(const RippleRecord &record)
+{
+	return (record.clr >= 0) && (record.clr <= int(none)) && ((record.mask & ~int(ALL_COLORS_MASK)) == 0);
+}
+
+
+/* Function to load a checkpoint, appending its ships and    */
+/* ripples to the lists in their original order and filling  */
+/* in the world's settings. False is returned, with nothing  */
+/* changed, if the file cannot be read, is not a checkpoint, */
+/* or holds a color or mask outside the ones the simulation  */
+/* knows, or no extent.                                      */
+bool ReadCheckpoint(const char *path, long &tick, WorldRecord &settings,
+					LinkedList<Ship> &shipList, LinkedList<Ripple> &circleList)
+{
+	FILE *file = fopen(path, "rb");
+	unsigned int magic = 0;
+	TickRecord header;
+	WorldRecord world;
+	vector<ShipRecord> ships;
+	vector<RippleRecord> ripples;
+	bool complete;
+
+	if (file == NULL)
+		return false;
+	complete = (fread(&magic, sizeof(magic), 1, file) == 1) && (magic == CHECKPOINT_MAGIC) &&
+			   (fread(&header, sizeof(header), 1, file) == 1) &&
+			   (fread(&world, sizeof(world), 1, file) == 1) && ValidWorldRecord(world) &&
+			   (header.nbrShips >= 0) && (header.nbrRipples >= 0);
+	if (complete)
+	{
+		ships.resize(header.nbrShips);
+		ripples.resize(header.nbrRipples);
+		complete = ( (header.nbrShips == 0) ||
+					 (fread(&ships[0], sizeof(ShipRecord), ships.size(), file) == ships.size()) ) &&
+				   ( (header.nbrRipples == 0) ||
+					 (fread(&ripples[0], sizeof(RippleRecord), ripples.size(), file) == ripples.size()) );
+	}
+	fclose(file);
+	for (int i = 0; complete && (i < int(ships.size())); i++)
+		complete = ValidShipRecord(ships[i]);
+	for (int j = 0; complete && (j < int(ripples.size())); j++)
+		complete = ValidRippleRecord(ripples[j]);
+	if (!complete)
+		return false;
+
+	tick = long(header.tick);
+	settings = world;
+	for (int i = 0; i < int(ships.size()); i++)
+	{
+		Ship shp;
+		shp.pos[0] = ships[i].pos[0];
+		shp.pos[1] = ships[i].pos[1];
+		shp.delta[0] = ships[i].delta[0];
+		shp.delta[1] = ships[i].delta[1];
+		shp.clr = color(ships[i].clr);
+		shp.idle = (unsigned char)ships[i].idle;
+		shipList.insert( shp );
+		++shipList;
+	}
+	for (int j = 0; j < int(ripples.size()); j++)
+	{
+		Ripple cir;
+		cir.pos[0] = ripples[j].pos[0];
+		cir.pos[1] = ripples[j].pos[1];
+		cir.rad = ripples[j].rad;
+		cir.clr = color(ripples[j].clr);
+		cir.mask = (unsigned char)ripples[j].mask;
+		circleList.insert( cir );
+		++circleList;
+	}
+	return true;
+}
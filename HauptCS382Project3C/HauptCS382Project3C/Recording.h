@@ -0,0 +1,80 @@
+/////////////////////////////////////////////////////////////////
+// Definition file: Recording.h                                //
+//                                                             //
+// This file declares the writers that run through the shared  //
+// IoService: the per-tick trajectory recording, one-shot      //
+// checkpoints of the whole world, and raw frame capture.  The //
+// records are written in the machine's own byte order.        //
+//                                                             //
+//   Trajectory file:  per tick, a TickRecord and then one     //
+//                     ShipRecord per ship, in list order.     //
+//   Checkpoint file:  CHECKPOINT_MAGIC, a TickRecord, a       //
+//                     WorldRecord (the bounds, whether they   //
+//                     wrap, and whether the ships were in     //
+//                     tiles), the ShipRecords, then the       //
+//                     RippleRecords.                          //
+//   Capture file:     per frame, width x height RGB pixels,   //
+//                     bottom row first.                       //
+/////////////////////////////////////////////////////////////////
+
+#ifndef RECORDING_H
+
+#include "Flocking.h"
+#include "LinkedList.h"
+#include "IoService.h"
+#include <vector>
+
+const unsigned int CHECKPOINT_MAGIC = 0x324b4c46;	// "FLK2" //
+
+struct TickRecord
+{
+	long long tick;
+	int nbrShips;
+	int nbrRipples;
+};
+
+struct WorldRecord
+{
+	float width;
+	float height;
+	int wrap;
+	int tiled;
+};
+
+struct ShipRecord
+{
+	float pos[2];
+	float delta[2];
+	int clr;
+	int idle;
+};
+
+struct RippleRecord
+{
+	float pos[2];
+	float rad;
+	int clr;
+	int mask;
+};
+
+// A checkpoint packed in memory, as it is laid out in its file. //
+typedef std::vector<char, TaggedAllocator<char, recorderMemory> > CheckpointBytes;
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+bool RecordTick(IoService &io, int stream, long tick, LinkedList<Ship> &shipList);
+void PackCheckpoint(CheckpointBytes &bytes, long tick, const WorldRecord &settings,
+					LinkedList<Ship> &shipList, LinkedList<Ripple> &circleList);
+bool WriteCheckpointBytes(IoService &io, const char *path, const CheckpointBytes &bytes);
+bool WriteCheckpoint(IoService &io, const char *path, long tick, const WorldRecord &settings,
+					 LinkedList<Ship> &shipList, LinkedList<Ripple> &circleList);
+bool CaptureFrame(IoService &io, int stream, int width, int height);
+bool ReadCheckpoint(const char *path, long &tick, WorldRecord &settings,
+					LinkedList<Ship> &shipList, LinkedList<Ripple> &circleList);
+bool ValidWorldRecord(const WorldRecord &record);
+bool ValidShipRecord(const ShipRecord &record);
+bool ValidRippleRecord(const RippleRecord &record);
+
+#define RECORDING_H
+#endif
@@ -0,0 +1,152 @@
+/////////////////////////////////////////////////////////////////
+// Class implementation file: RippleIndex.cpp                  //
+//                                                             //
+// Each level is a flat array of (cell key, ripple) entries    //
+// sorted by key, so that one row of cells in one color bucket //
+// is a single contiguous run found with one binary search.    //
+// The arrays are rebuilt every tick (all radii change every   //
+// tick) but keep their capacity, so a rebuild never allocates //
+// once the ripple count has settled.                          //
+/////////////////////////////////////////////////////////////////
+
+#include "RippleIndex.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+////////////////////////////////////////////////
+// Default constructor: Sets up an empty index. //
+////////////////////////////////////////////////
+RippleIndex::RippleIndex()
+{
+	for (int l = 0; l < RIPPLE_INDEX_LEVELS; l++)
+		for (int b = 0; b <= NBR_COLORS; b++)
+			counts[l][b] = 0;
+}
+
+////////////////////////////////////////////////////////
+// Function to file every ripple in "ripples" by its  //
+// level, color bucket and center cell.  The ripple's //
+// position in the array is what gather returns.      //
+////////////////////////////////////////////////////////
+void RippleIndex::build(const vector<Ripple> &ripples)
+{
+	int l, b;
+
+	for (l = 0; l < RIPPLE_INDEX_LEVELS; l++)
+	{
+		levels[l].clear();
+		for (b = 0; b <= NBR_COLORS; b++)
+			counts[l][b] = 0;
+	}
+
+	for (int i = 0; i < int(ripples.size()); i++)
+	{
+		const Ripple &cir = ripples[i];
+		entry e;
+		l = levelFor(cir.rad);
+		e.ripple = i;
+		for (b = 0; b <= NBR_COLORS; b++)
+			if ( (b == int(none)) ? (cir.mask == ALL_COLORS_MASK)
+								  : ((cir.mask != ALL_COLORS_MASK) && (cir.mask & (1 << b))) )
+			{
+				e.key = keyOf(b, cellOf(cir.pos[1], l), cellOf(cir.pos[0], l));
+				levels[l].push_back(e);
+				counts[l][b]++;
+			}
+	}
+
+	for (l = 0; l < RIPPLE_INDEX_LEVELS; l++)
+		sort(levels[l].begin(), levels[l].end(),
+			 [](const entry &x, const entry &y) { return x.key < y.key; });
+}
+
+///////////////////////////////////////////////////////////
+// Function to collect, in ascending ripple order, every //
+// ripple of color "clr" or "none" that could cover a    //
+// point within "slack" of "pos".                        //
+///////////////////////////////////////////////////////////
+void RippleIndex::gather(const float pos[], color clr, float slack, vector<int> &candidates)
+{
+	candidates.clear();
+	for (int l = 0; l < RIPPLE_INDEX_LEVELS; l++)
+	{
+		float reach = getCellSize(l) + slack;
+		if (counts[l][int(clr)] > 0)
+			gatherBucket(l, int(clr), pos, reach, candidates);
+		if ( (clr != none) && (counts[l][int(none)] > 0) )
+			gatherBucket(l, int(none), pos, reach, candidates);
+	}
+	sort(candidates.begin(), candidates.end());
+}
+
+///////////////////////////////////////////////////
+// Function to return the cell width of a level. //
+///////////////////////////////////////////////////
+float RippleIndex::getCellSize(int level)
+{
+	return ldexp(FINAL_RADIUS, -level);
+}
+
+//////////////////////////////////////////////////////////
+// Function to choose the finest level whose cells are  //
+// at least as wide as the radius "rad".                //
+//////////////////////////////////////////////////////////
+int RippleIndex::levelFor(float rad)
+{
+	int level = 0;
+
+	while ( (level + 1 < RIPPLE_INDEX_LEVELS) && (getCellSize(level + 1) >= rad) )
+		level++;
+	return level;
+}
+
+///////////////////////////////////////////////////////
+// Function to map a coordinate to its cell index on //
+// a level, clamped so that it always fits its key.  //
+///////////////////////////////////////////////////////
+int RippleIndex::cellOf(float coord, int level)
+{
+	float cell = floor(coord / getCellSize(level));
+
+	if (cell < float(1 - RIPPLE_INDEX_BIAS))
+		return 1 - RIPPLE_INDEX_BIAS;
+	if (cell > float(RIPPLE_INDEX_BIAS - 1))
+		return RIPPLE_INDEX_BIAS - 1;
+	return int(cell);
+}
+
+/////////////////////////////////////////////////////////
+// Function to pack a color bucket and a cell into one //
+// key, ordered by bucket, then row, then column.      //
+/////////////////////////////////////////////////////////
+unsigned long long RippleIndex::keyOf(int bucket, int row, int column)
+{
+	return ((unsigned long long)bucket << 42) |
+		   ((unsigned long long)(row + RIPPLE_INDEX_BIAS) << 21) |
+		   (unsigned long long)(column + RIPPLE_INDEX_BIAS);
+}
+
+////////////////////////////////////////////////////////////
+// Function to append the ripples of one bucket on one    //
+// level whose centers lie in any cell within "reach" of  //
+// "pos", scanning one contiguous run of keys per row.    //
+////////////////////////////////////////////////////////////
+void RippleIndex::gatherBucket(int level, int bucket, const float pos[], float reach,
+							   vector<int> &candidates)
+{
+	int firstColumn = cellOf(pos[0] - reach, level), lastColumn = cellOf(pos[0] + reach, level);
+	int firstRow = cellOf(pos[1] - reach, level), lastRow = cellOf(pos[1] + reach, level);
+	entryVector &cells = levels[level];
+	entry probe;
+
+	for (int row = firstRow; row <= lastRow; row++)
+	{
+		unsigned long long lastKey = keyOf(bucket, row, lastColumn);
+		probe.key = keyOf(bucket, row, firstColumn);
+		entryVector::iterator it = lower_bound(cells.begin(), cells.end(), probe,
+			[](const entry &x, const entry &y) { return x.key < y.key; });
+		for ( ; (it != cells.end()) && (it->key <= lastKey); ++it)
+			candidates.push_back(it->ripple);
+	}
+}
@@ -0,0 +1,62 @@
+/////////////////////////////////////////////////////////////////
+// Class definition file: RippleIndex.h                        //
+//                                                             //
+// This file defines the RippleIndex class, a multi-level grid //
+// over the live ripples.  Level 0 has cells as wide as the    //
+// largest ripple radius, and each finer level halves the cell //
+// size.  A ripple is filed at the finest level whose cells    //
+// are at least as wide as its radius, in the cell holding its //
+// center, under each color it targets (or only under "none" //
+// if it targets them all).  A ship can then only be covered   //
+// by ripples filed in the cells next to its own, on each      //
+// level, under its color or "none".                           //
+/////////////////////////////////////////////////////////////////
+
+#ifndef RIPPLE_INDEX_H
+
+#include "Flocking.h"
+#include <vector>
+
+const int   RIPPLE_INDEX_LEVELS	= 5;		// Grid Resolutions     //
+const int   RIPPLE_INDEX_BIAS	= 1 << 20;	// Keeps Cell Keys >= 0 //
+const float RIPPLE_INDEX_SLACK	= 0.05f;	// Drift Before Rescan  //
+
+////////////////////////////////////////////////
+// DECLARATION SECTION FOR RIPPLE INDEX CLASS //
+////////////////////////////////////////////////
+
+class RippleIndex
+{
+	public:
+		// Class constructor
+		RippleIndex();
+
+		// Member functions
+		void build(const std::vector<Ripple> &ripples);
+		void gather(const float pos[], color clr, float slack, std::vector<int> &candidates);
+		float getCellSize(int level);
+
+	protected:
+		// Data members
+
+		struct entry
+		{
+			unsigned long long key;		// Bucket, row, column //
+			int ripple;					// Index into ripples  //
+		};
+
+		typedef std::vector<entry, TaggedAllocator<entry, indexMemory> > entryVector;
+
+		entryVector levels[RIPPLE_INDEX_LEVELS];
+		int counts[RIPPLE_INDEX_LEVELS][NBR_COLORS + 1];
+
+		// Member functions
+		int levelFor(float rad);
+		int cellOf(float coord, int level);
+		unsigned long long keyOf(int bucket, int row, int column);
+		void gatherBucket(int level, int bucket, const float pos[], float reach,
+						  std::vector<int> &candidates);
+};
+
+#define RIPPLE_INDEX_H
+#endif
@@ -0,0 +1,383 @@
+/////////////////////////////////////////////////////////////////
+// Class implementation file: Scenario.cpp                     //
+//                                                             //
+// The timer wheel has one slot per tick modulo its size.  A   //
+// script waiting longer than a lap simply sits in its slot    //
+// until the lap in which it is due, so every wait, however    //
+// long, costs one push and one pop.  The built-in scenarios   //
+// are made of three kinds of scripts: emitters, which fire    //
+// ripples at a steady period (optionally drifting across the  //
+// world), a color cycler, which changes the color followed by //
+// emitters without one of their own, and a watcher, which     //
+// checks that the ships are conserved and that the ripples    //
+// stay within the bound their emitters imply.                 //
+/////////////////////////////////////////////////////////////////
+
+#include "Scenario.h"
+#include "Simulation.h"
+#include "BinaryLog.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+using namespace std;
+
+const int RAIN_EMITTERS		= 1000;		// Emitters In "rain"      //
+const int STORM_EMITTERS	= 5000;		// Emitters In "storm"     //
+const int SWEEP_EMITTERS	= 8;		// Emitters In "sweep"     //
+const int SWEEP_PERIOD		= 5;		// Ticks Between Shots     //
+const int CYCLE_PERIOD		= 50;		// Ticks Per Shared Color  //
+const int WATCH_PERIOD		= 10;		// Ticks Between Checks    //
+const float SWEEP_SPEED		= 0.01f;	// Emitter Drift Per Tick  //
+
+/////////////////////////////////////////////////////////
+// Constructor: Seeded, so that a scenario's random    //
+// choices repeat from run to run.                     //
+/////////////////////////////////////////////////////////
+ScenarioContext::ScenarioContext(LockFreeStack<Ripple> &queue, unsigned int seed) : rippleQueue(queue), rng(seed)
+{
+	tick = 0;
+	nbrShips = 0;
+	nbrRipples = 0;
+	tickMs = 0.0;
+	currColor = white;
+	spawned = 0;
+	failures = 0;
+}
+
+//////////////////////////////////////////////////////////
+// Functions to queue a new ripple, just as a mouse     //
+// click would, for the next tick to pick up.           //
+//////////////////////////////////////////////////////////
+void ScenarioContext::spawnRipple(float x, float y, color clr)
+{
+	spawnRipple(x, y, clr, ColorBit(clr));
+}
+
+void ScenarioContext::spawnRipple(float x, float y, color clr, unsigned char mask)
+{
+	Ripple cir;
+
+	cir.pos[0] = x;
+	cir.pos[1] = y;
+	cir.rad = INITIAL_RADIUS;
+	cir.clr = clr;
+	cir.mask = mask;
+	rippleQueue.push(cir);
+	spawned++;
+}
+
+//////////////////////////////////////////////////
+// Functions to change and read the scenario's  //
+// shared color.                                //
+//////////////////////////////////////////////////
+void ScenarioContext::setColor(color clr)
+{
+	currColor = clr;
+}
+
+color ScenarioContext::getColor()
+{
+	return currColor;
+}
+
+//////////////////////////////////////////////////////////
+// Function to check a condition on the statistics.     //
+// A failure is counted, logged, and (for the first     //
+// few) printed; the scenario carries on regardless.    //
+//////////////////////////////////////////////////////////
+bool ScenarioContext::expect(bool condition, const char *what)
+{
+	if (condition)
+		return true;
+
+	failures++;
+	LOG_EVENT("scenario: check failed at tick %d (%d ships, %d ripples)", int(tick), nbrShips, nbrRipples);
+	if (failures <= MAX_SCENARIO_REPORTS)
+		printf("tick %ld: expected %s (%d ships, %d ripples)\n", tick, what, nbrShips, nbrRipples);
+	return false;
+}
+
+///////////////////////////////////////////////////////
+// Function to draw a uniform value in [low, high).  //
+///////////////////////////////////////////////////////
+float ScenarioContext::random(float low, float high)
+{
+	return uniform_real_distribution<float>(low, high)(rng);
+}
+
+/////////////////////////////////////////////////////////
+// Functions to report the ripples spawned and the     //
+// checks failed so far.                               //
+/////////////////////////////////////////////////////////
+int ScenarioContext::getSpawned()
+{
+	return spawned;
+}
+
+int ScenarioContext::getFailures()
+{
+	return failures;
+}
+
+/////////////////////////////////////////////////
+// IMPLEMENTATION SECTION FOR SCENARIO RUNNER  //
+/////////////////////////////////////////////////
+
+////////////////////////////////////////////
+// Default constructor: No scripts yet.   //
+////////////////////////////////////////////
+ScenarioRunner::ScenarioRunner()
+{
+	nbrActive = 0;
+	nbrResumes = 0;
+	resumeNs = 0.0;
+	lastTick = -1;
+}
+
+//////////////////////////////////////////////////////
+// Destructor: Unfinished scripts are deleted too.  //
+//////////////////////////////////////////////////////
+ScenarioRunner::~ScenarioRunner()
+{
+	for (int s = 0; s < SCENARIO_WHEEL_SLOTS; s++)
+		for (int i = 0; i < int(wheel[s].size()); i++)
+			delete wheel[s][i];
+}
+
+//////////////////////////////////////////////////////////
+// Function to take ownership of a script and start it  //
+// "delay" ticks after the latest tick run.             //
+//////////////////////////////////////////////////////////
+void ScenarioRunner::add(ScenarioScript *script, int delay)
+{
+	nbrActive++;
+	schedule(script, lastTick + 1 + ((delay > 0) ? delay : 0));
+}
+
+//////////////////////////////////////////////////////////
+// Function to resume every script due at the context's //
+// tick.  A script returning SCRIPT_DONE is deleted; a  //
+// wait of zero means the next tick.                    //
+//////////////////////////////////////////////////////////
+void ScenarioRunner::tick(ScenarioContext &ctx)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	vector<ScenarioScript *> &slot = wheel[ctx.tick % SCENARIO_WHEEL_SLOTS];
+
+	lastTick = ctx.tick;
+	due.swap(slot);
+	for (int i = 0; i < int(due.size()); i++)
+	{
+		ScenarioScript *script = due[i];
+		int wait;
+
+		if (script->wakeTick > ctx.tick)		// Due in a later lap. //
+		{
+			slot.push_back(script);
+			continue;
+		}
+		wait = script->run(ctx);
+		nbrResumes++;
+		if (wait == SCRIPT_DONE)
+		{
+			delete script;
+			nbrActive--;
+		}
+		else
+			schedule(script, ctx.tick + ((wait > 0) ? wait : 1));
+	}
+	due.clear();
+	resumeNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+//////////////////////////////////////////////////////
+// Functions to report the scripts still running,   //
+// the resumptions so far, and their mean cost      //
+// (including whatever the scripts did meanwhile).  //
+//////////////////////////////////////////////////////
+int ScenarioRunner::getActiveCount()
+{
+	return nbrActive;
+}
+
+long ScenarioRunner::getResumes()
+{
+	return nbrResumes;
+}
+
+double ScenarioRunner::getResumeNs()
+{
+	return (nbrResumes > 0) ? resumeNs / nbrResumes : 0.0;
+}
+
+////////////////////////////////////////////////////
+// Function to file a script in its wake slot.    //
+////////////////////////////////////////////////////
+void ScenarioRunner::schedule(ScenarioScript *script, long wakeTick)
+{
+	script->wakeTick = wakeTick;
+	wheel[wakeTick % SCENARIO_WHEEL_SLOTS].push_back(script);
+}
+
+//////////////////////////////////////////////////////////
+// Script to fire "shots" ripples (or forever, if zero) //
+// every "period" ticks, drifting by (vx, vy) per tick  //
+// across the wrapped world.  An emitter whose color is //
+// none follows the scenario's shared color instead.    //
+//////////////////////////////////////////////////////////
+class EmitterScript : public ScenarioScript
+{
+	public:
+		EmitterScript(float x0, float y0, float vx, float vy, int p, color c, int n, const WorldBounds &b)
+		{
+			pos[0] = x0;
+			pos[1] = y0;
+			drift[0] = vx * p;
+			drift[1] = vy * p;
+			period = p;
+			clr = c;
+			shots = n;
+			bounds = b;
+		}
+
+		int run(ScenarioContext &ctx)
+		{
+			SCRIPT_BEGIN;
+			for (fired = 0; (shots == 0) || (fired < shots); fired++)
+			{
+				ctx.spawnRipple(pos[0], pos[1], (clr == none) ? ctx.getColor() : clr);
+				pos[0] += drift[0];
+				pos[1] += drift[1];
+				WrapPosition(pos, bounds);
+				SCRIPT_WAIT(period);
+			}
+			SCRIPT_END;
+		}
+
+	protected:
+		float pos[2];
+		float drift[2];
+		int period;
+		color clr;
+		int shots;
+		int fired;
+		WorldBounds bounds;
+};
+
+/////////////////////////////////////////////////////////
+// Script to step the shared color through every       //
+// visible color, one every "period" ticks, forever.   //
+/////////////////////////////////////////////////////////
+class ColorCycleScript : public ScenarioScript
+{
+	public:
+		ColorCycleScript(int p) : period(p), next(0) {}
+
+		int run(ScenarioContext &ctx)
+		{
+			SCRIPT_BEGIN;
+			for (;;)
+			{
+				ctx.setColor( color(next) );
+				next = (next + 1) % NBR_COLORS;
+				SCRIPT_WAIT(period);
+			}
+			SCRIPT_END;
+		}
+
+	protected:
+		int period;
+		int next;
+};
+
+//////////////////////////////////////////////////////////
+// Script to check, every "period" ticks, that no ship  //
+// was lost or gained since it started and that the     //
+// ripples never outnumber "maxRipples".                //
+//////////////////////////////////////////////////////////
+class WatchScript : public ScenarioScript
+{
+	public:
+		WatchScript(int p, int m) : period(p), maxRipples(m), nbrShips(0) {}
+
+		int run(ScenarioContext &ctx)
+		{
+			SCRIPT_BEGIN;
+			nbrShips = ctx.nbrShips;
+			for (;;)
+			{
+				SCRIPT_WAIT(period);
+				ctx.expect(ctx.nbrShips == nbrShips, "the ships to be conserved");
+				ctx.expect(ctx.nbrRipples <= maxRipples, "the ripples to stay within their emitters' bound");
+			}
+			SCRIPT_END;
+		}
+
+	protected:
+		int period;
+		int maxRipples;
+		int nbrShips;
+};
+
+/////////////////////////////////////////////////////////////
+// Function to bound the ripples alive at once from an    //
+// emitter firing every "period" ticks.                   //
+/////////////////////////////////////////////////////////////
+static int LiveRipples(int period)
+{
+	int lifetime = int(ceil((FINAL_RADIUS - INITIAL_RADIUS) / RADIUS_INCREMENT)) + 1;
+	return lifetime / period + 1;
+}
+
+/* Function to load a built-in scenario into the runner:    */
+/* "rain" (a thousand emitters of random colors, positions  */
+/* and periods), "storm" (five thousand slower ones, all    */
+/* following a cycling color), or "sweep" (a few emitters   */
+/* drifting across the world in rows).  Each comes with a   */
+/* watcher.  False is returned for an unknown name.         */
+bool BuildScenario(const char *name, ScenarioRunner &runner, float width, float height, unsigned int seed)
+{
+	WorldBounds bounds = { true, width, height };
+	mt19937 rng(seed);
+	uniform_real_distribution<float> x(-0.5f * width, 0.5f * width);
+	uniform_real_distribution<float> y(-0.5f * height, 0.5f * height);
+	int maxRipples = 0;
+
+	if (strcmp(name, "rain") == 0)
+	{
+		uniform_int_distribution<int> period(20, 200), clr(0, NBR_COLORS - 1);
+		for (int e = 0; e < RAIN_EMITTERS; e++)
+		{
+			int p = period(rng);
+			runner.add(new EmitterScript(x(rng), y(rng), 0.0f, 0.0f, p, color(clr(rng)), 0, bounds), p);
+			maxRipples += LiveRipples(p);
+		}
+	}
+	else if (strcmp(name, "storm") == 0)
+	{
+		uniform_int_distribution<int> period(100, 1000);
+		runner.add(new ColorCycleScript(CYCLE_PERIOD), 0);
+		for (int e = 0; e < STORM_EMITTERS; e++)
+		{
+			int p = period(rng);
+			runner.add(new EmitterScript(x(rng), y(rng), 0.0f, 0.0f, p, none, 0, bounds), p);
+			maxRipples += LiveRipples(p);
+		}
+	}
+	else if (strcmp(name, "sweep") == 0)
+	{
+		runner.add(new ColorCycleScript(CYCLE_PERIOD), 0);
+		for (int e = 0; e < SWEEP_EMITTERS; e++)
+		{
+			float row = height * ((e + 0.5f) / SWEEP_EMITTERS - 0.5f);
+			runner.add(new EmitterScript(-0.5f * width, row, SWEEP_SPEED, 0.0f, SWEEP_PERIOD, none, 0, bounds), e);
+			maxRipples += LiveRipples(SWEEP_PERIOD);
+		}
+	}
+	else
+		return false;
+
+	runner.add(new WatchScript(WATCH_PERIOD, maxRipples), 0);
+	return true;
+}
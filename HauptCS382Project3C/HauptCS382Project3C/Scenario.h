@@ -0,0 +1,137 @@
+/////////////////////////////////////////////////////////////////
+// Class definition file: Scenario.h                           //
+//                                                             //
+// This file defines scripted scenarios: reproducible          //
+// workloads of ripples, color changes and checks on the       //
+// simulation's statistics, driven by the tick loop instead of //
+// by hand.  A script is a resumable function in the style of  //
+// a protothread: its run member is re-entered where it last   //
+// waited, through a switch on the saved resume point, so a    //
+// suspended script costs one small object and no stack.      //
+// Anything a script needs across a wait must therefore be a   //
+// data member, not a local variable.                          //
+//                                                             //
+//     int run(ScenarioContext &ctx)                           //
+//     {                                                       //
+//         SCRIPT_BEGIN;                                       //
+//         for (shots = 0; shots < 10; shots++)                //
+//         {                                                   //
+//             ctx.spawnRipple(x, y, red);                     //
+//             SCRIPT_WAIT(25);      // Resume 25 ticks later. //
+//         }                                                   //
+//         SCRIPT_END;                                         //
+//     }                                                       //
+//                                                             //
+// The runner keeps sleeping scripts in a timer wheel, so      //
+// waking one is a constant-time step whatever the number of   //
+// scripts in flight.                                          //
+/////////////////////////////////////////////////////////////////
+
+#ifndef SCENARIO_H
+
+#include "Flocking.h"
+#include "LockFreeStack.h"
+#include <random>
+#include <vector>
+
+const int SCRIPT_DONE			= -1;		// Run's Result When Finished //
+const int SCENARIO_WHEEL_SLOTS	= 256;		// Timer Wheel Size           //
+const int MAX_SCENARIO_REPORTS	= 10;		// Failures Printed           //
+
+#define SCRIPT_BEGIN	switch (resumePoint) { case 0:
+#define SCRIPT_WAIT(n)	do { resumePoint = __LINE__; return (n); case __LINE__:; } while (0)
+#define SCRIPT_END		} resumePoint = SCRIPT_DONE; return SCRIPT_DONE
+
+//////////////////////////////////////////////////////////
+// What a script sees and may do when it is resumed.    //
+//////////////////////////////////////////////////////////
+class ScenarioContext
+{
+	public:
+		ScenarioContext(LockFreeStack<Ripple> &queue, unsigned int seed);
+
+		// Statistics as of the latest tick, filled in by its caller
+		long tick;
+		int nbrShips;
+		int nbrRipples;
+		double tickMs;
+
+		// Actions
+		void spawnRipple(float x, float y, color clr);
+		void spawnRipple(float x, float y, color clr, unsigned char mask);
+		void setColor(color clr);	// The scenario's shared color, //
+		color getColor();			// which emitters may follow.   //
+		bool expect(bool condition, const char *what);
+		float random(float low, float high);
+		int getSpawned();
+		int getFailures();
+
+	protected:
+		LockFreeStack<Ripple> &rippleQueue;
+		std::mt19937 rng;
+		color currColor;
+		int spawned;
+		int failures;
+};
+
+////////////////////////////////////////////////////
+// A script: derive from it and define run, which //
+// returns the ticks to wait or SCRIPT_DONE.      //
+////////////////////////////////////////////////////
+class ScenarioScript
+{
+	public:
+		ScenarioScript() : resumePoint(0), wakeTick(0) {}
+		virtual ~ScenarioScript() {}
+		virtual int run(ScenarioContext &ctx) = 0;
+
+	protected:
+		int resumePoint;
+
+	private:
+		friend class ScenarioRunner;
+		long wakeTick;
+};
+
+/////////////////////////////////////////////////
+// DECLARATION SECTION FOR SCENARIO RUNNER     //
+/////////////////////////////////////////////////
+
+class ScenarioRunner
+{
+	public:
+		// Class constructor and destructor
+		ScenarioRunner();
+		~ScenarioRunner();
+
+		// Member functions
+		void add(ScenarioScript *script, int delay);
+		void tick(ScenarioContext &ctx);
+		int getActiveCount();
+		long getResumes();
+		double getResumeNs();
+
+	protected:
+		// Data members
+		std::vector<ScenarioScript *> wheel[SCENARIO_WHEEL_SLOTS];
+		std::vector<ScenarioScript *> due;
+		int nbrActive;
+		long nbrResumes;
+		double resumeNs;
+		long lastTick;
+
+		// Member function
+		void schedule(ScenarioScript *script, long wakeTick);
+
+	private:
+		// Runners own their scripts, so they are never copied.
+		ScenarioRunner(const ScenarioRunner &runner);
+};
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+bool BuildScenario(const char *name, ScenarioRunner &runner, float width, float height, unsigned int seed);
+
+#define SCENARIO_H
+#endif
@@ -0,0 +1,236 @@
+/////////////////////////////////////////////////////////////////
+// Class implementation file: SessionHost.cpp                  //
+//                                                             //
+// A session's tick takes in what has been posted, admits its  //
+// quota from the front of the backlog, sheds the budget's     //
+// excess, and advances its world as the window advances its   //
+// own (less the predators and obstacles).  Tick times run     //
+// from the tick's due time to the end of all that.  The host  //
+// steps its sessions on the worker pool, not on threads of    //
+// their own, so that a host of many sessions starts no more   //
+// threads than the pool has.                                  //
+/////////////////////////////////////////////////////////////////
+
+#include "SessionHost.h"
+#include "Telemetry.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <mutex>
+#include <thread>
+using namespace std;
+
+///////////////////////////////////////////////
+// IMPLEMENTATION SECTION FOR SESSION CLASS  //
+///////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////
+// Constructor: An empty world of the given bounds,     //
+// stepped by "engine", holding at most "rippleBudget"  //
+// bytes of ripples (zero: no limit), and starting with //
+// the largest ripple quota.                            //
+//////////////////////////////////////////////////////////
+Session::Session(const SimulationEngine &engine, double objectiveMs, const WorldBounds &bounds,
+				 long long rippleBudget)
+	: schedule(WORLD_SYSTEMS, NBR_WORLD_SYSTEMS)
+{
+	this->engine = &engine;
+	this->bounds = bounds;
+	this->rippleBudget = rippleBudget;
+	this->objectiveMs = objectiveMs;
+	quota = SESSION_ADMIT_MAX;
+	withinObjective = admitted = shed = 0;
+}
+
+////////////////////////////////////////////////
+// Functions to reach the session's world and //
+// report its latency objective.              //
+////////////////////////////////////////////////
+EntityWorld &Session::getWorld()
+{
+	return world;
+}
+
+double Session::getObjectiveMs()
+{
+	return objectiveMs;
+}
+
+///////////////////////////////////////////////////////
+// Function to post a ripple for the session to take //
+// in on its next tick; any thread may call it.      //
+///////////////////////////////////////////////////////
+void Session::postRipple(const Ripple &cir)
+{
+	input.push(cir);
+}
+
+//////////////////////////////////////////////////////////
+// Function to advance the session by its tick due at   //
+// "due", returning the tick's latency: from its due    //
+// time, not from when it started, so that a tick kept  //
+// waiting for a thread counts the wait. The ripple     //
+// quota is adjusted by the time the tick's own work    //
+// took against the objective, so a session kept        //
+// waiting by others does not choke its own intake.     //
+//////////////////////////////////////////////////////////
+double Session::step(chrono::steady_clock::time_point due)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	LinkedList<Ripple> arrived;
+	int first = int(backlog.size()), n;
+	double workMs, ms;
+
+	// The list runs from the newest arrival, so they are put back in order. //
+	input.drainInto(arrived);
+	while (!arrived.isEmpty())
+	{
+		backlog.push_back(arrived.getHeadValue());
+		arrived.removeHead();
+	}
+	reverse(backlog.begin() + first, backlog.end());
+	while (int(backlog.size()) > SESSION_BACKLOG_MAX)
+	{
+		backlog.pop_front();
+		shed++;
+	}
+	for (n = 0; (n < quota) && !backlog.empty(); n++)
+	{
+		world.addRipple(backlog.front());
+		backlog.pop_front();
+	}
+	admitted += n;
+	shed += world.enforceRippleBudget(rippleBudget);
+
+	tickStages.begin();
+	AdvanceWorldTick(world, schedule, *engine, bounds);
+	workMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	ms = chrono::duration<double, milli>(chrono::steady_clock::now() - due).count();
+
+	tickMs.push_back(ms);
+	if (ms <= objectiveMs)
+		withinObjective++;
+	if (workMs <= objectiveMs)
+		quota = (quota + SESSION_ADMIT_STEP < SESSION_ADMIT_MAX) ? quota + SESSION_ADMIT_STEP : SESSION_ADMIT_MAX;
+	else
+		quota = (quota / 2 > SESSION_ADMIT_MIN) ? quota / 2 : SESSION_ADMIT_MIN;
+	return ms;
+}
+
+///////////////////////////////////////////////////////
+// Function to summarize the session's ticks so far. //
+///////////////////////////////////////////////////////
+SessionReport Session::report()
+{
+	SessionReport r = { long(tickMs.size()), 0.0, 0.0, 0.0, 0.0, withinObjective,
+						admitted, long(backlog.size()), shed };
+	vector<double> sorted(tickMs);
+
+	if (sorted.empty())
+		return r;
+	sort(sorted.begin(), sorted.end());
+	for (int t = 0; t < int(sorted.size()); t++)
+		r.meanMs += sorted[t];
+	r.meanMs /= sorted.size();
+	r.medianMs = sorted[sorted.size() / 2];
+	r.p99Ms = sorted[(sorted.size() * 99) / 100];
+	r.worstMs = sorted.back();
+	return r;
+}
+
+////////////////////////////////////////////////////
+// IMPLEMENTATION SECTION FOR SESSION HOST CLASS  //
+////////////////////////////////////////////////////
+
+//////////////////////////////////////////////
+// Constructor: No sessions, one tick every //
+// "periodMs" milliseconds.                 //
+//////////////////////////////////////////////
+SessionHost::SessionHost(double periodMs)
+{
+	this->periodMs = periodMs;
+}
+
+//////////////////////////////////////
+// Destructor: Frees every session. //
+//////////////////////////////////////
+SessionHost::~SessionHost()
+{
+	for (int s = 0; s < int(sessions.size()); s++)
+		delete sessions[s];
+}
+
+//////////////////////////////////////////////////////
+// Functions to add a session, count the sessions,  //
+// and reach one of them.                           //
+//////////////////////////////////////////////////////
+Session &SessionHost::addSession(const SimulationEngine &engine, double objectiveMs, const WorldBounds &bounds,
+								 long long rippleBudget)
+{
+	sessions.push_back(new Session(engine, objectiveMs, bounds, rippleBudget));
+	return *sessions.back();
+}
+
+int SessionHost::getSessionCount()
+{
+	return int(sessions.size());
+}
+
+Session &SessionHost::getSession(int index)
+{
+	return *sessions[index];
+}
+
+//////////////////////////////////////////////////////////
+// Function to step every session "nbrTicks" ticks, the //
+// kth due at "start" plus k periods.  Sessions are not //
+// ticked together: as many runners as can be used (one //
+// per session, at most one per pool thread) each take  //
+// whichever idle session's tick falls due first, wait  //
+// for its due time, step it, and come back for more,   //
+// so that a slow session holds up one runner, never    //
+// the others' ticks.  Ties go round the sessions in    //
+// turn.  A tick that runs past the next one's due time //
+// is followed at once, not skipped.                    //
+//////////////////////////////////////////////////////////
+void SessionHost::run(long nbrTicks, chrono::steady_clock::time_point start)
+{
+	chrono::duration<double, milli> period(periodMs);
+	int nbrSessions = int(sessions.size());
+	int nbrRunners = min(nbrSessions, SimulationPool().getWorkerCount() + 1);
+	vector<long> nextTick(nbrSessions, 0);		// Guarded by "lock". //
+	vector<bool> busy(nbrSessions, false);		// Guarded by "lock". //
+	int turn = 0;
+	mutex lock;
+
+	SimulationPool().parallelFor(nbrRunners, 1, [&](int begin, int end)
+	{
+		for (int runner = begin; runner < end; runner++)
+			for (;;)
+			{
+				chrono::steady_clock::time_point due;
+				int s = -1;
+				{
+					lock_guard<mutex> guard(lock);
+					for (int i = 0; i < nbrSessions; i++)
+					{
+						int c = (turn + i) % nbrSessions;
+						if ( !busy[c] && (nextTick[c] < nbrTicks) && ((s < 0) || (nextTick[c] < nextTick[s])) )
+							s = c;
+					}
+					// Every session left is another runner's. //
+					if (s < 0)
+						break;
+					busy[s] = true;
+					turn = (s + 1) % nbrSessions;
+					due = start + chrono::duration_cast<chrono::steady_clock::duration>(period * double(nextTick[s]));
+				}
+				this_thread::sleep_until(due);
+				sessions[s]->step(due);
+				{
+					lock_guard<mutex> guard(lock);
+					nextTick[s]++;
+					busy[s] = false;
+				}
+			}
+	});
+}
@@ -0,0 +1,126 @@
+/////////////////////////////////////////////////////////////////
+// Class definition file: SessionHost.h                        //
+//                                                             //
+// This file defines the session host, which runs several      //
+// independent simulations (the kiosks of one server, say) in  //
+// one process.  Each Session has its own entity world and     //
+// bounds, its own input queue, which any thread may post      //
+// ripples to, its own ripple budget, and its own latency      //
+// objective: the longest a tick may take from its due time.   //
+// The host ticks every session once a period, each on its own //
+// schedule: runners on the one worker pool take the session   //
+// whose tick falls due first, with no barrier between one     //
+// tick and the next, so a slow session delays no other's      //
+// ticks while threads remain; their own jobs share the pool   //
+// with one another a chunk at a time (see WorkerPool.h).      //
+//                                                             //
+// A session keeps its ticks within its objective by holding   //
+// its input back: ripples posted to it wait in a backlog and  //
+// at most a quota of them join the world each tick.  The      //
+// quota is halved after a tick whose own work overran the     //
+// objective and grows by SESSION_ADMIT_STEP after one within  //
+// it (time spent waiting for a thread does not count against  //
+// its intake, as the input is not its cause), so a session    //
+// flooded with ripples slows its own intake, not the other    //
+// sessions' displacement.  Ripples beyond SESSION_BACKLOG_MAX //
+// are shed, oldest first, as are the world's ripples beyond   //
+// the session's budget, which counts its own ripples alone.   //
+/////////////////////////////////////////////////////////////////
+
+#ifndef SESSION_HOST_H
+
+#include "Flocking.h"
+#include "Simulation.h"
+#include "EntityWorld.h"
+#include "LockFreeStack.h"
+#include <chrono>
+#include <deque>
+#include <vector>
+
+const int SESSION_ADMIT_MIN		= 1;		// Smallest Ripple Quota     //
+const int SESSION_ADMIT_MAX		= 64;		// Largest Ripple Quota      //
+const int SESSION_ADMIT_STEP	= 4;		// Quota Growth Per Good Tick //
+const int SESSION_BACKLOG_MAX	= 1024;		// Ripples Held Back, At Most //
+
+//////////////////////////////////////////////////////////
+// A session's record: its ticks, their mean, median,   //
+// 99th percentile and worst latencies (each from the   //
+// tick's due time), how many met the objective, and    //
+// the ripples admitted, still held back, and shed      //
+// (from the backlog or over budget).                   //
+//////////////////////////////////////////////////////////
+struct SessionReport
+{
+	long ticks;
+	double meanMs, medianMs, p99Ms, worstMs;
+	long withinObjective;
+	long admitted, heldBack, shed;
+};
+
+///////////////////////////////////////////
+// DECLARATION SECTION FOR SESSION CLASS //
+///////////////////////////////////////////
+
+class Session
+{
+	public:
+		// Class constructor
+		Session(const SimulationEngine &engine, double objectiveMs, const WorldBounds &bounds,
+				long long rippleBudget);
+
+		// Member functions
+		EntityWorld &getWorld();
+		double getObjectiveMs();
+		void postRipple(const Ripple &cir);
+		double step(std::chrono::steady_clock::time_point due);
+		SessionReport report();
+
+	protected:
+		// Data members
+		EntityWorld world;
+		SystemSchedule schedule;
+		LockFreeStack<Ripple> input;		// Posted, not yet taken in.  //
+		std::deque<Ripple> backlog;			// Taken in, oldest first.    //
+		const SimulationEngine *engine;
+		WorldBounds bounds;
+		long long rippleBudget;				// Bytes; zero for none.     //
+		double objectiveMs;
+		int quota;
+		long withinObjective, admitted, shed;
+		std::vector<double> tickMs;
+
+	private:
+		// Sessions own their worlds, so they are never copied.
+		Session(const Session &session);
+};
+
+////////////////////////////////////////////////
+// DECLARATION SECTION FOR SESSION HOST CLASS //
+////////////////////////////////////////////////
+
+class SessionHost
+{
+	public:
+		// Class constructor and destructor
+		SessionHost(double periodMs);
+		~SessionHost();
+
+		// Member functions
+		Session &addSession(const SimulationEngine &engine, double objectiveMs, const WorldBounds &bounds,
+							long long rippleBudget);
+		int getSessionCount();
+		Session &getSession(int index);
+		void run(long nbrTicks, std::chrono::steady_clock::time_point start);
+
+	protected:
+		// Data members
+		std::vector<Session *> sessions;
+		double periodMs;
+
+	private:
+		// Hosts own their sessions, so they are never copied.
+		SessionHost(const SessionHost &host);
+};
+
+#define SESSION_HOST_H
+#endif
@@ -0,0 +1,120 @@
+/********************************************************************/
+/* Filename: ShipRules.cpp                                          */
+/*                                                                  */
+/* The flocking rule's neighbor grid and the table of rule sets     */
+/* compiled in. The grid hashes cells FLOCK_RADIUS wide into a      */
+/* fixed FLOCK_GRID_SIDE square, so it needs no bounds; cells that  */
+/* share a bucket only add neighbors that fail the distance test.   */
+/********************************************************************/
+
+#include "ShipRules.h"
+using namespace std;
+
+const int FLOCK_BIAS = 1 << 20;		// Clamp On Cell Indices //
+
+////////////////////////////////////////////////////////
+// Rule sets, selectable by name like the engines in  //
+// ENGINES. Only "push" must match the reference.     //
+////////////////////////////////////////////////////////
+typedef RulePipeline<RipplePush> PushRules;
+typedef RulePipeline<RipplePush, Flocking> FlockRules;
+typedef RulePipeline<RipplePush, Wind, EdgeAvoidance, Damping> DriftRules;
+typedef RulePipeline<RipplePush, Flocking, Wind, EdgeAvoidance, Damping> FullRules;
+
+const SimulationEngine RULE_SETS[] = { { "push",	PrepareShipsWith<PushRules>,	DisplaceShipsWith<PushRules>,	true  },
+									   { "flock",	PrepareShipsWith<FlockRules>,	DisplaceShipsWith<FlockRules>,	false },
+									   { "drift",	PrepareShipsWith<DriftRules>,	DisplaceShipsWith<DriftRules>,	false },
+									   { "full",	PrepareShipsWith<FullRules>,	DisplaceShipsWith<FullRules>,	false } };
+const int NBR_RULE_SETS = sizeof(RULE_SETS) / sizeof(RULE_SETS[0]);
+
+
+/* Function to copy out every ship as the tick begins, and */
+/* to file each, by its starting position, in the bucket   */
+/* of its hashed cell.                                     */
+void Flocking::prepare(const RuleContext &ctx)
+{
+	int i, nbrBuckets = FLOCK_GRID_SIDE * FLOCK_GRID_SIDE;
+
+	starting.clear();
+	starting.reserve(ctx.nbrShips);
+	for (int b = 0; b < int(ctx.blocks->size()); b++)
+		for (int row = 0; row < (*ctx.blocks)[b]->getSize(); row++)
+			starting.push_back( (*ctx.blocks)[b]->getShip(row) );
+
+	cellStart.assign(nbrBuckets + 1, 0);
+	for (i = 0; i < ctx.nbrShips; i++)
+		cellStart[bucketOf(cellOf(starting[i].pos[0]), cellOf(starting[i].pos[1])) + 1]++;
+	for (i = 1; i <= nbrBuckets; i++)
+		cellStart[i] += cellStart[i - 1];
+
+	// Each bucket's cursor ends at the next bucket's start; shift back. //
+	members.resize(ctx.nbrShips);
+	for (i = 0; i < ctx.nbrShips; i++)
+		members[ cellStart[bucketOf(cellOf(starting[i].pos[0]), cellOf(starting[i].pos[1]))]++ ] = i;
+	for (i = nbrBuckets; i > 0; i--)
+		cellStart[i] = cellStart[i - 1];
+	cellStart[0] = 0;
+}
+
+
+/* Function to turn a ship toward its neighbors' mean heading */
+/* and push it away from those crowding it, judging both by   */
+/* where every ship was when the tick began.                  */
+void Flocking::apply(Ship &shp, const Ship &before, int index, const RuleContext &/* ctx */) const
+{
+	int column = cellOf(before.pos[0]), row = cellOf(before.pos[1]);
+	float heading[2] = { 0.0f, 0.0f }, spread[2] = { 0.0f, 0.0f };
+	int count = 0;
+
+	for (int r = row - 1; r <= row + 1; r++)
+		for (int c = column - 1; c <= column + 1; c++)
+		{
+			int bucket = bucketOf(c, r);
+			for (int m = cellStart[bucket]; m < cellStart[bucket + 1]; m++)
+			{
+				const Ship &other = starting[members[m]];
+				float ox = before.pos[0] - other.pos[0], oy = before.pos[1] - other.pos[1];
+				float distance = ox * ox + oy * oy;
+
+				if ( (members[m] == index) || (other.clr != before.clr) || (distance >= FLOCK_RADIUS * FLOCK_RADIUS) )
+					continue;
+				heading[0] += other.delta[0];
+				heading[1] += other.delta[1];
+				count++;
+				if (distance < FLOCK_SEPARATION * FLOCK_SEPARATION)
+				{
+					spread[0] += ox;
+					spread[1] += oy;
+				}
+			}
+		}
+
+	if (count == 0)
+		return;
+	for (int i = 0; i <= 1; i++)
+	{
+		shp.delta[i] += FLOCK_ALIGNMENT * (heading[i] / count - before.delta[i]);
+		shp.pos[i] += FLOCK_SPREAD * spread[i];
+	}
+}
+
+
+/* Function to map a coordinate to its (unhashed) cell, */
+/* clamped so that far-off ships cannot overflow.       */
+int Flocking::cellOf(float coord)
+{
+	float cell = floor(coord / FLOCK_RADIUS);
+
+	if (cell < float(-FLOCK_BIAS))
+		return -FLOCK_BIAS;
+	if (cell > float(FLOCK_BIAS))
+		return FLOCK_BIAS;
+	return int(cell);
+}
+
+
+/* Function to hash a cell into the fixed grid of buckets. */
+int Flocking::bucketOf(int column, int row)
+{
+	return (row & (FLOCK_GRID_SIDE - 1)) * FLOCK_GRID_SIDE + (column & (FLOCK_GRID_SIDE - 1));
+}
@@ -0,0 +1,249 @@
+/////////////////////////////////////////////////////////////////
+// Definition file: ShipRules.h                                //
+//                                                             //
+// This file defines composable ship behaviors.  A rule is a   //
+// class with a prepare member, run once per tick, and an      //
+// apply member, run once per ship; a RulePipeline of several  //
+// rules applies them in order to each ship in a single pass,  //
+// with every call resolved (and normally inlined) at compile  //
+// time, so that no virtual call or rule test is left in the  //
+// loop over ships.  Each rule sees the ship as it is so far   //
+// this tick and as it was when the tick began; rules that     //
+// look at other ships only look at the tick's starting state, //
+// copied out in prepare, so the ships may be updated in       //
+// parallel.                                                   //
+//                                                             //
+// PrepareShipsWith<Pipeline> and DisplaceShipsWith<Pipeline>  //
+// turn a pipeline into an engine and RULE_SETS names the      //
+// combinations compiled in, so that they can be chosen at run //
+// time like any other engine.  The "push" set is the          //
+// reference's rule alone and must stay identical to it.       //
+/////////////////////////////////////////////////////////////////
+
+#ifndef SHIP_RULES_H
+
+#include "Flocking.h"
+#include "Simulation.h"
+#include "EntityWorld.h"
+#include <cmath>
+#include <vector>
+
+const float FLOCK_RADIUS		= 0.08f;	// Neighbors' Reach        //
+const float FLOCK_ALIGNMENT		= 0.1f;		// Pull Toward Heading     //
+const float FLOCK_SEPARATION	= 0.02f;	// Crowding Distance       //
+const float FLOCK_SPREAD		= 0.05f;	// Push Apart When Crowded //
+const int   FLOCK_GRID_SIDE		= 64;		// Hashed Cells Per Side   //
+const float WIND_VELOCITY[2]	= { 0.0005f, 0.0002f };	// Drift Per Tick //
+const float WIND_STEER			= 2.0f;		// Heading Turned By Wind  //
+const float EDGE_MARGIN			= 0.05f;	// Edge's Reach Inward     //
+const float EDGE_PUSH			= 0.2f;		// Push Per Unit Intrusion //
+const float DAMPING				= 0.8f;		// Share Of Motion Kept    //
+
+//////////////////////////////////////////////////////////
+// What every rule may look at: the tick's ripples, the //
+// ship archetypes (in prepare, before any ship moves), //
+// how many ships there are, and the world's bounds.    //
+//////////////////////////////////////////////////////////
+struct RuleContext
+{
+	const Ripple *ripples;
+	int nbrRipples;
+	const std::vector<Archetype *> *blocks;
+	int nbrShips;
+	WorldBounds bounds;
+};
+
+//////////////////////////////////////////////////////////
+// Base of the rules: a rule that needs nothing set up  //
+// per tick inherits this prepare.                      //
+//////////////////////////////////////////////////////////
+class ShipRule
+{
+	public:
+		void prepare(const RuleContext &/* ctx */) {}
+};
+
+///////////////////////////////////////////////////////
+// The reference's rule: every ripple of the ship's  //
+// color that covers it pushes it outward, in order. //
+///////////////////////////////////////////////////////
+class RipplePush : public ShipRule
+{
+	public:
+		void apply(Ship &shp, const Ship &/* before */, int /* index */, const RuleContext &ctx) const
+		{
+			for (int j = 0; j < ctx.nbrRipples; j++)
+			{
+				const Ripple &cir = ctx.ripples[j];
+				if ( cir.mask & ColorBit(shp.clr) )
+					if ( pow(cir.pos[0] - shp.pos[0], 2) + pow(cir.pos[1] - shp.pos[1], 2) < pow(cir.rad, 2) )
+					{
+						float intensity = 0.05f * (FINAL_RADIUS - cir.rad) / (FINAL_RADIUS - INITIAL_RADIUS);
+						shp.delta[0] += intensity * (shp.pos[0] - cir.pos[0]);
+						shp.delta[1] += intensity * (shp.pos[1] - cir.pos[1]);
+						shp.pos[0] += intensity * (shp.pos[0] - cir.pos[0]);
+						shp.pos[1] += intensity * (shp.pos[1] - cir.pos[1]);
+					}
+			}
+		}
+};
+
+//////////////////////////////////////////////////////////
+// Flocking: a ship turns toward the mean heading of    //
+// the ships of its color within FLOCK_RADIUS, and      //
+// edges away from any closer than FLOCK_SEPARATION.    //
+// Neighbors are found through a hashed grid of the     //
+// ships' starting positions, rebuilt every tick.       //
+//////////////////////////////////////////////////////////
+class Flocking : public ShipRule
+{
+	public:
+		void prepare(const RuleContext &ctx);
+		void apply(Ship &shp, const Ship &before, int index, const RuleContext &ctx) const;
+
+	protected:
+		std::vector<Ship> starting;		// Per ship index.  //
+		std::vector<int> cellStart;		// Per hashed cell. //
+		std::vector<int> members;		// Ship indices.    //
+
+		static int cellOf(float coord);
+		static int bucketOf(int column, int row);
+};
+
+//////////////////////////////////////////////////////////
+// Edge avoidance: on a bounded world, a ship within    //
+// EDGE_MARGIN of an edge is pushed back in, and its    //
+// heading turned inward, in proportion to how far in   //
+// the margin it is.  A torus has no edges to avoid.    //
+//////////////////////////////////////////////////////////
+class EdgeAvoidance : public ShipRule
+{
+	public:
+		void apply(Ship &shp, const Ship &/* before */, int /* index */, const RuleContext &ctx) const
+		{
+			if (ctx.bounds.wrap)
+				return;
+			for (int i = 0; i <= 1; i++)
+			{
+				float half = 0.5f * ((i == 0) ? ctx.bounds.width : ctx.bounds.height);
+				float low = shp.pos[i] - (EDGE_MARGIN - half), high = shp.pos[i] - (half - EDGE_MARGIN);
+				float intrusion = (low < 0.0f) ? low : ((high > 0.0f) ? high : 0.0f);
+				shp.pos[i] -= EDGE_PUSH * intrusion;
+				shp.delta[i] -= EDGE_PUSH * intrusion;
+			}
+		}
+};
+
+//////////////////////////////////////////////////////
+// Wind: every ship drifts by WIND_VELOCITY a tick, //
+// its heading turned somewhat downwind.            //
+//////////////////////////////////////////////////////
+class Wind : public ShipRule
+{
+	public:
+		void apply(Ship &shp, const Ship &/* before */, int /* index */, const RuleContext &/* ctx */) const
+		{
+			for (int i = 0; i <= 1; i++)
+			{
+				shp.pos[i] += WIND_VELOCITY[i];
+				shp.delta[i] += WIND_STEER * WIND_VELOCITY[i];
+			}
+		}
+};
+
+//////////////////////////////////////////////////////
+// Damping: only DAMPING of the tick's motion so    //
+// far is kept, so it belongs after the rules that  //
+// move the ships.                                  //
+//////////////////////////////////////////////////////
+class Damping : public ShipRule
+{
+	public:
+		void apply(Ship &shp, const Ship &before, int /* index */, const RuleContext &/* ctx */) const
+		{
+			for (int i = 0; i <= 1; i++)
+				shp.pos[i] = before.pos[i] + DAMPING * (shp.pos[i] - before.pos[i]);
+		}
+};
+
+//////////////////////////////////////////////////////////
+// A pipeline of rules, applied in the order listed.    //
+// Each level holds one rule and the pipeline of the    //
+// rest, so the recursion unrolls at compile time.      //
+//////////////////////////////////////////////////////////
+template <class... Rules> class RulePipeline;
+
+template <> class RulePipeline<>
+{
+	public:
+		void prepare(const RuleContext &/* ctx */) {}
+		void apply(Ship &/* shp */, const Ship &/* before */, int /* index */, const RuleContext &/* ctx */) const {}
+};
+
+template <class First, class... Rest> class RulePipeline<First, Rest...>
+{
+	public:
+		void prepare(const RuleContext &ctx)
+		{
+			first.prepare(ctx);
+			rest.prepare(ctx);
+		}
+
+		void apply(Ship &shp, const Ship &before, int index, const RuleContext &ctx) const
+		{
+			first.apply(shp, before, index, ctx);
+			rest.apply(shp, before, index, ctx);
+		}
+
+	protected:
+		First first;
+		RulePipeline<Rest...> rest;
+};
+
+// A pipeline, and what its rules see, kept by the engine from tick to tick. //
+template <class Pipeline>
+class PipelineScratch : public EngineScratch
+{
+	public:
+		Pipeline pipeline;
+		RuleContext ctx;
+};
+
+/* Engine function run once a tick: sets up what the rules */
+/* see and lets each rule prepare.                         */
+template <class Pipeline>
+void PrepareShipsWith(EntityWorld &/* world */, TickContext &tick)
+{
+	PipelineScratch<Pipeline> &scratch = tick.scratchAs< PipelineScratch<Pipeline> >();
+
+	scratch.ctx.ripples = tick.ripples.empty() ? NULL : &tick.ripples[0];
+	scratch.ctx.nbrRipples = int(tick.ripples.size());
+	scratch.ctx.blocks = &tick.blocks;
+	scratch.ctx.nbrShips = tick.nbrShips;
+	scratch.ctx.bounds = tick.bounds;
+	scratch.pipeline.prepare(scratch.ctx);
+}
+
+/* Engine that runs a pipeline over a range of ships, */
+/* normalizing each ship's trajectory afterwards as   */
+/* the reference does.                                */
+template <class Pipeline>
+void DisplaceShipsWith(Archetype &ships, int begin, int end, TickContext &tick)
+{
+	const PipelineScratch<Pipeline> &scratch = tick.scratchAs< PipelineScratch<Pipeline> >();
+	int firstShip = tick.firstShipOf(ships);
+
+	for (int i = begin; i < end; i++)
+	{
+		Ship shp = ships.getShip(i), before = shp;
+		scratch.pipeline.apply(shp, before, firstShip + i, scratch.ctx);
+		Normalize(shp.delta);
+		ships.setShip(i, shp);
+	}
+}
+
+extern const SimulationEngine RULE_SETS[];
+extern const int NBR_RULE_SETS;
+
+#define SHIP_RULES_H
+#endif
@@ -0,0 +1,526 @@
+/********************************************************************/
+/* Filename: Simulation.cpp                                         */
+/*                                                                  */
+/* The simulation core: ripple expansion, the reference ship        */
+/* displacement and its alternative engines. None of these touch    */
+/* OpenGL or the window's world, so the same code can drive the     */
+/* window, a headless run, or two worlds stepped in lockstep.       */
+/********************************************************************/
+
+#include "Simulation.h"
+#include "EntityWorld.h"
+#include "WorkerPool.h"
+#include "RippleIndex.h"
+#include "StencilGrid.h"
+#include "ShipRules.h"
+#include "TiledWorld.h"
+#include "BinaryLog.h"
+#include <cstring>			// Header File For String Operations       //
+#include <vector>
+using namespace std;
+
+WorldBounds worldBounds = { false, 2.0f, 2.0f };	// The window-sized plane. //
+
+/////////////////////////////////////////////////////////
+// Displacement engines, selectable by name. The first //
+// entry is the reference all others are checked by.   //
+/////////////////////////////////////////////////////////
+const SimulationEngine ENGINES[] = { { "reference",	NULL,				DisplaceShips,		true  },
+									 { "float",		NULL,				DisplaceShipsFloat,	false },
+									 { "threaded",	NULL,				DisplaceShipsThreaded,	true  },
+									 { "indexed",	PrepareIndexed,		DisplaceShipsIndexed,	true  },
+									 { "branchless",	NULL,				DisplaceShipsBranchless,	true  },
+									 { "multirate",	PrepareMultirate,	DisplaceShipsMultirate,	true  },
+									 { "stencil",	PrepareStencil,		DisplaceShipsStencil,	true  },
+									 { "tiled",		PrepareTiled,		DisplaceShipsTiled,		false } };
+const int NBR_ENGINES = sizeof(ENGINES) / sizeof(ENGINES[0]);
+
+
+/* Function to look up a displacement engine by its name,  */
+/* among the engines and then the rule sets, returning     */
+/* NULL if no engine of that name exists.                  */
+const SimulationEngine *FindEngine(const char *name)
+{
+	for (int i = 0; i < NBR_ENGINES; i++)
+		if (strcmp(ENGINES[i].name, name) == 0)
+			return &ENGINES[i];
+	for (int i = 0; i < NBR_RULE_SETS; i++)
+		if (strcmp(RULE_SETS[i].name, name) == 0)
+			return &RULE_SETS[i];
+	return NULL;
+}
+
+
+/* List adapter, for the lockstep and fuzz harnesses: files */
+/* the ships and ripples into a world of their own, steps   */
+/* it as the window's world is stepped (see                 */
+/* AdvanceWorldTick), so the ripples expand and expire the  */
+/* same way, and reads both back in order.                  */
+void AdvanceTick(LinkedList<Ship> &shipList, LinkedList<Ripple> &circleList, const SimulationEngine &engine)
+{
+	EntityWorld staged;
+	SystemSchedule schedule(WORLD_SYSTEMS, NBR_WORLD_SYSTEMS);
+
+	while (!shipList.isEmpty())
+	{
+		staged.addShip(shipList.getHeadValue(), 0);
+		shipList.removeHead();
+	}
+	staged.importRipples(circleList);
+	AdvanceWorldTick(staged, schedule, engine, worldBounds);
+	staged.exportShips(shipList);
+	staged.exportRipples(circleList);
+}
+
+
+/* Function to cycle through a range of ships and determine  */
+/* whether any ripple is encapsulating a ship's center. If   */
+/* so, the ship's position is modified to reflect the        */
+/* displacement caused by the emanating ripple.              */
+void DisplaceShips(Archetype &ships, int begin, int end, TickContext &tick)
+{
+	Position *position = ships.column<Position>();
+	Heading *heading = ships.column<Heading>();
+	Hue *hue = ships.column<Hue>();
+	const vector<Ripple> &ripples = tick.ripples;
+	int i, j;
+	float intensity;
+
+	for (i = begin; i < end; i++)
+	{
+		float *pos = position[i].pos, *delta = heading[i].delta;
+		for (j = 0; j < int(ripples.size()); j++)
+		{
+			const Ripple &cir = ripples[j];
+
+			// If the flocker's color is among those the ripple targets //
+			// (an invisible ripple targets them all), displace it.     //
+			if ( cir.mask & ColorBit(hue[i].clr) )
+				if ( pow(cir.pos[0] - pos[0], 2) + pow(cir.pos[1] - pos[1], 2) < pow(cir.rad, 2) )
+				{
+					// The flocker's current position is altered by a vector //
+					// in the direction of the ripple's emanation, scaled    //
+					// to be inversely proportional to the ripple's current  //
+					// size, to represent the ripple's dissipation.          //
+					intensity = 0.05f * (FINAL_RADIUS - cir.rad) / (FINAL_RADIUS - INITIAL_RADIUS);
+					delta[0] += intensity * (pos[0] - cir.pos[0]);
+					delta[1] += intensity * (pos[1] - cir.pos[1]);
+					pos[0] += intensity * (pos[0] - cir.pos[0]);
+					pos[1] += intensity * (pos[1] - cir.pos[1]);
+				}
+		}
+		Normalize(delta);
+	}
+}
+
+
+/* Variant of DisplaceShips that keeps the containment test in  */
+/* single precision (the reference squares through the double   */
+/* overloads of pow). Ships lying exactly on a ripple's edge    */
+/* may therefore be judged differently, so this engine is only  */
+/* expected to agree with the reference within a tolerance.     */
+void DisplaceShipsFloat(Archetype &ships, int begin, int end, TickContext &tick)
+{
+	Position *position = ships.column<Position>();
+	Heading *heading = ships.column<Heading>();
+	Hue *hue = ships.column<Hue>();
+	const vector<Ripple> &ripples = tick.ripples;
+	int i, j;
+	float intensity, dx, dy;
+
+	for (i = begin; i < end; i++)
+	{
+		float *pos = position[i].pos, *delta = heading[i].delta;
+		for (j = 0; j < int(ripples.size()); j++)
+		{
+			const Ripple &cir = ripples[j];
+			if ( cir.mask & ColorBit(hue[i].clr) )
+			{
+				dx = pos[0] - cir.pos[0];
+				dy = pos[1] - cir.pos[1];
+				if (dx * dx + dy * dy < cir.rad * cir.rad)
+				{
+					intensity = 0.05f * (FINAL_RADIUS - cir.rad) / (FINAL_RADIUS - INITIAL_RADIUS);
+					delta[0] += intensity * dx;
+					delta[1] += intensity * dy;
+					pos[0] += intensity * dx;
+					pos[1] += intensity * dy;
+				}
+			}
+		}
+		Normalize(delta);
+	}
+}
+
+
+/* Variant of DisplaceShips that takes each ship out of its */
+/* row whole and hands it to DisplaceShip, as the threaded  */
+/* engine did when the reference still ran on one thread;   */
+/* every engine now runs on the worker pool, a chunk of a   */
+/* ship archetype at a time. Each ship meets the ripples in */
+/* the same order and with the same arithmetic as in the    */
+/* reference, so the results are identical.                 */
+void DisplaceShipsThreaded(Archetype &ships, int begin, int end, TickContext &tick)
+{
+	const Ripple *first = tick.ripples.empty() ? NULL : &tick.ripples[0];
+
+	for (int i = begin; i < end; i++)
+	{
+		Ship shp = ships.getShip(i);
+		DisplaceShip(shp, first, int(tick.ripples.size()));
+		ships.setShip(i, shp);
+	}
+}
+
+
+// The indexed engine's grid over the tick's ripples. //
+class IndexedScratch : public EngineScratch
+{
+	public:
+		RippleIndex index;
+};
+
+/* Function to build the indexed engine's grid over the */
+/* tick's ripples, for every chunk of ships to search.  */
+void PrepareIndexed(EntityWorld &/* world */, TickContext &tick)
+{
+	tick.scratchAs<IndexedScratch>().index.build(tick.ripples);
+}
+
+
+/* Variant of DisplaceShips in which each ship only meets the  */
+/* ripples a multi-level grid over the ripples says could      */
+/* cover it: those of its own color or "none", centered near   */
+/* enough for their radius. Candidates are applied in list     */
+/* order, and the search reaches RIPPLE_INDEX_SLACK past the   */
+/* ship; should a ship be pushed further than that, it is      */
+/* redone against every ripple, so the results stay exact.     */
+void DisplaceShipsIndexed(Archetype &ships, int begin, int end, TickContext &tick)
+{
+	RippleIndex &index = tick.scratchAs<IndexedScratch>().index;
+	const vector<Ripple> &ripples = tick.ripples;
+	const Ripple *first = ripples.empty() ? NULL : &ripples[0];
+	vector<int> candidates;
+
+	for (int k = begin; k < end; k++)
+	{
+		Ship shp = ships.getShip(k);
+		Ship original = shp;
+		index.gather(shp.pos, shp.clr, RIPPLE_INDEX_SLACK, candidates);
+		for (int c = 0; c < int(candidates.size()); c++)
+		{
+			const Ripple &cir = ripples[candidates[c]];
+			if ( pow(cir.pos[0] - shp.pos[0], 2) + pow(cir.pos[1] - shp.pos[1], 2) < pow(cir.rad, 2) )
+			{
+				float intensity = 0.05f * (FINAL_RADIUS - cir.rad) / (FINAL_RADIUS - INITIAL_RADIUS);
+				shp.delta[0] += intensity * (shp.pos[0] - cir.pos[0]);
+				shp.delta[1] += intensity * (shp.pos[1] - cir.pos[1]);
+				shp.pos[0] += intensity * (shp.pos[0] - cir.pos[0]);
+				shp.pos[1] += intensity * (shp.pos[1] - cir.pos[1]);
+				if ( (fabs(shp.pos[0] - original.pos[0]) > RIPPLE_INDEX_SLACK) ||
+					 (fabs(shp.pos[1] - original.pos[1]) > RIPPLE_INDEX_SLACK) )
+					break;
+			}
+		}
+		if ( (fabs(shp.pos[0] - original.pos[0]) > RIPPLE_INDEX_SLACK) ||
+			 (fabs(shp.pos[1] - original.pos[1]) > RIPPLE_INDEX_SLACK) )
+		{
+			shp = original;
+			DisplaceShip(shp, first, int(ripples.size()));
+		}
+		else
+			Normalize(shp.delta);
+		ships.setShip(k, shp);
+	}
+}
+
+
+/* Variant of DisplaceShips that copies the ships' columns, a   */
+/* block of at most ENTITY_GRAIN at a time, into separate       */
+/* coordinate arrays and runs the ripples in the outer loop.    */
+/* The color filter is an AND of the ripple's color mask with   */
+/* the ship's one-hot color bit, and a ripple that misses adds  */
+/* a zero push rather than being branched around, so the inner  */
+/* loop over ships has no data-dependent branch and can be      */
+/* vectorized by the compiler, one ship per lane. Each ship     */
+/* still meets the ripples in list order, with the reference's  */
+/* double-precision test, so the results are identical.         */
+void DisplaceShipsBranchless(Archetype &ships, int begin, int end, TickContext &tick)
+{
+	Position *position = ships.column<Position>();
+	Heading *heading = ships.column<Heading>();
+	Hue *hue = ships.column<Hue>();
+	const vector<Ripple> &ripples = tick.ripples;
+	float x[ENTITY_GRAIN], y[ENTITY_GRAIN], u[ENTITY_GRAIN], v[ENTITY_GRAIN];
+	unsigned char bit[ENTITY_GRAIN];
+
+	for (int block = begin; block < end; block += ENTITY_GRAIN)
+	{
+		int n = (end - block < ENTITY_GRAIN) ? end - block : ENTITY_GRAIN;
+		int k;
+
+		for (k = 0; k < n; k++)
+		{
+			x[k] = position[block + k].pos[0];
+			y[k] = position[block + k].pos[1];
+			u[k] = heading[block + k].delta[0];
+			v[k] = heading[block + k].delta[1];
+			bit[k] = ColorBit(hue[block + k].clr);
+		}
+		for (int j = 0; j < int(ripples.size()); j++)
+		{
+			const float cx = ripples[j].pos[0], cy = ripples[j].pos[1];
+			const double reach = pow(ripples[j].rad, 2);
+			const float intensity = 0.05f * (FINAL_RADIUS - ripples[j].rad) / (FINAL_RADIUS - INITIAL_RADIUS);
+			const unsigned char mask = ripples[j].mask;
+			for (k = 0; k < n; k++)
+			{
+				float ox = x[k] - cx, oy = y[k] - cy;
+				bool hit = ((bit[k] & mask) != 0) & (double(ox) * ox + double(oy) * oy < reach);
+				float push = hit ? intensity : 0.0f;
+				u[k] += push * ox;
+				v[k] += push * oy;
+				x[k] += push * ox;
+				y[k] += push * oy;
+			}
+		}
+		for (k = 0; k < n; k++)
+		{
+			position[block + k].pos[0] = x[k];
+			position[block + k].pos[1] = y[k];
+			heading[block + k].delta[0] = u[k];
+			heading[block + k].delta[1] = v[k];
+			Normalize(heading[block + k].delta);
+		}
+	}
+}
+
+
+// The ripples born since the last tick, for the multirate engine. //
+class MultirateScratch : public EngineScratch
+{
+	public:
+		vector<Ripple> newborn;
+};
+
+/* Function to pick out the tick's newborn ripples (and  */
+/* their ghosts), which may cut a ship's interval short. */
+void PrepareMultirate(EntityWorld &/* world */, TickContext &tick)
+{
+	vector<Ripple> &newborn = tick.scratchAs<MultirateScratch>().newborn;
+
+	newborn.clear();
+	for (int j = 0; j < int(tick.ripples.size()); j++)
+		if (tick.ripples[j].rad <= INITIAL_RADIUS + RADIUS_INCREMENT)
+			newborn.push_back(tick.ripples[j]);
+}
+
+
+/* Variant of DisplaceShips that only tests a ship against the */
+/* ripples on its own schedule. After each test, the ship is   */
+/* given the longest power-of-two interval (up to              */
+/* MAX_SHIP_INTERVAL) during which no ripple aimed at it can   */
+/* grow to reach it, and skips the tests until that runs out.  */
+/* A ripple born since the last tick can cut any interval      */
+/* short, down to this very tick. Between tests a ship only    */
+/* has its trajectory normalized, exactly as the reference     */
+/* does for an untouched ship (ships do not drift on their     */
+/* own, so their positions need no extrapolation), which keeps */
+/* the results identical. Ships must start with idle at zero.  */
+void DisplaceShipsMultirate(Archetype &ships, int begin, int end, TickContext &tick)
+{
+	const vector<Ripple> &ripples = tick.ripples;
+	const vector<Ripple> &newborn = tick.scratchAs<MultirateScratch>().newborn;
+	const Ripple *first = ripples.empty() ? NULL : &ripples[0];
+	int tested = 0;
+
+	for (int k = begin; k < end; k++)
+	{
+		Ship shp = ships.getShip(k);
+		int j, safe;
+
+		// A new ripple may reach the ship before its next test is due; //
+		// the ticks it leaves free now include the current one.        //
+		for (j = 0; (j < int(newborn.size())) && (shp.idle > 0); j++)
+			if (newborn[j].mask & ColorBit(shp.clr))
+			{
+				safe = SafeTicks(shp, newborn[j]) + 1;
+				if (safe < int(shp.idle))
+					shp.idle = (unsigned char)((safe > 0) ? safe : 0);
+			}
+
+		if (shp.idle > 0)
+		{
+			shp.idle--;
+			Normalize(shp.delta);
+			ships.setShip(k, shp);
+			continue;
+		}
+
+		DisplaceShip(shp, first, int(ripples.size()));
+		tested++;
+		safe = MAX_SHIP_INTERVAL - 1;
+		for (j = 0; j < int(ripples.size()); j++)
+			if ( (ripples[j].mask & ColorBit(shp.clr)) && (SafeTicks(shp, ripples[j]) < safe) )
+				safe = SafeTicks(shp, ripples[j]);
+
+		int interval = 1;
+		while (interval * 2 <= safe + 1)
+			interval *= 2;
+		shp.idle = (unsigned char)(interval - 1);
+		ships.setShip(k, shp);
+	}
+	LOG_EVENT("multirate ships %d-%d: %d tested", begin, end, tested);
+}
+
+
+// The stencil engine's grid over the tick's ships. //
+class StencilScratch : public EngineScratch
+{
+	public:
+		StencilGrid grid;
+		bool built;
+};
+
+/* Function to file every ship of the world in the stencil */
+/* grid and walk each ripple's stencil over it, the        */
+/* workers splitting the grid's rows and each applying     */
+/* every ripple in list order to its own rows. The chunks  */
+/* of ships then only read their results back.             */
+void PrepareStencil(EntityWorld &/* world */, TickContext &tick)
+{
+	StencilScratch &scratch = tick.scratchAs<StencilScratch>();
+	StencilGrid &grid = scratch.grid;
+	const vector<Ripple> &ripples = tick.ripples;
+
+	scratch.built = grid.build(tick.blocks);
+	if (!scratch.built)
+		return;
+	SimulationPool().parallelFor(grid.getRows(), STENCIL_ROW_GRAIN, [&grid, &ripples](int begin, int end)
+	{
+		for (int j = 0; j < int(ripples.size()); j++)
+			grid.applyRipple(ripples[j], begin, end);
+	});
+	LOG_EVENT("stencil: %d rows, %d ships strayed", grid.getRows(), grid.getStrayedCount());
+}
+
+
+/* Variant of DisplaceShips that reads each ship back from the  */
+/* stencil grid (see StencilGrid.h), where every ripple's       */
+/* precomputed stencil pushed the ships in the cells it covers  */
+/* entirely without a distance test. Ships pushed past the      */
+/* stencils' slack are redone against every ripple, so the      */
+/* results are identical; should the ships spread too far for   */
+/* the grid, every ship is displaced as in the reference.       */
+void DisplaceShipsStencil(Archetype &ships, int begin, int end, TickContext &tick)
+{
+	StencilScratch &scratch = tick.scratchAs<StencilScratch>();
+
+	if (scratch.built)
+		scratch.grid.extract(ships, begin, end, tick.firstShipOf(ships), tick.ripples);
+	else
+		DisplaceShipsThreaded(ships, begin, end, tick);
+}
+
+
+/* Function to return how many ticks after this one the ripple */
+/* is sure not to cover the ship, however many ticks it has    */
+/* left to grow; SAFE_TICK_MARGIN ticks are held back for the  */
+/* rounding in the ripple's accumulated radius.                */
+int SafeTicks(const Ship &shp, const Ripple &cir)
+{
+	double gap = sqrt( pow(cir.pos[0] - shp.pos[0], 2) + pow(cir.pos[1] - shp.pos[1], 2) ) - cir.rad;
+
+	if (gap >= FINAL_RADIUS - cir.rad + RADIUS_INCREMENT)
+		return MAX_SHIP_INTERVAL;
+	return int(floor(gap / RADIUS_INCREMENT)) - SAFE_TICK_MARGIN;
+}
+
+
+/* Function to apply every ripple in an array to one ship, */
+/* exactly as the reference DisplaceShips does.            */
+void DisplaceShip(Ship &shp, const Ripple ripples[], int nbrRipples)
+{
+	float intensity;
+
+	for (int j = 0; j < nbrRipples; j++)
+	{
+		const Ripple &cir = ripples[j];
+		if ( cir.mask & ColorBit(shp.clr) )
+			if ( pow(cir.pos[0] - shp.pos[0], 2) + pow(cir.pos[1] - shp.pos[1], 2) < pow(cir.rad, 2) )
+			{
+				intensity = 0.05f * (FINAL_RADIUS - cir.rad) / (FINAL_RADIUS - INITIAL_RADIUS);
+				shp.delta[0] += intensity * (shp.pos[0] - cir.pos[0]);
+				shp.delta[1] += intensity * (shp.pos[1] - cir.pos[1]);
+				shp.pos[0] += intensity * (shp.pos[0] - cir.pos[0]);
+				shp.pos[1] += intensity * (shp.pos[1] - cir.pos[1]);
+			}
+	}
+	Normalize(shp.delta);
+}
+
+
+/* Normalize the parameterized vector. */
+void Normalize(float vector[])
+{
+	float size = sqrt( pow(vector[0], 2) + pow(vector[1], 2) );
+	if (size > 0.0f)
+		for (int i = 0; i <= 1; i++)
+			vector[i] *= (VECTOR_SIZE / size);
+}
+
+
+/* Function to fill "ghosts" with the copies of a ripple that */
+/* will reach across the edges of a wrapping world, shifted   */
+/* by the world's width and/or height, returning how many     */
+/* there are. Ghosts are judged by the final radius, so that  */
+/* they are born with their ripple rather than appearing in   */
+/* mid-expansion (which the multirate engine relies on).      */
+int GhostRipples(const Ripple &cir, const WorldBounds &bounds, Ripple ghosts[])
+{
+	float shiftX = 0.0f, shiftY = 0.0f;
+	int nbrGhosts = 0;
+
+	if (cir.pos[0] - FINAL_RADIUS < -0.5f * bounds.width)
+		shiftX = bounds.width;
+	else if (cir.pos[0] + FINAL_RADIUS >= 0.5f * bounds.width)
+		shiftX = -bounds.width;
+	if (cir.pos[1] - FINAL_RADIUS < -0.5f * bounds.height)
+		shiftY = bounds.height;
+	else if (cir.pos[1] + FINAL_RADIUS >= 0.5f * bounds.height)
+		shiftY = -bounds.height;
+
+	if (shiftX != 0.0f)
+	{
+		ghosts[nbrGhosts] = cir;
+		ghosts[nbrGhosts++].pos[0] += shiftX;
+	}
+	if (shiftY != 0.0f)
+	{
+		ghosts[nbrGhosts] = cir;
+		ghosts[nbrGhosts++].pos[1] += shiftY;
+	}
+	if ( (shiftX != 0.0f) && (shiftY != 0.0f) )
+	{
+		ghosts[nbrGhosts] = cir;
+		ghosts[nbrGhosts].pos[0] += shiftX;
+		ghosts[nbrGhosts++].pos[1] += shiftY;
+	}
+	return nbrGhosts;
+}
+
+
+/* Function to wrap one position into the world. A tick's */
+/* push is far smaller than the world, so one width (or   */
+/* height) either way always suffices.                    */
+void WrapPosition(float pos[], const WorldBounds &bounds)
+{
+	if (pos[0] >= 0.5f * bounds.width)
+		pos[0] -= bounds.width;
+	else if (pos[0] < -0.5f * bounds.width)
+		pos[0] += bounds.width;
+	if (pos[1] >= 0.5f * bounds.height)
+		pos[1] -= bounds.height;
+	else if (pos[1] < -0.5f * bounds.height)
+		pos[1] += bounds.height;
+}
@@ -0,0 +1,93 @@
+/////////////////////////////////////////////////////////////////
+// Definition file: Simulation.h                               //
+//                                                             //
+// This file declares the simulation core: the functions that  //
+// expand the ripples and displace the ships once per tick,    //
+// and the table of interchangeable displacement engines.      //
+// An engine works on the ships' columns where they lie: it is //
+// run as a system over the ship archetypes of an entity world //
+// (see EntityWorld.h), a range of rows at a time, after an    //
+// optional prepare step that sees the whole world once per    //
+// tick.  Every engine leaves each ship in its own row, so     //
+// that the states of two engines can be compared ship by      //
+// ship.  Engines that are not bit-for-bit identical to the    //
+// reference are marked as needing a tolerance.  The list      //
+// functions below stage lists of ships into a world of their  //
+// own, for the lockstep and fuzz harnesses.                   //
+//                                                             //
+// The world may also be a torus: positions wrap at the edges  //
+// of a centered rectangle, and a ripple near an edge acts     //
+// across the seam through ghost copies of itself, shifted by  //
+// the world's width or height.  The engines never see the     //
+// seam; they simply receive the ghosts as further ripples.    //
+/////////////////////////////////////////////////////////////////
+
+#ifndef SIMULATION_H
+
+#include "Flocking.h"
+#include "LinkedList.h"
+
+class Archetype;
+class EntityWorld;
+class TickContext;
+
+typedef void (*PrepareFunction)(EntityWorld &world, TickContext &tick);
+typedef void (*DisplaceFunction)(Archetype &ships, int begin, int end, TickContext &tick);
+
+//////////////////////////////////////////////////////////
+// Entry in the engine table: a name for the command    //
+// line, the function run once a tick before the ships  //
+// are displaced (NULL if none), the function that      //
+// displaces a range of ships, and whether it must      //
+// match the reference exactly or only within tolerance. //
+//////////////////////////////////////////////////////////
+struct SimulationEngine
+{
+	const char *name;
+	PrepareFunction prepare;
+	DisplaceFunction displace;
+	bool exact;
+};
+
+//////////////////////////////////////////////////////////
+// The world's extent, centered on the origin, and      //
+// whether ships and ripples wrap around its edges.     //
+//////////////////////////////////////////////////////////
+struct WorldBounds
+{
+	bool wrap;
+	float width;
+	float height;
+};
+
+extern WorldBounds worldBounds;
+extern const SimulationEngine ENGINES[];
+extern const int NBR_ENGINES;
+
+const int MAX_SHIP_INTERVAL = 64;	// Slowest Update Rate  //
+const int SAFE_TICK_MARGIN = 2;		// Rounding Allowance   //
+const int MAX_GHOST_RIPPLES = 3;	// Images Near A Corner //
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+const SimulationEngine *FindEngine(const char *name);
+void AdvanceTick(LinkedList<Ship> &shipList, LinkedList<Ripple> &circleList, const SimulationEngine &engine);
+void DisplaceShips(Archetype &ships, int begin, int end, TickContext &tick);
+void DisplaceShipsFloat(Archetype &ships, int begin, int end, TickContext &tick);
+void DisplaceShipsThreaded(Archetype &ships, int begin, int end, TickContext &tick);
+void PrepareIndexed(EntityWorld &world, TickContext &tick);
+void DisplaceShipsIndexed(Archetype &ships, int begin, int end, TickContext &tick);
+void DisplaceShipsBranchless(Archetype &ships, int begin, int end, TickContext &tick);
+void PrepareMultirate(EntityWorld &world, TickContext &tick);
+void DisplaceShipsMultirate(Archetype &ships, int begin, int end, TickContext &tick);
+void PrepareStencil(EntityWorld &world, TickContext &tick);
+void DisplaceShipsStencil(Archetype &ships, int begin, int end, TickContext &tick);
+void DisplaceShip(Ship &shp, const Ripple ripples[], int nbrRipples);
+int SafeTicks(const Ship &shp, const Ripple &cir);
+void Normalize(float vector[]);
+int GhostRipples(const Ripple &cir, const WorldBounds &bounds, Ripple ghosts[]);
+void WrapPosition(float pos[], const WorldBounds &bounds);
+
+#define SIMULATION_H
+#endif
@@ -0,0 +1,155 @@
+/********************************************************************/
+/* Filename: StateHash.cpp                                          */
+/*                                                                  */
+/* Order-independent hashing of ship state, and a harness that      */
+/* steps two copies of one world with two different engines,        */
+/* comparing their hashes after every tick. Hashes are only a       */
+/* cheap first check: when they differ, the ships are compared      */
+/* one by one, so a value that merely rounds to a different         */
+/* multiple of the tolerance is not reported as a divergence.       */
+/********************************************************************/
+
+#include "StateHash.h"
+#include <cstring>			// Header File For Memory Copying          //
+using namespace std;
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+unsigned long long MixBits(unsigned long long value);
+unsigned long long FieldBits(float value, float tolerance);
+
+
+/* Function to hash the ships of a list into one value. Each ship */
+/* is hashed on its own and the results are added, so the total  */
+/* is the same whatever order the ships are held in.             */
+unsigned long long HashShipState(LinkedList<Ship> &shipList, float tolerance)
+{
+	unsigned long long total = 0;
+
+	shipList.visit([&total, tolerance](Ship &shp)
+	{
+		unsigned long long h = MixBits(FieldBits(shp.pos[0], tolerance));
+		h = MixBits(h ^ FieldBits(shp.pos[1], tolerance));
+		h = MixBits(h ^ FieldBits(shp.delta[0], tolerance));
+		h = MixBits(h ^ FieldBits(shp.delta[1], tolerance));
+		h = MixBits(h ^ (unsigned long long)shp.clr);
+		total += h;
+	});
+	return total;
+}
+
+
+/* Function to decide whether two ships agree: same color, */
+/* and every coordinate within the tolerance (or bitwise   */
+/* identical when the tolerance is zero).                  */
+bool ShipsMatch(const Ship &a, const Ship &b, float tolerance)
+{
+	if (a.clr != b.clr)
+		return false;
+	if (tolerance == 0.0f)
+		return (a.pos[0] == b.pos[0]) && (a.pos[1] == b.pos[1]) &&
+			   (a.delta[0] == b.delta[0]) && (a.delta[1] == b.delta[1]);
+	return (fabs(a.pos[0] - b.pos[0]) <= tolerance) && (fabs(a.pos[1] - b.pos[1]) <= tolerance) &&
+		   (fabs(a.delta[0] - b.delta[0]) <= tolerance) && (fabs(a.delta[1] - b.delta[1]) <= tolerance);
+}
+
+
+/* Function to walk two ship lists side by side, returning the */
+/* index of the first pair that does not match (copying both   */
+/* ships out), -1 if the lists differ in length, or the list   */
+/* length if every pair matches. Both heads end where they     */
+/* started.                                                    */
+int FirstMismatchedShip(LinkedList<Ship> &listA, LinkedList<Ship> &listB, float tolerance,
+						Ship &shipA, Ship &shipB)
+{
+	int i, mismatch = -1;
+
+	if (listA.getSize() != listB.getSize())
+		return -1;
+	for (i = 0; i < listA.getSize(); i++)
+	{
+		if ( (mismatch < 0) && !ShipsMatch(listA.getHeadValue(), listB.getHeadValue(), tolerance) )
+		{
+			mismatch = i;
+			shipA = listA.getHeadValue();
+			shipB = listB.getHeadValue();
+		}
+		++listA;
+		++listB;
+	}
+	return (mismatch < 0) ? listA.getSize() : mismatch;
+}
+
+
+/* Function to run two engines in lockstep from the same      */
+/* starting ships and ripples, inserting the scheduled ripple */
+/* events into both worlds before each tick. It stops at the  */
+/* first tick on which the worlds disagree.                   */
+DivergenceReport RunLockstep(const SimulationEngine &engineA, const SimulationEngine &engineB,
+							 LinkedList<Ship> &shipList, LinkedList<Ripple> &circleList,
+							 const vector<RippleEvent> &events, long nbrTicks, float tolerance)
+{
+	LinkedList<Ship> shipsA(shipList), shipsB(shipList);
+	LinkedList<Ripple> circlesA(circleList), circlesB(circleList);
+	DivergenceReport report;
+	int nextEvent = 0;
+	long tick;
+
+	report.diverged = false;
+	report.tick = nbrTicks;
+	report.ship = 0;
+	for (tick = 1; tick <= nbrTicks; tick++)
+	{
+		while ( (nextEvent < int(events.size())) && (events[nextEvent].tick <= tick) )
+		{
+			circlesA.insert( events[nextEvent].ripple );
+			circlesB.insert( events[nextEvent].ripple );
+			nextEvent++;
+		}
+		AdvanceTick(shipsA, circlesA, engineA);
+		AdvanceTick(shipsB, circlesB, engineB);
+
+		if (HashShipState(shipsA, tolerance) != HashShipState(shipsB, tolerance))
+		{
+			int ship = FirstMismatchedShip(shipsA, shipsB, tolerance, report.expected, report.actual);
+			if (ship != shipsA.getSize())
+			{
+				report.diverged = true;
+				report.tick = tick;
+				report.ship = ship;
+				return report;
+			}
+		}
+	}
+	return report;
+}
+
+
+/* The 64-bit finalizer of SplitMix64, used to spread */
+/* the bits of each field over the whole hash.        */
+unsigned long long MixBits(unsigned long long value)
+{
+	value ^= value >> 30;
+	value *= 0xbf58476d1ce4e5b9ULL;
+	value ^= value >> 27;
+	value *= 0x94d049bb133111ebULL;
+	value ^= value >> 31;
+	return value;
+}
+
+
+/* Function to reduce a field to the bits that are hashed:  */
+/* its exact bit pattern, or with a tolerance, the nearest  */
+/* whole multiple of the tolerance.                         */
+unsigned long long FieldBits(float value, float tolerance)
+{
+	unsigned int bits;
+
+	if (tolerance > 0.0f)
+		return (unsigned long long)(long long)floor(value / tolerance + 0.5f);
+	if (value == 0.0f)
+		value = 0.0f;		// Fold -0 into +0. //
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
@@ -0,0 +1,55 @@
+/////////////////////////////////////////////////////////////////
+// Definition file: StateHash.h                                //
+//                                                             //
+// This file declares the per-tick ship state hash and the     //
+// lockstep harness built on it.  The hash is a sum of mixed   //
+// per-ship hashes, so it does not depend on the order the     //
+// ships are visited in.  With a non-zero tolerance, every     //
+// field is first rounded to a multiple of the tolerance, so   //
+// engines with slightly different float paths still agree.    //
+/////////////////////////////////////////////////////////////////
+
+#ifndef STATE_HASH_H
+
+#include "Simulation.h"
+#include <vector>
+
+const float LOCKSTEP_TOLERANCE = 1.0e-4f;	// Inexact Engine Slack //
+
+//////////////////////////////////////////////////////
+// A ripple to be inserted just before a given tick. //
+//////////////////////////////////////////////////////
+struct RippleEvent
+{
+	long tick;
+	Ripple ripple;
+};
+
+//////////////////////////////////////////////////////////
+// Outcome of a lockstep run: the first tick at which   //
+// the engines disagree, and the first ship (counted    //
+// from the list head) that differs, or -1 if the ship  //
+// counts themselves differ.                            //
+//////////////////////////////////////////////////////////
+struct DivergenceReport
+{
+	bool diverged;
+	long tick;
+	int ship;
+	Ship expected;
+	Ship actual;
+};
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+unsigned long long HashShipState(LinkedList<Ship> &shipList, float tolerance);
+bool ShipsMatch(const Ship &a, const Ship &b, float tolerance);
+int FirstMismatchedShip(LinkedList<Ship> &listA, LinkedList<Ship> &listB, float tolerance,
+						Ship &shipA, Ship &shipB);
+DivergenceReport RunLockstep(const SimulationEngine &engineA, const SimulationEngine &engineB,
+							 LinkedList<Ship> &shipList, LinkedList<Ripple> &circleList,
+							 const std::vector<RippleEvent> &events, long nbrTicks, float tolerance);
+
+#define STATE_HASH_H
+#endif
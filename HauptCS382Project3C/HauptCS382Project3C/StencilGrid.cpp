@@ -0,0 +1,333 @@
+/////////////////////////////////////////////////////////////////
+// Class implementation file: StencilGrid.cpp                  //
+//                                                             //
+// A stencil for age a serves every radius from a to a + 1     //
+// increments, so that the rounding in a ripple's accumulated  //
+// radius never puts it outside its stencil.  A cell is        //
+// reachable if its nearest point to the center cell is within //
+// the larger radius plus the slack, and covered entirely if   //
+// its farthest point is within the smaller radius less the    //
+// slack.  The workers split the grid's rows between them and  //
+// apply every ripple to their own rows, in list order, so     //
+// each ship still meets the ripples in the reference's order. //
+/////////////////////////////////////////////////////////////////
+
+#include "StencilGrid.h"
+#include "Simulation.h"
+#include "EntityWorld.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+const int STENCIL_BUCKETS		= NBR_COLORS + 1;	// Ship Colors And "none" //
+const int STENCIL_BIAS			= 1 << 20;			// Clamp On Cell Indices  //
+
+/////////////////////////////////////////////////
+// Default constructor: Sets up an empty grid. //
+/////////////////////////////////////////////////
+StencilGrid::StencilGrid()
+{
+	originColumn = originRow = 0;
+	nbrColumns = nbrRows = 0;
+}
+
+//////////////////////////////////////////////////////////
+// Function to file the ships of every block, numbered  //
+// in order across the blocks, by color and cell, over  //
+// the cells their positions span.  False is returned,  //
+// and the grid left unusable, if they span more than   //
+// STENCIL_MAX_SIDE cells either way.                   //
+//////////////////////////////////////////////////////////
+bool StencilGrid::build(const vector<Archetype *> &blocks)
+{
+	int b, i, nbrShips = 0;
+	int lastColumn = 0, lastRow = 0;
+
+	nbrColumns = nbrRows = 0;
+	for (b = 0; b < int(blocks.size()); b++)
+	{
+		Position *position = blocks[b]->column<Position>();
+		for (i = 0; i < blocks[b]->getSize(); i++, nbrShips++)
+		{
+			int column = cellOf(position[i].pos[0]), row = cellOf(position[i].pos[1]);
+			originColumn = (nbrShips == 0) ? column : min(originColumn, column);
+			lastColumn = (nbrShips == 0) ? column : max(lastColumn, column);
+			originRow = (nbrShips == 0) ? row : min(originRow, row);
+			lastRow = (nbrShips == 0) ? row : max(lastRow, row);
+		}
+	}
+	if (nbrShips == 0)
+		return true;
+	if ( (lastColumn - originColumn >= STENCIL_MAX_SIDE) || (lastRow - originRow >= STENCIL_MAX_SIDE) )
+		return false;
+	nbrColumns = lastColumn - originColumn + 1;
+	nbrRows = lastRow - originRow + 1;
+
+	// Count the ships per key, then turn the counts into run starts. //
+	runStart.assign(STENCIL_BUCKETS * nbrRows * nbrColumns + 1, 0);
+	for (b = 0; b < int(blocks.size()); b++)
+	{
+		Position *position = blocks[b]->column<Position>();
+		Hue *hue = blocks[b]->column<Hue>();
+		for (i = 0; i < blocks[b]->getSize(); i++)
+			runStart[keyOf(int(hue[i].clr), cellOf(position[i].pos[1]) - originRow,
+						   cellOf(position[i].pos[0]) - originColumn) + 1]++;
+	}
+	for (i = 1; i < int(runStart.size()); i++)
+		runStart[i] += runStart[i - 1];
+
+	// File each ship at its key's cursor, which leaves every cursor at //
+	// the start of the next key; shifting them back restores the runs. //
+	slotOf.resize(nbrShips);
+	x.resize(nbrShips);
+	y.resize(nbrShips);
+	dx.resize(nbrShips);
+	dy.resize(nbrShips);
+	x0.resize(nbrShips);
+	y0.resize(nbrShips);
+	strayed.assign(nbrShips, 0);
+	nbrShips = 0;
+	for (b = 0; b < int(blocks.size()); b++)
+	{
+		Position *position = blocks[b]->column<Position>();
+		Heading *heading = blocks[b]->column<Heading>();
+		Hue *hue = blocks[b]->column<Hue>();
+		for (i = 0; i < blocks[b]->getSize(); i++, nbrShips++)
+		{
+			int s = runStart[keyOf(int(hue[i].clr), cellOf(position[i].pos[1]) - originRow,
+								   cellOf(position[i].pos[0]) - originColumn)]++;
+			slotOf[nbrShips] = s;
+			x[s] = x0[s] = position[i].pos[0];
+			y[s] = y0[s] = position[i].pos[1];
+			dx[s] = heading[i].delta[0];
+			dy[s] = heading[i].delta[1];
+		}
+	}
+	for (i = int(runStart.size()) - 1; i > 0; i--)
+		runStart[i] = runStart[i - 1];
+	runStart[0] = 0;
+	return true;
+}
+
+//////////////////////////////////////////////////////////
+// Function to push, from one ripple, the ships in grid //
+// rows firstRow up to (but not including) endRow.  A   //
+// ripple too large for any stencil is tested against   //
+// every ship in those rows.                            //
+//////////////////////////////////////////////////////////
+void StencilGrid::applyRipple(const Ripple &cir, int firstRow, int endRow)
+{
+	float intensity = 0.05f * (FINAL_RADIUS - cir.rad) / (FINAL_RADIUS - INITIAL_RADIUS);
+	int age = StencilAge(cir.rad);
+	int column = cellOf(cir.pos[0]) - originColumn;
+	int row = cellOf(cir.pos[1]) - originRow;
+	int r, b;
+
+	if (age < 0)
+	{
+		for (r = firstRow; r < endRow; r++)
+			for (b = 0; b < STENCIL_BUCKETS; b++)
+				if ( (b == int(none)) ? (cir.mask != 0) : ((cir.mask & (1 << b)) != 0) )
+					pushRun(runStart[keyOf(b, r, 0)], runStart[keyOf(b, r, nbrColumns - 1) + 1], cir, intensity, true);
+		return;
+	}
+
+	const RippleStencil &stencil = StencilForAge(age);
+	for (int i = 0; i < int(stencil.size()); i++)
+	{
+		const StencilRow &span = stencil[i];
+		int lo = max(column + span.outerLo, 0), hi = min(column + span.outerHi, nbrColumns - 1);
+		int innerLo = max(column + span.innerLo, lo), innerHi = min(column + span.innerHi, hi);
+
+		r = row + span.row;
+		if ( (r < firstRow) || (r >= endRow) || (lo > hi) )
+			continue;
+		for (b = 0; b < STENCIL_BUCKETS; b++)
+		{
+			if ( (b == int(none)) ? (cir.mask == 0) : ((cir.mask & (1 << b)) == 0) )
+				continue;
+			if (innerLo > innerHi)
+				pushRun(runStart[keyOf(b, r, lo)], runStart[keyOf(b, r, hi) + 1], cir, intensity, true);
+			else
+			{
+				pushRun(runStart[keyOf(b, r, lo)], runStart[keyOf(b, r, innerLo)], cir, intensity, true);
+				pushRun(runStart[keyOf(b, r, innerLo)], runStart[keyOf(b, r, innerHi) + 1], cir, intensity, false);
+				pushRun(runStart[keyOf(b, r, innerHi) + 1], runStart[keyOf(b, r, hi) + 1], cir, intensity, true);
+			}
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////
+// Function to write the new positions and trajectories //
+// back to rows begin up to (but not including) end of  //
+// a block whose first ship has index "firstShip".      //
+// Ships that strayed are redone from their rows (still //
+// as they began the tick) against every ripple; the    //
+// rest are normalized, as DisplaceShip would.          //
+//////////////////////////////////////////////////////////
+void StencilGrid::extract(Archetype &ships, int begin, int end, int firstShip, const vector<Ripple> &ripples)
+{
+	const Ripple *first = ripples.empty() ? NULL : &ripples[0];
+	Position *position = ships.column<Position>();
+	Heading *heading = ships.column<Heading>();
+
+	for (int i = begin; i < end; i++)
+	{
+		int s = slotOf[firstShip + i];
+		if (strayed[s])
+		{
+			Ship shp = ships.getShip(i);
+			DisplaceShip(shp, first, int(ripples.size()));
+			ships.setShip(i, shp);
+			continue;
+		}
+		position[i].pos[0] = x[s];
+		position[i].pos[1] = y[s];
+		heading[i].delta[0] = dx[s];
+		heading[i].delta[1] = dy[s];
+		Normalize(heading[i].delta);
+	}
+}
+
+///////////////////////////////////////////////////////
+// Functions to report the grid's rows, and how many //
+// ships have strayed this tick.                     //
+///////////////////////////////////////////////////////
+int StencilGrid::getRows()
+{
+	return nbrRows;
+}
+
+int StencilGrid::getStrayedCount()
+{
+	return int( count(strayed.begin(), strayed.end(), 1) );
+}
+
+//////////////////////////////////////////////////////////
+// Function to map a coordinate to its (absolute) cell, //
+// clamped so that far-off ripples cannot overflow.     //
+//////////////////////////////////////////////////////////
+int StencilGrid::cellOf(float coord)
+{
+	float cell = floor(coord / STENCIL_CELL);
+
+	if (cell < float(-STENCIL_BIAS))
+		return -STENCIL_BIAS;
+	if (cell > float(STENCIL_BIAS))
+		return STENCIL_BIAS;
+	return int(cell);
+}
+
+/////////////////////////////////////////////////////////
+// Function to index the run of one color bucket in    //
+// one cell, ordered by bucket, then row, then column. //
+/////////////////////////////////////////////////////////
+int StencilGrid::keyOf(int bucket, int row, int column)
+{
+	return (bucket * nbrRows + row) * nbrColumns + column;
+}
+
+/////////////////////////////////////////////////////////
+// Function to push the ship in slot "s" away from the //
+// ripple's center, exactly as DisplaceShip does, and  //
+// to mark it as strayed once it has drifted too far.  //
+/////////////////////////////////////////////////////////
+void StencilGrid::push(int s, const Ripple &cir, float intensity)
+{
+	float driftX, driftY;
+
+	dx[s] += intensity * (x[s] - cir.pos[0]);
+	dy[s] += intensity * (y[s] - cir.pos[1]);
+	x[s] += intensity * (x[s] - cir.pos[0]);
+	y[s] += intensity * (y[s] - cir.pos[1]);
+	driftX = x[s] - x0[s];
+	driftY = y[s] - y0[s];
+	if (driftX * driftX + driftY * driftY > STENCIL_SLACK * STENCIL_SLACK)
+		strayed[s] = 1;
+}
+
+/////////////////////////////////////////////////////////
+// Function to push the ships in slots first up to     //
+// last, testing their distance first if "test" is set //
+// (with the reference's double-precision test).       //
+/////////////////////////////////////////////////////////
+void StencilGrid::pushRun(int first, int last, const Ripple &cir, float intensity, bool test)
+{
+	for (int s = first; s < last; s++)
+	{
+		if (strayed[s])
+			continue;
+		if ( test && !( pow(cir.pos[0] - x[s], 2) + pow(cir.pos[1] - y[s], 2) < pow(cir.rad, 2) ) )
+			continue;
+		push(s, cir, intensity);
+	}
+}
+
+/////////////////////////////////////////////////////////
+// Function to return the stencil age of a radius, or  //
+// -1 if no stencil serves it.                         //
+/////////////////////////////////////////////////////////
+int StencilAge(float rad)
+{
+	float age = floor((rad - INITIAL_RADIUS) / RADIUS_INCREMENT);
+
+	if ( !(age >= 0.0f) || (age >= float(NBR_RIPPLE_AGES)) )
+		return -1;
+	return int(age);
+}
+
+/////////////////////////////////////////////////////////
+// Function to compute the stencil of one age: the     //
+// rows of cells reachable from radii between the age  //
+// and the next, and their spans covered entirely.     //
+/////////////////////////////////////////////////////////
+static RippleStencil ComputeStencil(int age)
+{
+	RippleStencil stencil;
+	float margin = STENCIL_SLACK + STENCIL_EPSILON;
+	float outer = INITIAL_RADIUS + (age + 1) * RADIUS_INCREMENT + margin;
+	float inner = INITIAL_RADIUS + age * RADIUS_INCREMENT - margin;
+	int reach = int(ceil(outer / STENCIL_CELL)) + 1;
+
+	for (int r = -reach; r <= reach; r++)
+	{
+		StencilRow span = { r, reach + 1, -reach - 1, reach + 1, -reach - 1 };
+		float nearY = max(abs(r) - 1, 0) * STENCIL_CELL, farY = (abs(r) + 1) * STENCIL_CELL;
+
+		for (int c = -reach; c <= reach; c++)
+		{
+			float nearX = max(abs(c) - 1, 0) * STENCIL_CELL, farX = (abs(c) + 1) * STENCIL_CELL;
+			if (nearX * nearX + nearY * nearY < outer * outer)
+			{
+				span.outerLo = min(span.outerLo, c);
+				span.outerHi = max(span.outerHi, c);
+			}
+			if ( (inner > 0.0f) && (farX * farX + farY * farY < inner * inner) )
+			{
+				span.innerLo = min(span.innerLo, c);
+				span.innerHi = max(span.innerHi, c);
+			}
+		}
+		if (span.outerLo <= span.outerHi)
+			stencil.push_back(span);
+	}
+	return stencil;
+}
+
+/////////////////////////////////////////////////////////
+// Function to return the stencil of one age.  All the //
+// stencils are computed together, on the first call.  //
+/////////////////////////////////////////////////////////
+const RippleStencil &StencilForAge(int age)
+{
+	static const vector<RippleStencil> stencils = []()
+	{
+		vector<RippleStencil> all;
+		for (int a = 0; a < NBR_RIPPLE_AGES; a++)
+			all.push_back(ComputeStencil(a));
+		return all;
+	}();
+
+	return stencils[age];
+}
@@ -0,0 +1,94 @@
+/////////////////////////////////////////////////////////////////
+// Class definition file: StencilGrid.h                        //
+//                                                             //
+// This file defines the StencilGrid class, a uniform grid     //
+// over the ships, and the ripple stencils walked over it.    //
+// A ripple's radius only depends on its age, so the cells it  //
+// may cover, relative to the cell holding its center, are one //
+// of NBR_RIPPLE_AGES fixed stencils, computed once.  Each      //
+// stencil row is a span of cells the ripple may reach, with   //
+// an inner span of cells it covers entirely wherever its      //
+// center lies in its cell: ships there are pushed without a   //
+// distance test, and only the boundary cells are tested.      //
+//                                                             //
+// The ships are sorted by color, then row, then column, so a  //
+// row's span of cells is one contiguous run of ships of each  //
+// color.  A ship may drift up to STENCIL_SLACK from where it  //
+// was filed, which the stencils allow for; a ship pushed      //
+// further is marked as strayed and redone against every      //
+// ripple, so the results stay exact.                          //
+/////////////////////////////////////////////////////////////////
+
+#ifndef STENCIL_GRID_H
+
+#include "Flocking.h"
+#include <vector>
+
+class Archetype;
+
+const float STENCIL_CELL		= 0.05f;	// Grid Cell Width       //
+const float STENCIL_SLACK		= 0.02f;	// Drift Before Redoing  //
+const float STENCIL_EPSILON		= 0.0001f;	// Rounding Allowance    //
+const int   STENCIL_MAX_SIDE	= 512;		// Cells Along One Side  //
+const int   STENCIL_ROW_GRAIN	= 2;		// Grid Rows Per Chunk   //
+const int   NBR_RIPPLE_AGES		= int((FINAL_RADIUS - INITIAL_RADIUS) / RADIUS_INCREMENT) + 1;
+
+//////////////////////////////////////////////////////////
+// One row of a stencil: the cells from outerLo to      //
+// outerHi may be reached, those from innerLo to        //
+// innerHi are covered entirely (none if innerLo is     //
+// greater than innerHi).  Columns are relative.        //
+//////////////////////////////////////////////////////////
+struct StencilRow
+{
+	int row;
+	int outerLo, outerHi;
+	int innerLo, innerHi;
+};
+
+typedef std::vector<StencilRow> RippleStencil;
+
+/////////////////////////////////////////////////
+// DECLARATION SECTION FOR STENCIL GRID CLASS  //
+/////////////////////////////////////////////////
+
+class StencilGrid
+{
+	public:
+		// Class constructor
+		StencilGrid();
+
+		// Member functions
+		bool build(const std::vector<Archetype *> &blocks);
+		void applyRipple(const Ripple &cir, int firstRow, int endRow);
+		void extract(Archetype &ships, int begin, int end, int firstShip, const std::vector<Ripple> &ripples);
+		int getRows();
+		int getStrayedCount();
+
+	protected:
+		// Data members
+		typedef std::vector<float, TaggedAllocator<float, shipMemory> > floatVector;
+		typedef std::vector<int, TaggedAllocator<int, indexMemory> > intVector;
+
+		int originColumn, originRow;
+		int nbrColumns, nbrRows;
+		intVector runStart;		// Per color, row and column. //
+		intVector slotOf;		// Slot of each ship index.   //
+		floatVector x, y, dx, dy, x0, y0;
+		std::vector<unsigned char> strayed;
+
+		// Member functions
+		int cellOf(float coord);
+		int keyOf(int bucket, int row, int column);
+		void push(int s, const Ripple &cir, float intensity);
+		void pushRun(int first, int last, const Ripple &cir, float intensity, bool test);
+};
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+int StencilAge(float rad);
+const RippleStencil &StencilForAge(int age);
+
+#define STENCIL_GRID_H
+#endif
@@ -0,0 +1,90 @@
+/********************************************************************/
+/* Filename: Telemetry.cpp                                          */
+/*                                                                  */
+/* The global telemetry record, its one-line summary, and the stage  */
+/* timer the tick routines mark as they go.                         */
+/********************************************************************/
+
+#include "Telemetry.h"
+#include "MemoryAccounting.h"
+#include <cstdio>			// Header File For String Formatting       //
+
+Telemetry telemetry = { 0, 0.0, 0, 0, -1, 0, 0, -1.0, -1.0 };
+static const std::chrono::steady_clock::time_point startup = std::chrono::steady_clock::now();
+thread_local StageTimer tickStages;	// The stepping thread's tick. //
+
+
+/* Function to summarize the latest telemetry in "buffer". */
+/* The I/O backlog is only shown while something writes,   */
+/* and the ripples shed only once some have been. Memory   */
+/* use follows, as live/peak kilobytes per tag ("!" marks  */
+/* a tag over its budget).  The time to the first frame   */
+/* is shown once there has been one.                       */
+void FormatTelemetry(char *buffer, int size)
+{
+	int length;
+
+	if (telemetry.involuntarySwitches < 0)
+		length = snprintf(buffer, size, "tick %ld: %.2f ms, %ld migrations",
+						  telemetry.tick, telemetry.tickMs, telemetry.migrations);
+	else
+		length = snprintf(buffer, size, "tick %ld: %.2f ms, %ld migrations, %ld preemptions",
+						  telemetry.tick, telemetry.tickMs, telemetry.migrations, telemetry.involuntarySwitches);
+	if ( (telemetry.ioBuffersInUse >= 0) && (length >= 0) && (length < size) )
+		length += snprintf(buffer + length, size - length, ", io %ld buffers, %ld stalls",
+						   telemetry.ioBuffersInUse, telemetry.ioStalls);
+	if ( (telemetry.droppedRipples > 0) && (length >= 0) && (length < size) )
+		length += snprintf(buffer + length, size - length, ", %ld ripples shed", telemetry.droppedRipples);
+	if ( (telemetry.firstFrameMs >= 0.0) && (length >= 0) && (length < size) )
+		length += snprintf(buffer + length, size - length, ", first frame %.0f ms (world %.0f ms)",
+						   telemetry.firstFrameMs, telemetry.worldReadyMs);
+	if ( (length >= 0) && (length + 2 < size) )
+	{
+		buffer[length++] = ';';
+		buffer[length++] = ' ';
+		FormatMemoryUsage(buffer + length, size - length);
+	}
+}
+
+
+/* Function to find the time since the program started. */
+double MsSinceStartup()
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startup).count();
+}
+
+
+/* Stage timer constructor: no stages yet. */
+StageTimer::StageTimer()
+{
+	begin();
+}
+
+
+/* Function to start timing a new tick. */
+void StageTimer::begin()
+{
+	count = 0;
+	last = std::chrono::steady_clock::now();
+}
+
+
+/* Function to close the current stage under "stage". */
+void StageTimer::mark(const char *stage)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	if (count < MAX_TICK_STAGES)
+	{
+		names[count] = stage;
+		ms[count] = std::chrono::duration<double, std::milli>(now - last).count();
+		count++;
+	}
+	last = now;
+}
+
+
+/* Functions to read back the stages of the latest tick. */
+int StageTimer::getCount() const				{ return count; }
+const char *StageTimer::getName(int stage) const	{ return names[stage]; }
+double StageTimer::getMs(int stage) const		{ return ms[stage]; }
@@ -0,0 +1,69 @@
+/////////////////////////////////////////////////////////////////
+// Definition file: Telemetry.h                                //
+//                                                             //
+// This file defines the per-tick telemetry record, filled in  //
+// by the timer routine after every tick and summarized in the //
+// window caption, and the stage timer that splits a tick's    //
+// time between its stages.  Startup times are measured from   //
+// the program's static initialization.                        //
+/////////////////////////////////////////////////////////////////
+
+#ifndef TELEMETRY_H
+
+#include <chrono>
+
+const int MAX_TICK_STAGES = 16;		// Stages Timed Per Tick //
+
+struct Telemetry
+{
+	long tick;					// Ticks since startup             //
+	double tickMs;				// Time spent in the last tick     //
+	long migrations;			// Pool CPU migrations, last tick  //
+	long involuntarySwitches;	// Pool preemptions (-1: unknown)  //
+	long ioBuffersInUse;		// I/O buffers in flight (-1: idle) //
+	long ioStalls;				// I/O claims refused, in total     //
+	long droppedRipples;		// Ripples shed over budget, total //
+	double worldReadyMs;		// Startup to populated world      //
+	double firstFrameMs;		// Startup to first frame, or -1   //
+};
+
+////////////////////////////////////////////////////////
+// DECLARATION SECTION FOR STAGE TIMER CLASS          //
+//                                                    //
+// Each mark closes a stage: its time runs from the   //
+// previous mark (or from begin) to this one.  Marks  //
+// beyond MAX_TICK_STAGES are dropped.                //
+////////////////////////////////////////////////////////
+
+class StageTimer
+{
+	public:
+		// Class constructor
+		StageTimer();
+
+		// Member functions
+		void begin();
+		void mark(const char *stage);
+		int getCount() const;
+		const char *getName(int stage) const;
+		double getMs(int stage) const;
+
+	protected:
+		// Data members
+		std::chrono::steady_clock::time_point last;
+		const char *names[MAX_TICK_STAGES];
+		double ms[MAX_TICK_STAGES];
+		int count;
+};
+
+extern Telemetry telemetry;
+extern thread_local StageTimer tickStages;
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+void FormatTelemetry(char *buffer, int size);
+double MsSinceStartup();
+
+#define TELEMETRY_H
+#endif
@@ -0,0 +1,411 @@
+/////////////////////////////////////////////////////////////////
+// Class implementation file: TiledWorld.cpp                   //
+//                                                             //
+// Each tick, every live ripple files itself with the existing //
+// tiles its reach (plus a drift slack) overlaps, waking them; //
+// that is a bounded block of tiles per ripple, found through  //
+// the hash map without visiting any other tile.  The awake    //
+// tiles are then stepped in parallel, and ships that crossed  //
+// a tile boundary are moved afterwards.  Ships only move when //
+// a ripple pushes them, so a sleeping tile's positions are    //
+// exact; its headings merely miss the per-tick renormalizing, //
+// which moves a normalized vector by no more than rounding.   //
+/////////////////////////////////////////////////////////////////
+
+#include "TiledWorld.h"
+#include "WorkerPool.h"
+#include "Telemetry.h"
+#include <cmath>
+using namespace std;
+
+const int TILE_KEY_BIAS = 1 << 30;	// Keeps Tile Keys Unsigned //
+const int TILE_GRAIN = 4;			// Tiles Per Pool Chunk     //
+
+/////////////////////////////////////////////////////////
+// Function to compute the column or row of a tile.    //
+/////////////////////////////////////////////////////////
+static int TileCoordinate(float value)
+{
+	return int( floor(value / TILE_SIZE) );
+}
+
+/////////////////////////////////////////////////////////
+// Default constructor: An empty world, with a camera  //
+// that sees nothing until it is set.                  //
+/////////////////////////////////////////////////////////
+TiledWorld::TiledWorld()
+{
+	nbrShips = 0;
+	camera[0] = camera[1] = camera[2] = camera[3] = 0.0f;
+}
+
+/////////////////////////////////////////////////
+// Function to remove every tile and ship.     //
+/////////////////////////////////////////////////
+void TiledWorld::clear()
+{
+	tiles.clear();
+	lookup.clear();
+	awake.clear();
+	nbrShips = 0;
+}
+
+///////////////////////////////////////////////////////////
+// Function to add a ship to the tile under its center.  //
+// Ships keep the order in which they were added.        //
+///////////////////////////////////////////////////////////
+void TiledWorld::addShip(const Ship &shp)
+{
+	fileShip(tileAt(shp.pos[0], shp.pos[1]), shp, nbrShips);
+	nbrShips++;
+}
+
+/////////////////////////////////////////////////////////
+// Function to set the camera's rectangle, which only  //
+// affects which tiles are drawn.                      //
+/////////////////////////////////////////////////////////
+void TiledWorld::setCamera(float left, float right, float bottom, float top)
+{
+	camera[0] = left;
+	camera[1] = right;
+	camera[2] = bottom;
+	camera[3] = top;
+	for (int t = 0; t < int(tiles.size()); t++)
+		tiles[t].visible = isVisible(tiles[t]);
+}
+
+/////////////////////////////////////////////////////////////
+// Function to displace the ships of every awake tile by   //
+// the (already expanded) ripples, wrapping them if the    //
+// world is a torus, then move the ships that left their   //
+// tiles.                                                  //
+/////////////////////////////////////////////////////////////
+void TiledWorld::step(const vector<Ripple> &ripples, const WorldBounds &bounds)
+{
+	int t, j;
+
+	for (t = 0; t < int(awake.size()); t++)
+	{
+		tiles[awake[t]].ripples.clear();
+		tiles[awake[t]].queued = false;
+	}
+	awake.clear();
+
+	// Each ripple wakes the existing tiles within its reach. //
+	for (j = 0; j < int(ripples.size()); j++)
+	{
+		const Ripple &cir = ripples[j];
+		float reach = cir.rad + TILE_SLACK;
+		int lowColumn = TileCoordinate(cir.pos[0] - reach), highColumn = TileCoordinate(cir.pos[0] + reach);
+		int lowRow = TileCoordinate(cir.pos[1] - reach), highRow = TileCoordinate(cir.pos[1] + reach);
+		for (int column = lowColumn; column <= highColumn; column++)
+			for (int row = lowRow; row <= highRow; row++)
+			{
+				t = findTile(column, row);
+				if (t >= 0)
+				{
+					tiles[t].ripples.push_back(j);
+					wake(t);
+				}
+			}
+	}
+
+	SimulationPool().parallelFor(int(awake.size()), TILE_GRAIN, [this, &ripples, &bounds](int begin, int end)
+	{
+		for (int k = begin; k < end; k++)
+			stepTile(tiles[awake[k]], ripples, bounds);
+	});
+
+	migrate();
+}
+
+/////////////////////////////////////////////////////////////
+// Functions to copy every ship, in the order it was       //
+// added, into the parameterized array (resized to fit)    //
+// or onto the end of the parameterized list, leaving the  //
+// world as it is.                                         //
+/////////////////////////////////////////////////////////////
+void TiledWorld::exportShips(vector<Ship> &ships)
+{
+	ships.resize(nbrShips);
+	for (int t = 0; t < int(tiles.size()); t++)
+	{
+		tile &tl = tiles[t];
+		for (int i = 0; i < int(tl.order.size()); i++)
+		{
+			Ship &shp = ships[tl.order[i]];
+			shp.pos[0] = tl.x[i];
+			shp.pos[1] = tl.y[i];
+			shp.delta[0] = tl.dx[i];
+			shp.delta[1] = tl.dy[i];
+			shp.clr = tl.clr[i];
+			shp.idle = 0;
+		}
+	}
+}
+
+void TiledWorld::exportShips(LinkedList<Ship> &shipList)
+{
+	vector<Ship> ships;
+
+	exportShips(ships);
+	for (int i = 0; i < nbrShips; i++)
+	{
+		shipList.insert( ships[i] );
+		++shipList;
+	}
+}
+
+/////////////////////////////////////////////////////////////
+// Function to move every ship, in the order it was added, //
+// onto the end of the parameterized list, emptying the    //
+// world.                                                  //
+/////////////////////////////////////////////////////////////
+void TiledWorld::extract(LinkedList<Ship> &shipList)
+{
+	exportShips(shipList);
+	clear();
+}
+
+//////////////////////////////////////////////////////
+// Functions to report the world's current extent.  //
+//////////////////////////////////////////////////////
+int TiledWorld::getShipCount()	{ return nbrShips; }
+int TiledWorld::getTileCount()	{ return int(tiles.size()); }
+int TiledWorld::getAwakeCount()	{ return int(awake.size()); }
+
+///////////////////////////////////////////////////////////
+// Function to find the tile under a point, creating it  //
+// if no ship has been there before.                     //
+///////////////////////////////////////////////////////////
+int TiledWorld::tileAt(float x, float y)
+{
+	int column = TileCoordinate(x), row = TileCoordinate(y);
+	int t = findTile(column, row);
+
+	if (t < 0)
+	{
+		tile tl;
+		tl.column = column;
+		tl.row = row;
+		tl.queued = false;
+		tl.visible = isVisible(tl);
+		t = int(tiles.size());
+		tiles.push_back(tl);
+		lookup[ ((unsigned long long)(column + TILE_KEY_BIAS) << 32) | (unsigned)(row + TILE_KEY_BIAS) ] = t;
+	}
+	return t;
+}
+
+/////////////////////////////////////////////////////
+// Function to find an existing tile, or -1.       //
+/////////////////////////////////////////////////////
+int TiledWorld::findTile(int column, int row)
+{
+	tileMap::const_iterator found =
+		lookup.find( ((unsigned long long)(column + TILE_KEY_BIAS) << 32) | (unsigned)(row + TILE_KEY_BIAS) );
+	return (found == lookup.end()) ? -1 : found->second;
+}
+
+/////////////////////////////////////////////////////
+// Function to append a ship to a tile's arrays.   //
+/////////////////////////////////////////////////////
+void TiledWorld::fileShip(int t, const Ship &shp, int order)
+{
+	tile &tl = tiles[t];
+
+	tl.x.push_back(shp.pos[0]);
+	tl.y.push_back(shp.pos[1]);
+	tl.dx.push_back(shp.delta[0]);
+	tl.dy.push_back(shp.delta[1]);
+	tl.clr.push_back(shp.clr);
+	tl.order.push_back(order);
+}
+
+//////////////////////////////////////////////////////////////
+// Function to displace the ships of one tile.  Only the    //
+// ripples filed with the tile are tried; a ship pushed     //
+// further than the slack is recomputed against them all.  //
+//////////////////////////////////////////////////////////////
+void TiledWorld::stepTile(tile &tl, const vector<Ripple> &ripples, const WorldBounds &bounds)
+{
+	const Ripple *first = ripples.empty() ? NULL : &ripples[0];
+	Ship shp;
+
+	for (int i = 0; i < int(tl.order.size()); i++)
+	{
+		shp.pos[0] = tl.x[i];
+		shp.pos[1] = tl.y[i];
+		shp.delta[0] = tl.dx[i];
+		shp.delta[1] = tl.dy[i];
+		shp.clr = tl.clr[i];
+		for (int c = 0; c < int(tl.ripples.size()); c++)
+		{
+			const Ripple &cir = ripples[tl.ripples[c]];
+			if ( cir.mask & ColorBit(shp.clr) )
+				if ( pow(cir.pos[0] - shp.pos[0], 2) + pow(cir.pos[1] - shp.pos[1], 2) < pow(cir.rad, 2) )
+				{
+					float intensity = 0.05f * (FINAL_RADIUS - cir.rad) / (FINAL_RADIUS - INITIAL_RADIUS);
+					shp.delta[0] += intensity * (shp.pos[0] - cir.pos[0]);
+					shp.delta[1] += intensity * (shp.pos[1] - cir.pos[1]);
+					shp.pos[0] += intensity * (shp.pos[0] - cir.pos[0]);
+					shp.pos[1] += intensity * (shp.pos[1] - cir.pos[1]);
+					if ( (fabs(shp.pos[0] - tl.x[i]) > TILE_SLACK) ||
+						 (fabs(shp.pos[1] - tl.y[i]) > TILE_SLACK) )
+						break;
+				}
+		}
+		if ( (fabs(shp.pos[0] - tl.x[i]) > TILE_SLACK) ||
+			 (fabs(shp.pos[1] - tl.y[i]) > TILE_SLACK) )
+		{
+			shp.pos[0] = tl.x[i];
+			shp.pos[1] = tl.y[i];
+			shp.delta[0] = tl.dx[i];
+			shp.delta[1] = tl.dy[i];
+			DisplaceShip(shp, first, int(ripples.size()));
+		}
+		else
+			Normalize(shp.delta);
+		if (bounds.wrap)
+			WrapPosition(shp.pos, bounds);
+
+		tl.x[i] = shp.pos[0];
+		tl.y[i] = shp.pos[1];
+		tl.dx[i] = shp.delta[0];
+		tl.dy[i] = shp.delta[1];
+	}
+}
+
+//////////////////////////////////////////////////////////////
+// Function to move the ships of the awake tiles that now   //
+// lie outside them.  Only awake tiles can have moved ships. //
+//////////////////////////////////////////////////////////////
+void TiledWorld::migrate()
+{
+	vector<Ship> movers;
+	vector<int> moverOrder;
+
+	for (int a = 0; a < int(awake.size()); a++)
+	{
+		int t = awake[a];
+		for (int i = 0; i < int(tiles[t].order.size()); )
+		{
+			tile &tl = tiles[t];
+			if ( (TileCoordinate(tl.x[i]) == tl.column) && (TileCoordinate(tl.y[i]) == tl.row) )
+			{
+				i++;
+				continue;
+			}
+
+			Ship shp;
+			shp.pos[0] = tl.x[i];
+			shp.pos[1] = tl.y[i];
+			shp.delta[0] = tl.dx[i];
+			shp.delta[1] = tl.dy[i];
+			shp.clr = tl.clr[i];
+			shp.idle = 0;
+			movers.push_back(shp);
+			moverOrder.push_back(tl.order[i]);
+
+			// Order is carried explicitly, so the last ship fills the gap. //
+			int last = int(tl.order.size()) - 1;
+			tl.x[i] = tl.x[last];		tl.x.pop_back();
+			tl.y[i] = tl.y[last];		tl.y.pop_back();
+			tl.dx[i] = tl.dx[last];		tl.dx.pop_back();
+			tl.dy[i] = tl.dy[last];		tl.dy.pop_back();
+			tl.clr[i] = tl.clr[last];	tl.clr.pop_back();
+			tl.order[i] = tl.order[last];	tl.order.pop_back();
+		}
+	}
+
+	// Filing may create tiles, so no tile reference is held here. //
+	for (int m = 0; m < int(movers.size()); m++)
+		fileShip(tileAt(movers[m].pos[0], movers[m].pos[1]), movers[m], moverOrder[m]);
+}
+
+/////////////////////////////////////////////////////
+// Function to queue a tile for this tick's step.  //
+/////////////////////////////////////////////////////
+void TiledWorld::wake(int t)
+{
+	if (!tiles[t].queued)
+	{
+		tiles[t].queued = true;
+		awake.push_back(t);
+	}
+}
+
+/////////////////////////////////////////////////////////////
+// Function to tell whether any ship of a tile could show  //
+// inside the camera's rectangle.                          //
+/////////////////////////////////////////////////////////////
+bool TiledWorld::isVisible(const tile &tl)
+{
+	float left = tl.column * TILE_SIZE - SHIP_RADIUS, right = (tl.column + 1) * TILE_SIZE + SHIP_RADIUS;
+	float bottom = tl.row * TILE_SIZE - SHIP_RADIUS, top = (tl.row + 1) * TILE_SIZE + SHIP_RADIUS;
+
+	return (right >= camera[0]) && (left <= camera[1]) && (top >= camera[2]) && (bottom <= camera[3]);
+}
+
+
+// The tiled engine's world, and its ships once stepped. //
+class TiledScratch : public EngineScratch
+{
+	public:
+		TiledWorld tiles;
+		vector<Ship> stepped;
+};
+
+/* Function to file every ship of the world into a fresh tiled */
+/* world, in order, and step it once. The rebuild is the       */
+/* engine's cost, not the tiles'; it lets a world's tick (and  */
+/* so the lockstep and fuzz harnesses) run the tile stepping.  */
+void PrepareTiled(EntityWorld &/* world */, TickContext &tick)
+{
+	TiledScratch &scratch = tick.scratchAs<TiledScratch>();
+
+	scratch.tiles.clear();
+	for (int b = 0; b < int(tick.blocks.size()); b++)
+		for (int row = 0; row < tick.blocks[b]->getSize(); row++)
+			scratch.tiles.addShip( tick.blocks[b]->getShip(row) );
+	scratch.tiles.step(tick.ripples, tick.bounds);
+	scratch.tiles.exportShips(scratch.stepped);
+}
+
+
+/* Engine reading a range of ships back from the tiles. */
+void DisplaceShipsTiled(Archetype &ships, int begin, int end, TickContext &tick)
+{
+	const vector<Ship> &stepped = tick.scratchAs<TiledScratch>().stepped;
+	Position *position = ships.column<Position>();
+	Heading *heading = ships.column<Heading>();
+	int firstShip = tick.firstShipOf(ships);
+
+	for (int i = begin; i < end; i++)
+	{
+		const Ship &shp = stepped[firstShip + i];
+		position[i].pos[0] = shp.pos[0];
+		position[i].pos[1] = shp.pos[1];
+		heading[i].delta[0] = shp.delta[0];
+		heading[i].delta[1] = shp.delta[1];
+	}
+}
+
+
+/* Function to advance a tiled world by one tick: the world */
+/* holding the ripples runs its systems (the ripples        */
+/* expand) and drops the ripples that have run their        */
+/* course, and the awake tiles are stepped by the rest,     */
+/* each followed by its ghosts on a torus.                  */
+void AdvanceTiledTick(TiledWorld &tiles, EntityWorld &world, SystemSchedule &schedule,
+					  const WorldBounds &bounds)
+{
+	TickContext &tick = schedule.getTickContext();
+
+	schedule.run(world);
+	world.expireRipples();
+	tickStages.mark("expand");
+	tick.begin(world, bounds);
+	tiles.step(tick.ripples, tick.bounds);
+	tickStages.mark("tiles");
+}
@@ -0,0 +1,120 @@
+/////////////////////////////////////////////////////////////////
+// Class definition file: TiledWorld.h                         //
+//                                                             //
+// This file defines the TiledWorld class, which splits the    //
+// plane into square tiles, each holding its own ships as      //
+// separate coordinate arrays.  Tiles exist only where ships   //
+// do, so the world may be far larger than the window.  A      //
+// tick only visits the tiles that are awake, those a live     //
+// ripple can reach; every other tile sleeps untouched, so a   //
+// tick costs in proportion to the activity rather than to the //
+// size of the world.  The camera decides which tiles are      //
+// drawn.  On a torus, ships are wrapped as they are stepped,  //
+// and the ripples passed in must already include the ghosts. //
+/////////////////////////////////////////////////////////////////
+
+#ifndef TILED_WORLD_H
+
+#include "Flocking.h"
+#include "LinkedList.h"
+#include "Simulation.h"
+#include "EntityWorld.h"
+#include <unordered_map>
+#include <vector>
+
+const float TILE_SIZE	= 0.25f;	// Tile Width           //
+const float TILE_SLACK	= 0.05f;	// Drift Before Rescan  //
+
+///////////////////////////////////////////////
+// DECLARATION SECTION FOR TILED WORLD CLASS //
+///////////////////////////////////////////////
+
+class TiledWorld
+{
+	public:
+		// Class constructor
+		TiledWorld();
+
+		// Member functions
+		void clear();
+		void addShip(const Ship &shp);
+		void setCamera(float left, float right, float bottom, float top);
+		void step(const std::vector<Ripple> &ripples, const WorldBounds &bounds);
+		void exportShips(std::vector<Ship> &ships);
+		void exportShips(LinkedList<Ship> &shipList);
+		void extract(LinkedList<Ship> &shipList);
+		template <class F> void visitVisible(F visitor);
+		int getShipCount();
+		int getTileCount();
+		int getAwakeCount();
+
+	protected:
+		// Data members
+
+		struct tile
+		{
+			int column, row;
+			std::vector<float, TaggedAllocator<float, shipMemory> > x, y, dx, dy;
+			std::vector<color, TaggedAllocator<color, shipMemory> > clr;
+			std::vector<int, TaggedAllocator<int, shipMemory> > order;		// Position in the list   //
+			std::vector<int, TaggedAllocator<int, indexMemory> > ripples;	// Ripples reaching it    //
+			bool visible;
+			bool queued;
+		};
+
+		typedef std::unordered_map<unsigned long long, int, std::hash<unsigned long long>, std::equal_to<unsigned long long>,
+								   TaggedAllocator<std::pair<const unsigned long long, int>, indexMemory> > tileMap;
+
+		std::vector<tile, TaggedAllocator<tile, indexMemory> > tiles;
+		tileMap lookup;
+		std::vector<int> awake;
+		int nbrShips;
+		float camera[4];
+
+		// Member functions
+		int tileAt(float x, float y);
+		int findTile(int column, int row);
+		void fileShip(int t, const Ship &shp, int order);
+		void stepTile(tile &t, const std::vector<Ripple> &ripples, const WorldBounds &bounds);
+		void migrate();
+		void wake(int t);
+		bool isVisible(const tile &t);
+};
+
+/////////////////////////////////////////////////////////////
+// Function to hand each ship of the visible tiles in turn //
+// to "visitor", for the window to draw them.              //
+/////////////////////////////////////////////////////////////
+template <class F>
+void TiledWorld::visitVisible(F visitor)
+{
+	Ship shp;
+
+	shp.idle = 0;
+	for (int t = 0; t < int(tiles.size()); t++)
+	{
+		tile &tl = tiles[t];
+		if (!tl.visible)
+			continue;
+		for (int i = 0; i < int(tl.order.size()); i++)
+		{
+			shp.pos[0] = tl.x[i];
+			shp.pos[1] = tl.y[i];
+			shp.delta[0] = tl.dx[i];
+			shp.delta[1] = tl.dy[i];
+			shp.clr = tl.clr[i];
+			visitor(shp);
+		}
+	}
+}
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+void PrepareTiled(EntityWorld &world, TickContext &tick);
+void DisplaceShipsTiled(Archetype &ships, int begin, int end, TickContext &tick);
+void AdvanceTiledTick(TiledWorld &tiles, EntityWorld &world, SystemSchedule &schedule,
+					  const WorldBounds &bounds);
+
+#define TILED_WORLD_H
+#endif
@@ -0,0 +1,140 @@
+/////////////////////////////////////////////////////////////////
+// Class implementation file: Watchdog.cpp                     //
+//                                                             //
+// Both dump files are written by the I/O service, so a slow   //
+// tick is not made slower by reporting it; only the report's  //
+// formatting and the checkpoint's packing happen on the tick  //
+// thread.  After a dump, further overruns are ignored for a   //
+// cooldown, so a long stall produces one dump, not a flood.   //
+/////////////////////////////////////////////////////////////////
+
+#include "Watchdog.h"
+#include "IoService.h"
+#include "Recording.h"
+#include "BinaryLog.h"
+#include <cstdio>
+#include <string>
+using namespace std;
+
+///////////////////////////////////////////////////////
+// Default constructor: Off, with no input recorded. //
+///////////////////////////////////////////////////////
+Watchdog::Watchdog()
+{
+	thresholdMs = 0.0;
+	lastDumpTick = -WATCHDOG_COOLDOWN;
+	nbrEvents = 0;
+	nextEvent = 0;
+	startShips = startRipples = 0;
+}
+
+//////////////////////////////////////////////////////////
+// Function to set the tick duration that counts as a   //
+// hitch; zero (or less) switches the watchdog off.     //
+//////////////////////////////////////////////////////////
+void Watchdog::setThreshold(double ms)
+{
+	thresholdMs = (ms > 0.0) ? ms : 0.0;
+}
+
+//////////////////////////////////////////////////
+// Function to tell whether the watchdog is on. //
+//////////////////////////////////////////////////
+bool Watchdog::isEnabled()
+{
+	return (thresholdMs > 0.0);
+}
+
+//////////////////////////////////////////////////////////
+// Function to tell whether a tick of "tickMs" would be //
+// dumped: it overran, and the cooldown has passed.     //
+//////////////////////////////////////////////////////////
+bool Watchdog::isDue(long tick, double tickMs)
+{
+	return isEnabled() && (tickMs > thresholdMs) && (tick - lastDumpTick >= WATCHDOG_COOLDOWN);
+}
+
+//////////////////////////////////////////////////////////
+// Function to add an input event to the ring, over-    //
+// writing the oldest once the ring is full.            //
+//////////////////////////////////////////////////////////
+void Watchdog::recordInput(const InputEvent &event)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	events[nextEvent] = event;
+	nextEvent = (nextEvent + 1) % WATCHDOG_EVENTS;
+	if (nbrEvents < WATCHDOG_EVENTS)
+		nbrEvents++;
+}
+
+//////////////////////////////////////////////////////////
+// Function to keep the world a tick starts from, after //
+// "tick" ticks, with the tick's input already in it.   //
+//////////////////////////////////////////////////////////
+void Watchdog::keepStart(long tick, const WorldRecord &settings, LinkedList<Ship> &shipList,
+						 LinkedList<Ripple> &circleList)
+{
+	startShips = shipList.getSize();
+	startRipples = circleList.getSize();
+	PackCheckpoint(start, tick, settings, shipList, circleList);
+}
+
+//////////////////////////////////////////////////////////////
+// Function to check a finished tick against the threshold, //
+// queueing "hitch_<tick>.txt" and "hitch_<tick>.bin" (the  //
+// world kept as the tick started) if it overran.  True is  //
+// returned when a dump was queued.                         //
+//////////////////////////////////////////////////////////////
+bool Watchdog::check(long tick, double tickMs, const char *engine, const StageTimer &stages)
+{
+	IoService &io = SharedIoService();
+	char line[192], reportPath[64], checkpointPath[64];
+	string report;
+	int stream;
+	bool queued;
+
+	if (!isDue(tick, tickMs))
+		return false;
+	lastDumpTick = tick;
+	LOG_EVENT("watchdog: tick %d took %.2f ms", tick, tickMs);
+	snprintf(reportPath, sizeof(reportPath), "hitch_%ld.txt", tick);
+	snprintf(checkpointPath, sizeof(checkpointPath), "hitch_%ld.bin", tick);
+
+	snprintf(line, sizeof(line), "Slow tick %ld: %.2f ms (threshold %.2f ms), engine %s\n",
+			 tick, tickMs, thresholdMs, engine);
+	report += line;
+	report += "Stages:";
+	for (int s = 0; s < stages.getCount(); s++)
+	{
+		snprintf(line, sizeof(line), " %s %.3f ms", stages.getName(s), stages.getMs(s));
+		report += line;
+	}
+	snprintf(line, sizeof(line), "\nShips %d, ripples %d as the tick started\nRecent input, oldest first:\n",
+			 startShips, startRipples);
+	report += line;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		for (int e = 0; e < nbrEvents; e++)
+		{
+			const InputEvent &event = events[(nextEvent - nbrEvents + e + WATCHDOG_EVENTS) % WATCHDOG_EVENTS];
+			if (event.kind == mouseInput)
+				snprintf(line, sizeof(line), "  tick %ld: click at (%.4f, %.4f)\n", event.tick, event.pos[0], event.pos[1]);
+			else
+				snprintf(line, sizeof(line), "  tick %ld: key '%c'\n", event.tick, event.key);
+			report += line;
+		}
+	}
+	snprintf(line, sizeof(line), "Checkpoint: %s, the world as the tick began (its first -replay tick re-runs it)\n",
+			 checkpointPath);
+	report += line;
+
+	stream = io.openStream(reportPath);
+	if (stream < 0)
+		return false;
+	queued = io.write(stream, report.c_str(), int(report.size()));
+	io.closeStream(stream);
+	if (start.empty())
+		return false;
+	return WriteCheckpointBytes(io, checkpointPath, start) && queued;
+}
@@ -0,0 +1,73 @@
+/////////////////////////////////////////////////////////////////
+// Class definition file: Watchdog.h                           //
+//                                                             //
+// This file defines the Watchdog class, which compares every  //
+// tick's duration with a threshold.  The input handlers feed  //
+// it their events, of which it keeps the most recent few in a //
+// ring.  While it is on, it also keeps the world each tick    //
+// starts from, its input already joined, packed as a          //
+// checkpoint.  When a tick overruns, it queues two files      //
+// through the shared I/O service: a text report of the tick   //
+// (its stage timings, ship and ripple counts, and the recent  //
+// input), and the checkpoint of the world the tick started    //
+// from, whose first -replay tick re-runs the slow one.        //
+/////////////////////////////////////////////////////////////////
+
+#ifndef WATCHDOG_H
+
+#include "Flocking.h"
+#include "LinkedList.h"
+#include "Recording.h"
+#include "Telemetry.h"
+#include <mutex>
+
+const int WATCHDOG_EVENTS	= 32;	// Input Events Kept      //
+const int WATCHDOG_COOLDOWN	= 250;	// Ticks Between Dumps    //
+
+enum inputKind { mouseInput, keyInput };
+
+//////////////////////////////////////////////////////////
+// One input event: the tick it arrived in, and either  //
+// the world position clicked or the key pressed.       //
+//////////////////////////////////////////////////////////
+struct InputEvent
+{
+	long tick;
+	inputKind kind;
+	float pos[2];
+	unsigned char key;
+};
+
+////////////////////////////////////////////
+// DECLARATION SECTION FOR WATCHDOG CLASS //
+////////////////////////////////////////////
+
+class Watchdog
+{
+	public:
+		// Class constructor
+		Watchdog();
+
+		// Member functions
+		void setThreshold(double ms);
+		bool isEnabled();
+		bool isDue(long tick, double tickMs);
+		void recordInput(const InputEvent &event);
+		void keepStart(long tick, const WorldRecord &settings, LinkedList<Ship> &shipList,
+					   LinkedList<Ripple> &circleList);
+		bool check(long tick, double tickMs, const char *engine, const StageTimer &stages);
+
+	protected:
+		// Data members
+		double thresholdMs;				// Zero: the watchdog is off. //
+		long lastDumpTick;
+		InputEvent events[WATCHDOG_EVENTS];
+		int nbrEvents;
+		int nextEvent;
+		std::mutex lock;				// Input may come from other threads. //
+		CheckpointBytes start;			// The current tick's starting world. //
+		int startShips, startRipples;
+};
+
+#define WATCHDOG_H
+#endif
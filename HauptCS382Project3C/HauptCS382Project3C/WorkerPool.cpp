@@ -0,0 +1,362 @@
+/////////////////////////////////////////////////////////////////
+// Class implementation file: WorkerPool.cpp                   //
+//                                                             //
+// Work is handed out in chunks of "grain" indices through an  //
+// atomic counter per job, so a worker delayed by the          //
+// scheduler simply takes fewer chunks.  While several jobs    //
+// are posted a worker takes one chunk at a time, from each    //
+// job in turn; while only one is, it takes chunk after chunk  //
+// without touching the lock.  A job's own thread works only   //
+// on that job.  Scheduler counters are sampled by each        //
+// thread as it finishes its share of a job; a migration is    //
+// therefore only seen when a thread is on a different CPU     //
+// than at its previous sample, which makes it a lower bound.  //
+/////////////////////////////////////////////////////////////////
+
+#include "WorkerPool.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#endif
+
+PoolConfig poolConfig = { 0, 0, -1 };	// Settings for SimulationPool. //
+
+////////////////////////////////////////////////////////////
+// Constructor: Starts the workers, pinning worker i to   //
+// the (i mod n)th of the n CPUs in the mask, if any,     //
+// less the render thread's CPU.                          //
+////////////////////////////////////////////////////////////
+WorkerPool::WorkerPool(const PoolConfig &config)
+{
+	int nbrWorkers = config.nbrWorkers;
+	unsigned long long mask = WorkerCpuMask(config);
+	threadCounters initial = { -1, 0, -1, 0 };
+
+	if (nbrWorkers <= 0)
+		nbrWorkers = int(std::thread::hardware_concurrency()) - 1;
+	if (nbrWorkers < 0)
+		nbrWorkers = 0;
+
+	nbrJobs.store(0);
+	nextJob = 0;
+	stopping = false;
+	counters.assign(nbrWorkers + 1, initial);
+
+	for (int w = 0; w < nbrWorkers; w++)
+	{
+		int cpu = NthCpuInMask(mask, w);
+		workers.push_back(std::thread([this, w, cpu]()
+		{
+			if (cpu >= 0)
+				PinCurrentThread(cpu);
+			workerLoop(w);
+		}));
+	}
+}
+
+//////////////////////////////////////////////
+// Destructor: Stops and joins every worker. //
+//////////////////////////////////////////////
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (int w = 0; w < int(workers.size()); w++)
+		workers[w].join();
+}
+
+//////////////////////////////////////////////////////
+// Function to report how many workers were started //
+// (not counting the thread that calls parallelFor). //
+//////////////////////////////////////////////////////
+int WorkerPool::getWorkerCount()
+{
+	return int(workers.size());
+}
+
+///////////////////////////////////////////////////////////////
+// Function to call body(begin, end) over disjoint chunks    //
+// covering [0, count), spread across the workers and the    //
+// calling thread, and return once every chunk is finished.  //
+// Any number of threads may call it at once.                //
+///////////////////////////////////////////////////////////////
+void WorkerPool::parallelFor(int count, int grain, const std::function<void (int, int)> &body)
+{
+	poolJob job;
+
+	if (grain < 1)
+		grain = 1;
+	if ( workers.empty() || (count <= grain) )
+	{
+		if (count > 0)
+			body(0, count);
+		sampleCaller();
+		return;
+	}
+
+	job.body = &body;
+	job.count = count;
+	job.grain = grain;
+	job.nextIndex.store(0);
+	job.running = 0;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		jobs.push_back(&job);
+		nbrJobs.store(int(jobs.size()));
+	}
+	wake.notify_all();
+
+	while (runChunk(job))
+		;
+	sampleCaller();
+
+	std::unique_lock<std::mutex> guard(lock);
+	retire(job);
+	finished.wait(guard, [&job]() { return job.running == 0; });
+}
+
+//////////////////////////////////////////////////////////
+// Function to sum the scheduler counters of every pool  //
+// thread since the previous call, then reset them.      //
+//////////////////////////////////////////////////////////
+SchedulerStats WorkerPool::sampleSchedulerStats()
+{
+	SchedulerStats stats = { 0, 0 };
+	std::lock_guard<std::mutex> guard(lock);
+
+	for (int i = 0; i < int(counters.size()); i++)
+	{
+		stats.migrations += counters[i].migrations;
+		if ( (counters[i].switches < 0) || (stats.involuntarySwitches < 0) )
+			stats.involuntarySwitches = -1;
+		else
+			stats.involuntarySwitches += counters[i].switches;
+		counters[i].migrations = 0;
+		if (counters[i].switches > 0)
+			counters[i].switches = 0;
+	}
+	return stats;
+}
+
+///////////////////////////////////////////////////////////
+// Worker thread body: sleep until a job is posted, then //
+// take chunks from the posted jobs in turn, dropping    //
+// each job from the rotation once it has none left.     //
+///////////////////////////////////////////////////////////
+void WorkerPool::workerLoop(int worker)
+{
+	std::unique_lock<std::mutex> guard(lock);
+
+	while (true)
+	{
+		poolJob *job;
+		bool more;
+
+		wake.wait(guard, [this]() { return stopping || !jobs.empty(); });
+		if (stopping)
+			return;
+		nextJob = (nextJob + 1) % int(jobs.size());
+		job = jobs[nextJob];
+		job->running++;
+
+		guard.unlock();
+		do
+			more = runChunk(*job);
+		while ( more && (nbrJobs.load() == 1) );
+		if (!more)
+			sampleThread(counters[worker + 1]);
+		guard.lock();
+
+		if (!more)
+			retire(*job);
+		if (--job->running == 0)
+			finished.notify_all();
+	}
+}
+
+////////////////////////////////////////////////////////
+// Function to claim and run one chunk of a job,      //
+// returning false if its index has run past its end. //
+////////////////////////////////////////////////////////
+bool WorkerPool::runChunk(poolJob &job)
+{
+	int begin = job.nextIndex.fetch_add(job.grain);
+
+	if (begin >= job.count)
+		return false;
+	(*job.body)(begin, (begin + job.grain < job.count) ? begin + job.grain : job.count);
+	return true;
+}
+
+//////////////////////////////////////////////////////
+// Function to drop a job from the rotation, if it  //
+// is still there. The lock must be held.           //
+//////////////////////////////////////////////////////
+void WorkerPool::retire(poolJob &job)
+{
+	for (int j = 0; j < int(jobs.size()); j++)
+		if (jobs[j] == &job)
+		{
+			jobs.erase(jobs.begin() + j);
+			break;
+		}
+	nbrJobs.store(int(jobs.size()));
+}
+
+///////////////////////////////////////////////////////////
+// Function to update the calling thread's counters: a   //
+// migration if its CPU changed since the last sample,   //
+// and the growth in its involuntary context switches.   //
+///////////////////////////////////////////////////////////
+void WorkerPool::sampleThread(threadCounters &c)
+{
+	int cpu = CurrentCpu();
+	long switches = InvoluntarySwitches();
+
+	if ( (c.lastCpu >= 0) && (cpu != c.lastCpu) )
+		c.migrations++;
+	c.lastCpu = cpu;
+
+	if (switches < 0)
+		c.switches = -1;
+	else
+	{
+		if (c.lastSwitches >= 0)
+			c.switches += switches - c.lastSwitches;
+		c.lastSwitches = switches;
+	}
+}
+
+
+///////////////////////////////////////////////////////////
+// Function to sample a calling thread's counters and    //
+// add what they gained to the callers' total.           //
+///////////////////////////////////////////////////////////
+void WorkerPool::sampleCaller()
+{
+	static thread_local threadCounters caller = { -1, 0, -1, 0 };
+	std::lock_guard<std::mutex> guard(lock);
+
+	sampleThread(caller);
+	counters[0].migrations += caller.migrations;
+	if ( (caller.switches < 0) || (counters[0].switches < 0) )
+		counters[0].switches = -1;
+	else
+		counters[0].switches += caller.switches;
+	caller.migrations = 0;
+	if (caller.switches > 0)
+		caller.switches = 0;
+}
+
+
+/* Function to return the index of the nth set bit of a CPU */
+/* mask, wrapping around when n exceeds the number of set   */
+/* bits, or -1 for an empty mask.                           */
+int NthCpuInMask(unsigned long long mask, int n)
+{
+	int nbrSet = 0, cpu;
+
+	for (cpu = 0; cpu < MAX_POOL_CPUS; cpu++)
+		if (mask & (1ULL << cpu))
+			nbrSet++;
+	if (nbrSet == 0)
+		return -1;
+
+	n %= nbrSet;
+	for (cpu = 0; cpu < MAX_POOL_CPUS; cpu++)
+		if ( (mask & (1ULL << cpu)) && (n-- == 0) )
+			return cpu;
+	return -1;
+}
+
+
+/* Function to return the CPUs the workers may be pinned to:  */
+/* the configured mask (or, if a render CPU is chosen and the */
+/* mask is zero, every CPU) less the render CPU.  Zero means  */
+/* the workers go unpinned.                                   */
+unsigned long long WorkerCpuMask(const PoolConfig &config)
+{
+	unsigned long long mask = config.cpuMask;
+	int nbrCpus = int(std::thread::hardware_concurrency());
+
+	if ( (config.renderCpu < 0) || (config.renderCpu >= MAX_POOL_CPUS) )
+		return mask;
+	if (mask == 0)
+		for (int cpu = 0; (cpu < nbrCpus) && (cpu < MAX_POOL_CPUS); cpu++)
+			mask |= 1ULL << cpu;
+	return mask & ~(1ULL << config.renderCpu);
+}
+
+
+/* Function to return the pool the simulation engines share, */
+/* starting it with the global poolConfig on first use.      */
+WorkerPool &SimulationPool()
+{
+	static WorkerPool pool(poolConfig);
+	return pool;
+}
+
+
+#ifdef _WIN32
+
+/* Function to restrict the calling thread to a single CPU; */
+/* false if the CPU is past the affinity mask's bits.       */
+bool PinCurrentThread(int cpu)
+{
+	if ( (cpu < 0) || (cpu >= int(sizeof(DWORD_PTR) * 8)) )
+		return false;
+	return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+}
+
+/* Function to return the CPU the calling thread is on. */
+int CurrentCpu()
+{
+	return int(GetCurrentProcessorNumber());
+}
+
+/* Windows keeps no per-thread count of involuntary */
+/* context switches, so none can be reported.       */
+long InvoluntarySwitches()
+{
+	return -1;
+}
+
+#else
+
+/* Function to restrict the calling thread to a single CPU; */
+/* false if the CPU is past the CPU set's bits.             */
+bool PinCurrentThread(int cpu)
+{
+	cpu_set_t set;
+
+	if ( (cpu < 0) || (cpu >= CPU_SETSIZE) )
+		return false;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+/* Function to return the CPU the calling thread is on. */
+int CurrentCpu()
+{
+	return sched_getcpu();
+}
+
+/* Function to return the calling thread's running total */
+/* of involuntary context switches.                      */
+long InvoluntarySwitches()
+{
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_THREAD, &usage) != 0)
+		return -1;
+	return long(usage.ru_nivcsw);
+}
+
+#endif
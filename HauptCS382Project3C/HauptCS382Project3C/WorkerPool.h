@@ -0,0 +1,130 @@
+/////////////////////////////////////////////////////////////////
+// Class definition file: WorkerPool.h                         //
+//                                                             //
+// This file defines the WorkerPool class, a fixed set of      //
+// worker threads that split a range of indices between them   //
+// (the calling thread takes a share too).  The pool is        //
+// configured once, before its first use: how many workers to  //
+// start, which CPUs they may be pinned to, and whether the    //
+// render thread gets a CPU of its own.  Each worker also      //
+// samples its scheduler statistics, so that migrations and    //
+// involuntary context switches can be reported per tick.      //
+//                                                             //
+// Any number of threads may post jobs at once (the sessions   //
+// of a host, say, each stepping its own world); the workers   //
+// then take their chunks from the jobs in turn, so a large    //
+// job cannot hold the pool while smaller ones wait.           //
+/////////////////////////////////////////////////////////////////
+
+#ifndef WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+const int MAX_POOL_CPUS = 64;	// Bits In A CPU Mask //
+
+////////////////////////////////////////////////////////
+// Pool settings: zero workers means one per hardware //
+// thread (less the caller), a zero mask leaves the   //
+// workers unpinned, and a negative render CPU leaves //
+// the render thread wherever the scheduler puts it.  //
+// A render CPU is kept out of the workers' mask (a   //
+// zero mask then stands for every other CPU).        //
+////////////////////////////////////////////////////////
+struct PoolConfig
+{
+	int nbrWorkers;
+	unsigned long long cpuMask;
+	int renderCpu;
+};
+
+//////////////////////////////////////////////////////////
+// Scheduler counters summed over the pool's threads    //
+// since the previous sample; -1 marks a counter the    //
+// platform cannot provide.                             //
+//////////////////////////////////////////////////////////
+struct SchedulerStats
+{
+	long migrations;
+	long involuntarySwitches;
+};
+
+//////////////////////////////////////////////////////
+// DECLARATION SECTION FOR WORKER POOL CLASS        //
+//////////////////////////////////////////////////////
+
+class WorkerPool
+{
+	public:
+		// Class constructor and destructor
+		WorkerPool(const PoolConfig &config);
+		~WorkerPool();
+
+		// Member functions
+		int getWorkerCount();
+		void parallelFor(int count, int grain, const std::function<void (int, int)> &body);
+		SchedulerStats sampleSchedulerStats();
+
+	protected:
+		// Data members
+
+		struct threadCounters
+		{
+			int lastCpu;
+			long migrations;
+			long lastSwitches;
+			long switches;
+		};
+
+		// A posted job: its body, range and grain, the next index  //
+		// to claim, and how many workers are inside one of its     //
+		// chunks (guarded by the lock).                            //
+		struct poolJob
+		{
+			const std::function<void (int, int)> *body;
+			int count;
+			int grain;
+			std::atomic<int> nextIndex;
+			int running;
+		};
+
+		std::vector<std::thread> workers;
+		std::vector<threadCounters> counters;	// [0] sums the calling threads.
+		std::mutex lock;
+		std::condition_variable wake;
+		std::condition_variable finished;
+		std::vector<poolJob *> jobs;			// Posted jobs with chunks left.
+		std::atomic<int> nbrJobs;
+		int nextJob;
+		bool stopping;
+
+		// Member functions
+		void workerLoop(int worker);
+		bool runChunk(poolJob &job);
+		void retire(poolJob &job);
+		void sampleThread(threadCounters &c);
+		void sampleCaller();
+
+	private:
+		// Pools own threads, so they are never copied.
+		WorkerPool(const WorkerPool &pool);
+};
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+bool PinCurrentThread(int cpu);
+int NthCpuInMask(unsigned long long mask, int n);
+unsigned long long WorkerCpuMask(const PoolConfig &config);
+int CurrentCpu();
+long InvoluntarySwitches();
+WorkerPool &SimulationPool();
+
+extern PoolConfig poolConfig;
+
+#define WORKER_POOL_H
+#endif
@@ -0,0 +1,295 @@
+/********************************************************************/
+/* Filename: Workload.cpp                                           */
+/*                                                                  */
+/* The population shapes and ripple patterns, and the generators    */
+/* that run them in parallel. Ships are written straight into the   */
+/* world's plain ship archetype, a block of GENERATOR_BLOCK rows    */
+/* per task; ripple events are generated a tick per task, into      */
+/* slots laid out in advance. Ships that a shape would place        */
+/* outside the world are clamped to its edge.                       */
+/********************************************************************/
+
+#include "Workload.h"
+#include "Simulation.h"
+#include "WorkerPool.h"
+#include <cstring>
+using namespace std;
+
+const unsigned int RIPPLE_STREAM = 0x5250504c;	// Keeps Ripple Streams Apart //
+
+
+/* Function to keep a generated position inside the world. */
+static void ClampToWorld(float pos[], const WorkloadLayout &layout)
+{
+	float half[2] = { 0.5f * layout.width, 0.5f * layout.height };
+
+	for (int i = 0; i <= 1; i++)
+		pos[i] = (pos[i] < -half[i]) ? -half[i] : ((pos[i] > half[i]) ? half[i] : pos[i]);
+}
+
+
+/* Function to give a ship a random trajectory and color, */
+/* as InitShips does.                                      */
+static void RandomHeading(Ship &shp, mt19937 &rng)
+{
+	uniform_real_distribution<float> drift(MIN_SHIP_DELTA, MAX_SHIP_DELTA);
+	uniform_int_distribution<int> hue(0, NBR_COLORS - 1);
+
+	shp.delta[0] = drift(rng);
+	shp.delta[1] = drift(rng);
+	Normalize(shp.delta);
+	shp.clr = color(hue(rng));
+	shp.idle = 0;
+}
+
+
+/* Shape: ships scattered evenly, as InitShips scatters them. */
+static void PlaceUniform(Ship &shp, const WorkloadLayout &layout, mt19937 &rng)
+{
+	uniform_real_distribution<float> across(-0.5f * layout.width, 0.5f * layout.width);
+	uniform_real_distribution<float> down(-0.5f * layout.height, 0.5f * layout.height);
+
+	shp.pos[0] = across(rng);
+	shp.pos[1] = down(rng);
+	RandomHeading(shp, rng);
+}
+
+
+/* Shape: Gaussian blobs around the hubs, each its own size. */
+static void PlaceBlob(Ship &shp, const WorkloadLayout &layout, mt19937 &rng)
+{
+	int hub = uniform_int_distribution<int>(0, WORKLOAD_HUBS - 1)(rng);
+	normal_distribution<float> spread(0.0f, layout.spans[hub]);
+
+	shp.pos[0] = layout.centers[hub][0] + spread(rng);
+	shp.pos[1] = layout.centers[hub][1] + spread(rng);
+	ClampToWorld(shp.pos, layout);
+	RandomHeading(shp, rng);
+}
+
+
+/* Shape: ships packed along the segments from the hubs */
+/* to the far ends, barely LINE_WIDTH across.           */
+static void PlaceLine(Ship &shp, const WorkloadLayout &layout, mt19937 &rng)
+{
+	int hub = uniform_int_distribution<int>(0, WORKLOAD_HUBS - 1)(rng);
+	float along = uniform_real_distribution<float>(0.0f, 1.0f)(rng);
+	normal_distribution<float> across(0.0f, LINE_WIDTH);
+
+	for (int i = 0; i <= 1; i++)
+		shp.pos[i] = layout.centers[hub][i] + along * (layout.ends[hub][i] - layout.centers[hub][i]) + across(rng);
+	ClampToWorld(shp.pos, layout);
+	RandomHeading(shp, rng);
+}
+
+
+/* Shape: thin rings around the hubs, three spans out. */
+static void PlaceRing(Ship &shp, const WorkloadLayout &layout, mt19937 &rng)
+{
+	int hub = uniform_int_distribution<int>(0, WORKLOAD_HUBS - 1)(rng);
+	float angle = uniform_real_distribution<float>(0.0f, 360.0f * PI_OVER_180)(rng);
+	float radius = 3.0f * layout.spans[hub] + normal_distribution<float>(0.0f, RING_WIDTH)(rng);
+
+	shp.pos[0] = layout.centers[hub][0] + radius * cos(angle);
+	shp.pos[1] = layout.centers[hub][1] + radius * sin(angle);
+	ClampToWorld(shp.pos, layout);
+	RandomHeading(shp, rng);
+}
+
+
+/* Shape: even scatter, but every ship the flood's color, */
+/* so every ripple of that color reaches every ship.      */
+static void PlaceFlood(Ship &shp, const WorkloadLayout &layout, mt19937 &rng)
+{
+	PlaceUniform(shp, layout, rng);
+	shp.clr = layout.flood;
+}
+
+
+/* Shape: hubs whose density falls off as a power of the   */
+/* distance, hub k drawing a share proportional to 1/(k+1). */
+/* The mass within r of a hub grows as r^(2 - exponent).    */
+static void PlacePowerLaw(Ship &shp, const WorkloadLayout &layout, mt19937 &rng)
+{
+	static const float weightTotal = []()
+	{
+		float total = 0.0f;
+		for (int k = 0; k < WORKLOAD_HUBS; k++)
+			total += 1.0f / (k + 1);
+		return total;
+	}();
+	float pick = uniform_real_distribution<float>(0.0f, weightTotal)(rng);
+	float reach = 0.5f * ((layout.width < layout.height) ? layout.width : layout.height);
+	float angle = uniform_real_distribution<float>(0.0f, 360.0f * PI_OVER_180)(rng);
+	float radius = reach * pow(uniform_real_distribution<float>(0.0f, 1.0f)(rng), 1.0f / (2.0f - POWER_LAW_EXPONENT));
+	int hub = 0;
+
+	while ( (hub < WORKLOAD_HUBS - 1) && (pick >= 1.0f / (hub + 1)) )
+		pick -= 1.0f / (1 + hub++);
+	shp.pos[0] = layout.centers[hub][0] + radius * cos(angle);
+	shp.pos[1] = layout.centers[hub][1] + radius * sin(angle);
+	ClampToWorld(shp.pos, layout);
+	RandomHeading(shp, rng);
+}
+
+
+/* Function to give a ripple a random color (the invisible */
+/* one included) at its initial radius.                    */
+static void RandomRipple(Ripple &cir, mt19937 &rng)
+{
+	cir.rad = INITIAL_RADIUS;
+	cir.setColor( color(uniform_int_distribution<int>(0, NBR_COLORS)(rng)) );
+}
+
+
+/* Pattern: ripples falling anywhere. */
+static void AimRain(Ripple &cir, float /* progress */, const WorkloadLayout &layout, mt19937 &rng)
+{
+	cir.pos[0] = uniform_real_distribution<float>(-0.5f * layout.width, 0.5f * layout.width)(rng);
+	cir.pos[1] = uniform_real_distribution<float>(-0.5f * layout.height, 0.5f * layout.height)(rng);
+	RandomRipple(cir, rng);
+}
+
+
+/* Pattern: ripples bunched on the first hub, where the */
+/* blobs, rings and power-law shapes are densest.       */
+static void AimHotspot(Ripple &cir, float /* progress */, const WorkloadLayout &layout, mt19937 &rng)
+{
+	normal_distribution<float> spread(0.0f, HOTSPOT_SPREAD * ((layout.width < layout.height) ? layout.width : layout.height));
+
+	cir.pos[0] = layout.centers[0][0] + spread(rng);
+	cir.pos[1] = layout.centers[0][1] + spread(rng);
+	RandomRipple(cir, rng);
+}
+
+
+/* Pattern: ripples along a vertical front that crosses */
+/* the world from left to right over the run.           */
+static void AimSweep(Ripple &cir, float progress, const WorkloadLayout &layout, mt19937 &rng)
+{
+	cir.pos[0] = layout.width * (progress - 0.5f);
+	cir.pos[1] = uniform_real_distribution<float>(-0.5f * layout.height, 0.5f * layout.height)(rng);
+	RandomRipple(cir, rng);
+}
+
+
+////////////////////////////////////////////////////////
+// The shapes and patterns, selectable by name.       //
+////////////////////////////////////////////////////////
+const PopulationShape POPULATION_SHAPES[] = { { "uniform",	PlaceUniform },
+											  { "blobs",	PlaceBlob },
+											  { "lines",	PlaceLine },
+											  { "rings",	PlaceRing },
+											  { "flood",	PlaceFlood },
+											  { "powerlaw",	PlacePowerLaw } };
+const int NBR_POPULATION_SHAPES = sizeof(POPULATION_SHAPES) / sizeof(POPULATION_SHAPES[0]);
+
+const RipplePattern RIPPLE_PATTERNS[] = { { "rain",		AimRain },
+										  { "hotspot",	AimHotspot },
+										  { "sweep",	AimSweep } };
+const int NBR_RIPPLE_PATTERNS = sizeof(RIPPLE_PATTERNS) / sizeof(RIPPLE_PATTERNS[0]);
+
+
+/* Functions to look a shape or pattern up by name, */
+/* returning NULL if there is none by that name.    */
+const PopulationShape *FindPopulationShape(const char *name)
+{
+	for (int i = 0; i < NBR_POPULATION_SHAPES; i++)
+		if (strcmp(POPULATION_SHAPES[i].name, name) == 0)
+			return &POPULATION_SHAPES[i];
+	return NULL;
+}
+
+const RipplePattern *FindRipplePattern(const char *name)
+{
+	for (int i = 0; i < NBR_RIPPLE_PATTERNS; i++)
+		if (strcmp(RIPPLE_PATTERNS[i].name, name) == 0)
+			return &RIPPLE_PATTERNS[i];
+	return NULL;
+}
+
+
+/* Function to lay out a workload from its seed: the hubs sit */
+/* anywhere in the middle four fifths of the world, with      */
+/* spans between BLOB_SPREAD's bounds (as shares of the short */
+/* side) and lines that end anywhere in the world.            */
+void MakeWorkloadLayout(WorkloadLayout &layout, float width, float height, unsigned int seed)
+{
+	mt19937 rng(seed);
+	float side = (width < height) ? width : height;
+	uniform_real_distribution<float> across(-0.4f * width, 0.4f * width);
+	uniform_real_distribution<float> down(-0.4f * height, 0.4f * height);
+	uniform_real_distribution<float> span(BLOB_SPREAD[0] * side, BLOB_SPREAD[1] * side);
+
+	layout.width = width;
+	layout.height = height;
+	for (int k = 0; k < WORKLOAD_HUBS; k++)
+	{
+		layout.centers[k][0] = across(rng);
+		layout.centers[k][1] = down(rng);
+		layout.spans[k] = span(rng);
+		layout.ends[k][0] = 1.25f * across(rng);
+		layout.ends[k][1] = 1.25f * down(rng);
+	}
+	layout.flood = color(uniform_int_distribution<int>(0, NBR_COLORS - 1)(rng));
+}
+
+
+/* Function to add "nbrShips" ships of the given shape to the */
+/* world's plain ship archetype. Block b of GENERATOR_BLOCK   */
+/* ships draws from a stream seeded by (seed, b), and blocks  */
+/* are generated in parallel.                                 */
+void GeneratePopulation(EntityWorld &world, const PopulationShape &shape, int nbrShips,
+						const WorkloadLayout &layout, unsigned int seed)
+{
+	Archetype &archetype = world.archetypeFor(SHIP_COMPONENTS);
+	int first = archetype.appendRows(nbrShips);
+	int nbrBlocks = (nbrShips + GENERATOR_BLOCK - 1) / GENERATOR_BLOCK;
+
+	SimulationPool().parallelFor(nbrBlocks, 1, [&archetype, &shape, &layout, first, nbrShips, seed](int begin, int end)
+	{
+		for (int b = begin; b < end; b++)
+		{
+			seed_seq streamSeed = { seed, (unsigned int)b };
+			mt19937 rng(streamSeed);
+			int last = (b + 1) * GENERATOR_BLOCK;
+
+			for (int i = b * GENERATOR_BLOCK; i < ((last < nbrShips) ? last : nbrShips); i++)
+			{
+				Ship shp;
+				shape.place(shp, layout, rng);
+				archetype.setShip(first + i, shp);
+			}
+		}
+	});
+}
+
+
+/* Function to fill "events" with "perTick" ripples of the   */
+/* pattern on each of ticks 1 to nbrTicks, in tick order.     */
+/* Each tick draws from its own stream, and ticks are        */
+/* generated in parallel.                                    */
+void GenerateRipplePattern(vector<RippleEvent> &events, const RipplePattern &pattern, long nbrTicks,
+						   int perTick, const WorkloadLayout &layout, unsigned int seed)
+{
+	size_t first = events.size();
+
+	if ( (nbrTicks <= 0) || (perTick <= 0) )
+		return;
+	events.resize(first + size_t(nbrTicks) * perTick);
+	SimulationPool().parallelFor(int(nbrTicks), 1, [&events, &pattern, &layout, first, nbrTicks, perTick, seed](int begin, int end)
+	{
+		for (int t = begin; t < end; t++)
+		{
+			seed_seq streamSeed = { seed, RIPPLE_STREAM, (unsigned int)t };
+			mt19937 rng(streamSeed);
+
+			for (int r = 0; r < perTick; r++)
+			{
+				RippleEvent &event = events[first + size_t(t) * perTick + r];
+				event.tick = t + 1;
+				pattern.aim(event.ripple, float(t) / nbrTicks, layout, rng);
+			}
+		}
+	});
+}
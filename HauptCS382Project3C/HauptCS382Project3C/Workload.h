@@ -0,0 +1,88 @@
+/////////////////////////////////////////////////////////////////
+// Definition file: Workload.h                                 //
+//                                                             //
+// This file declares the synthetic workloads for benchmarks:  //
+// ship populations of several shapes and ripple streams of    //
+// several patterns, chosen by name like the engines.  Uniform //
+// scatter flatters a spatial index, so the shapes crowd the   //
+// ships instead: Gaussian blobs, dense lines, rings, a flood  //
+// of one color, and hubs whose density falls off as a power   //
+// of the distance.  The patterns are random rain, a hotspot   //
+// on the first hub, and a front sweeping across the world.    //
+//                                                             //
+// A workload's layout (where its hubs are) comes from the     //
+// seed alone, and ships and ripples are generated in blocks,  //
+// each from its own stream seeded by the seed and the block,  //
+// so the same seed gives the same workload however many       //
+// workers generate it.                                        //
+/////////////////////////////////////////////////////////////////
+
+#ifndef WORKLOAD_H
+
+#include "Flocking.h"
+#include "StateHash.h"
+#include "EntityWorld.h"
+#include <random>
+#include <vector>
+
+const int   WORKLOAD_HUBS		= 8;		// Blobs, Lines Or Rings   //
+const int   GENERATOR_BLOCK		= 4096;		// Ships Per Random Stream //
+const float BLOB_SPREAD[2]		= { 0.02f, 0.08f };	// Blob Deviation, Of Side //
+const float LINE_WIDTH			= 0.004f;	// Deviation Across A Line //
+const float RING_WIDTH			= 0.003f;	// Deviation Across A Ring //
+const float POWER_LAW_EXPONENT	= 1.5f;		// Density ~ 1 / r^This    //
+const float HOTSPOT_SPREAD		= 0.03f;	// Hotspot Deviation, Of Side //
+
+//////////////////////////////////////////////////////////
+// Where a workload's ships and ripples gather: the     //
+// world's size, the hubs' centers and extents, the far //
+// ends of the lines, and the color of a flood.         //
+//////////////////////////////////////////////////////////
+struct WorkloadLayout
+{
+	float width, height;
+	float centers[WORKLOAD_HUBS][2];
+	float spans[WORKLOAD_HUBS];
+	float ends[WORKLOAD_HUBS][2];
+	color flood;
+};
+
+//////////////////////////////////////////////////////////
+// A population shape places one ship; a ripple pattern //
+// aims one ripple, given how far through the run it is //
+// (from 0 to 1).  Both draw from the stream they are   //
+// handed and nothing else.                             //
+//////////////////////////////////////////////////////////
+typedef void (*ShipPlacer)(Ship &shp, const WorkloadLayout &layout, std::mt19937 &rng);
+typedef void (*RippleAimer)(Ripple &cir, float progress, const WorkloadLayout &layout, std::mt19937 &rng);
+
+struct PopulationShape
+{
+	const char *name;
+	ShipPlacer place;
+};
+
+struct RipplePattern
+{
+	const char *name;
+	RippleAimer aim;
+};
+
+extern const PopulationShape POPULATION_SHAPES[];
+extern const int NBR_POPULATION_SHAPES;
+extern const RipplePattern RIPPLE_PATTERNS[];
+extern const int NBR_RIPPLE_PATTERNS;
+
+/////////////////////////
+// Function Prototypes //
+/////////////////////////
+const PopulationShape *FindPopulationShape(const char *name);
+const RipplePattern *FindRipplePattern(const char *name);
+void MakeWorkloadLayout(WorkloadLayout &layout, float width, float height, unsigned int seed);
+void GeneratePopulation(EntityWorld &world, const PopulationShape &shape, int nbrShips,
+						const WorkloadLayout &layout, unsigned int seed);
+void GenerateRipplePattern(std::vector<RippleEvent> &events, const RipplePattern &pattern, long nbrTicks,
+						   int perTick, const WorkloadLayout &layout, unsigned int seed);
+
+#define WORKLOAD_H
+#endif